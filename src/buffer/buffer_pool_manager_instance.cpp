@@ -32,6 +32,12 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
+  // a database that already has pages allocates after them, the first id past the file that maps to this instance
+  const page_id_t num_pages = disk_manager_->GetNumPages();
+  const auto stride = static_cast<page_id_t>(num_instances_);
+  if (num_pages > next_page_id_) {
+    next_page_id_ += (num_pages - next_page_id_ + stride - 1) / stride * stride;
+  }
   // We allocate a consecutive memory space for the buffer pool.
   pages_ = new Page[pool_size_];
   replacer_ = new LRUReplacer(pool_size);
@@ -49,10 +55,10 @@ BufferPoolManagerInstance::~BufferPoolManagerInstance() {
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   // Make sure you call DiskManager::WritePage!
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id_t frame_id = page_table_[page_id];
-    disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t frame_id = WaitForLoad(&lock, page_id);
+  if (frame_id != -1) {
+    WriteBackFrame(frame_id);
     return true;
   }
   return false;
@@ -60,11 +66,11 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
   // You can do it!
-  std::lock_guard<std::mutex> lock(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
   for (page_id_t page_id = instance_index_; page_id < next_page_id_; page_id += num_instances_) {
-    if (page_table_.find(page_id) != page_table_.end()) {
-      frame_id_t frame_id = page_table_[page_id];
-      disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+    frame_id_t frame_id = WaitForLoad(&lock, page_id);
+    if (frame_id != -1) {
+      WriteBackFrame(frame_id);
     }
   }
 }
@@ -88,6 +94,7 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
   p->pin_count_ = 1;
   // new page need to write back even it is all space.
   p->is_dirty_ = true;
+  p->rec_lsn_ = CleanRecLSN();
   p->ResetMemory();
   page_table_[new_page_id] = frame_id;
   replacer_->Pin(frame_id);
@@ -104,7 +111,7 @@ void BufferPoolManagerInstance::FindUseableFrame(frame_id_t* frame_id) {
     replacer_->Victim(frame_id);
     // this frame will be used by new page, so flush it
     if (pages_[*frame_id].IsDirty()) {
-      disk_manager_->WritePage(pages_[*frame_id].page_id_, pages_[*frame_id].GetData());
+      WriteBackFrame(*frame_id);
     }
     page_table_.erase(pages_[*frame_id].page_id_);
   }
@@ -116,10 +123,14 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
   //        Note that pages are always found from the free list first.
   // auto old = replacer_->Size();
-  std::lock_guard<std::mutex> lock(latch_);
-  frame_id_t frame_id;
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id = page_table_[page_id];
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t frame_id = WaitForLoad(&lock, page_id);
+  if (frame_id != -1) {
+    // a clean page nobody holds cannot carry a change older than the next record, so whoever dirties it from here
+    // on is the first writer the recLSN has to cover
+    if (pages_[frame_id].pin_count_ == 0 && !pages_[frame_id].is_dirty_) {
+      pages_[frame_id].rec_lsn_ = CleanRecLSN();
+    }
     pages_[frame_id].pin_count_ += 1;
     replacer_->Pin(frame_id);
     return &pages_[frame_id];
@@ -138,6 +149,7 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   p->page_id_ = page_id;
   p->pin_count_ = 1;
   p->is_dirty_ = false;
+  p->rec_lsn_ = CleanRecLSN();
   replacer_->Pin(frame_id);
   disk_manager_->ReadPage(page_id, p->data_);
   return p;
@@ -183,6 +195,81 @@ auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) ->
   return false;
 }
 
+void BufferPoolManagerInstance::WriteBackFrame(frame_id_t frame_id) {
+  Page *p = &pages_[frame_id];
+  // write-ahead logging: the log records describing this page must be on disk before the page is, also during
+  // recovery, when logging is still off but undo logs its CLRs
+  if (log_manager_ != nullptr && p->GetLSN() > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(true);
+  }
+  disk_manager_->WritePage(p->page_id_, p->GetData());
+  p->is_dirty_ = false;
+  p->rec_lsn_ = CleanRecLSN();
+}
+
+auto BufferPoolManagerInstance::CleanRecLSN() -> lsn_t {
+  return log_manager_ == nullptr ? INVALID_LSN : log_manager_->GetNextLSN();
+}
+
+void BufferPoolManagerInstance::GetDirtyPageTable(std::vector<std::pair<page_id_t, lsn_t>> *dirty_page_table) {
+  std::lock_guard<std::mutex> lock(latch_);
+  for (const auto &[page_id, frame_id] : page_table_) {
+    if (pages_[frame_id].is_dirty_) {
+      dirty_page_table->emplace_back(page_id, pages_[frame_id].rec_lsn_);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::WaitForLoad(std::unique_lock<std::mutex> *lock, page_id_t page_id) -> frame_id_t {
+  while (true) {
+    auto it = page_table_.find(page_id);
+    if (it == page_table_.end()) {
+      return -1;
+    }
+    if (loading_frames_.count(it->second) == 0) {
+      return it->second;
+    }
+    // the page may be evicted again by the time we wake up, so look it up anew
+    loaded_cv_.wait(*lock);
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  for (page_id_t page_id : page_ids) {
+    // the frame is claimed and published under the latch, but read without it, so that fetches from the foreground
+    // only wait for the prefetch when they need the very page being read
+    frame_id_t frame_id;
+    Page *p;
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      if (page_table_.find(page_id) != page_table_.end()) {
+        continue;
+      }
+      if (free_list_.empty() && replacer_->Size() == 0) {
+        return;
+      }
+      FindUseableFrame(&frame_id);
+      p = &pages_[frame_id];
+      page_table_[page_id] = frame_id;
+      p->page_id_ = page_id;
+      p->pin_count_ = 1;
+      p->is_dirty_ = false;
+      p->rec_lsn_ = CleanRecLSN();
+      loading_frames_.insert(frame_id);
+    }
+    disk_manager_->ReadPage(page_id, p->data_);
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      loading_frames_.erase(frame_id);
+      // unpinned once read, the page stays evictable until someone fetches it
+      if (--p->pin_count_ == 0) {
+        replacer_->Unpin(frame_id);
+      }
+    }
+    loaded_cv_.notify_all();
+  }
+}
+
 auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
   const page_id_t next_page_id = next_page_id_;
   next_page_id_ += num_instances_;
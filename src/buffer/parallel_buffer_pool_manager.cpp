@@ -12,6 +12,8 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
@@ -36,6 +38,29 @@ auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
   return pool_size_of_all_;
 }
 
+auto ParallelBufferPoolManager::IsEmpty() -> bool {
+  return std::all_of(manage_instances_.begin(), manage_instances_.end(),
+                     [](const auto &instance) { return instance->IsEmpty(); });
+}
+
+void ParallelBufferPoolManager::GetDirtyPageTable(std::vector<std::pair<page_id_t, lsn_t>> *dirty_page_table) {
+  for (auto &instance : manage_instances_) {
+    instance->GetDirtyPageTable(dirty_page_table);
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(num_instances_);
+  for (page_id_t page_id : page_ids) {
+    instance_page_ids[page_id % num_instances_].push_back(page_id);
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    if (!instance_page_ids[i].empty()) {
+      manage_instances_[i]->PrefetchPages(instance_page_ids[i]);
+    }
+  }
+}
+
 auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManager * {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
   page_id_t moded_id = page_id % num_instances_;
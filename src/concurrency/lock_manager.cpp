@@ -146,6 +146,10 @@ auto LockManager::Unlock(Transaction *txn, const RID &rid) -> bool {
     auto iter = std::find_if(que.begin(), que.end(), [&](const LockRequest &x){
       return x.txn_id_ == txn->GetTransactionId();
     });
+    // a rid the transaction never locked, e.g. one TableHeap::ApplyDelete() unlocks on commit
+    if (iter == que.end()) {
+      return false;
+    }
     que.erase(iter);
     ulk.unlock();
     lrq.cv_.notify_all();
@@ -30,9 +30,19 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
   if (txn == nullptr) {
     txn = new Transaction(next_txn_id_++, isolation_level);
   }
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetFirstLSN(lsn);
+    txn->SetPrevLSN(lsn);
+  }
   txn_map_mutex.lock();
   txn_map[txn->GetTransactionId()] = txn;
   txn_map_mutex.unlock();
+  {
+    std::scoped_lock guard(running_txns_latch_);
+    running_txns_[txn->GetTransactionId()] = txn;
+  }
   return txn;
 }
 
@@ -52,6 +62,19 @@ void TransactionManager::Commit(Transaction *txn) {
   }
   write_set->clear();
 
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(lsn);
+    // the commit is only durable once its record is
+    log_manager_->Flush(true);
+  }
+
+  {
+    std::scoped_lock guard(running_txns_latch_);
+    running_txns_.erase(txn->GetTransactionId());
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -102,6 +125,17 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(lsn);
+  }
+
+  {
+    std::scoped_lock guard(running_txns_latch_);
+    running_txns_.erase(txn->GetTransactionId());
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -112,4 +146,20 @@ void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
 
+auto TransactionManager::GetActiveTransactionTable(std::vector<std::pair<txn_id_t, lsn_t>> *active_txn_table)
+    -> lsn_t {
+  lsn_t oldest_first_lsn = INVALID_LSN;
+  std::scoped_lock guard(running_txns_latch_);
+  for (const auto &[txn_id, txn] : running_txns_) {
+    if (txn->GetFirstLSN() == INVALID_LSN) {
+      continue;
+    }
+    active_txn_table->emplace_back(txn_id, txn->GetPrevLSN());
+    if (oldest_first_lsn == INVALID_LSN || txn->GetFirstLSN() < oldest_first_lsn) {
+      oldest_first_lsn = txn->GetFirstLSN();
+    }
+  }
+  return oldest_first_lsn;
+}
+
 }  // namespace bustub
@@ -9,6 +9,7 @@
 // Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <limits>
@@ -20,25 +21,48 @@
 #include "common/logger.h"
 #include "common/rid.h"
 #include "container/hash/extendible_hash_table.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                     bool use_header_page, bool open_existing)
+    : index_name_(name),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {
   //  implement me!
-  // e 感觉应该提供一个文件夹的page id，但是既然没有那我就用默认了新建
+  BUSTUB_ASSERT(use_header_page || !open_existing, "a table is opened through the header page");
   inf_ = std::numeric_limits<page_id_t>::max();
   directory_page_id_ = inf_;
+  if (open_existing) {
+    auto header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+    header_page->RLatch();
+    bool found = header_page->GetRootId(index_name_, &directory_page_id_);
+    header_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+    BUSTUB_ASSERT(found, "no table of this name in the header page");
+    HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+    BUSTUB_ASSERT(dir_page != nullptr && dir_page->GetPageId() == directory_page_id_, "not a directory page");
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    return;
+  }
+  // e 感觉应该提供一个文件夹的page id，但是既然没有那我就用默认了新建
   // init the dir
   auto pg = buffer_pool_manager_->NewPage(&directory_page_id_);
   auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(pg->GetData());
   dir_page->SetPageId(directory_page_id_);
   // 创建一个空桶 初始时global=0，local=0？
   page_id_t new_page_id;
-  buffer_pool_manager_->NewPage(&new_page_id);
+  reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->NewPage(&new_page_id)->GetData())->Init();
   dir_page->SetBucketPageId(0, new_page_id);
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+  if (use_header_page) {
+    UpdateDirectoryPageId();
+  }
 }
 
 /*****************************************************************************
@@ -57,7 +81,7 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
+inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectory *dir_page) -> uint32_t {
   // 给定一个key，首先查到它在文件夹的哪个index
   auto glb_mask = dir_page->GetGlobalDepthMask();
   auto hash_val = Hash(key);
@@ -65,13 +89,26 @@ inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectory
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
+inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectory *dir_page) -> uint32_t {
   // 给定一个k，找到它对应的桶子 初始时，global depth等于0，他就没有桶子，这里默认桶子存在
   auto index = KeyToDirectoryIndex(key, dir_page);
-  assert(index < DIRECTORY_ARRAY_SIZE);
   return dir_page->GetBucketPageId(index);
 }
 
+/*
+ * The header page is page HEADER_PAGE_ID, see BPlusTree::UpdateRootPageId().
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::UpdateDirectoryPageId() {
+  auto header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  header_page->WLatch();
+  if (!header_page->InsertRecord(index_name_, directory_page_id_)) {
+    header_page->UpdateRecord(index_name_, directory_page_id_);
+  }
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
   // 从头开始，首先就要获得文件夹目录，是new一个么，应该是的。
@@ -87,9 +124,7 @@ auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
     return nullptr;
   }
   // 由于没有虚函数啥的，可以直接reinterpret
-  auto ret = reinterpret_cast<HashTableDirectoryPage *>(pg->GetData());
-  ret->SetPageId(directory_page_id_);
-  return ret;
+  return reinterpret_cast<HashTableDirectoryPage *>(pg->GetData());
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -104,96 +139,365 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
   return ret;
 }
 
+/*****************************************************************************
+ * OVERFLOW CHAINS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::GetChainValue(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key,
+                                    std::vector<ValueType> *result) -> bool {
+  bool found = bucket_page->GetValue(key, comparator_, result);
+  for (page_id_t page_id = bucket_page->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+    found |= overflow_page->GetValue(key, comparator_, result);
+    page_id_t next_page_id = overflow_page->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetChainValues(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType *keys, size_t num_keys,
+                                     std::vector<ValueType> *const *results) {
+  bucket_page->GetValues(keys, num_keys, comparator_, results);
+  for (page_id_t page_id = bucket_page->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+    overflow_page->GetValues(keys, num_keys, comparator_, results);
+    page_id_t next_page_id = overflow_page->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::InsertIntoChain(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key,
+                                      const ValueType &value, bool append) -> bool {
+  if (bucket_page->Insert(key, value, comparator_)) {
+    return true;
+  }
+  // the last page of the chain and the pin on it, none for the first page which the caller holds
+  HASH_TABLE_BUCKET_TYPE *last_page = bucket_page;
+  page_id_t last_page_id = INVALID_PAGE_ID;
+  bool inserted = false;
+  while (!inserted && last_page->GetOverflowPageId() != INVALID_PAGE_ID) {
+    page_id_t page_id = last_page->GetOverflowPageId();
+    HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+    if (last_page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(last_page_id, false);
+    }
+    last_page = overflow_page;
+    last_page_id = page_id;
+    inserted = overflow_page->Insert(key, value, comparator_);
+  }
+  bool dirty = inserted;
+  if (!inserted && append) {
+    page_id_t new_page_id;
+    auto new_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->NewPage(&new_page_id)->GetData());
+    new_page->Init();
+    inserted = new_page->Insert(key, value, comparator_);
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    last_page->SetOverflowPageId(new_page_id);
+    dirty = true;
+  }
+  if (last_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->UnpinPage(last_page_id, dirty);
+  }
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::RemoveFromChain(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key,
+                                      const ValueType &value) -> bool {
+  bool removed = bucket_page->Remove(key, value, comparator_);
+  if (bucket_page->GetOverflowPageId() == INVALID_PAGE_ID) {
+    return removed;
+  }
+
+  // the chain, pinned except for its first page, and the number of pairs in it
+  std::vector<std::pair<page_id_t, HASH_TABLE_BUCKET_TYPE *>> chain{{INVALID_PAGE_ID, bucket_page}};
+  uint32_t num_pairs = bucket_page->NumReadable();
+  for (page_id_t page_id = bucket_page->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    HASH_TABLE_BUCKET_TYPE *overflow_page = FetchBucketPage(page_id);
+    removed = removed || overflow_page->Remove(key, value, comparator_);
+    num_pairs += overflow_page->NumReadable();
+    chain.emplace_back(page_id, overflow_page);
+    page_id = overflow_page->GetOverflowPageId();
+  }
+
+  // fold the last page into the others, the chain holds at most one page's worth of pairs less than before
+  bool fold = num_pairs <= (chain.size() - 1) * BUCKET_ARRAY_SIZE;
+  if (fold) {
+    auto [last_page_id, last_page] = chain.back();
+    chain.pop_back();
+    size_t target = 0;
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (last_page->IsReadable(i)) {
+        while (!chain[target].second->Insert(last_page->KeyAt(i), last_page->ValueAt(i), comparator_)) {
+          target++;
+        }
+      }
+    }
+    chain.back().second->SetOverflowPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    buffer_pool_manager_->DeletePage(last_page_id);
+  }
+  for (size_t i = 1; i < chain.size(); i++) {
+    buffer_pool_manager_->UnpinPage(chain[i].first, removed || fold);
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::TakeChain(HASH_TABLE_BUCKET_TYPE *bucket_page, std::vector<MappingType> *pairs) {
+  HASH_TABLE_BUCKET_TYPE *page = bucket_page;
+  page_id_t page_id = INVALID_PAGE_ID;
+  while (true) {
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (page->IsReadable(i)) {
+        pairs->emplace_back(page->KeyAt(i), page->ValueAt(i));
+        page->SetReadable(i, false);
+      }
+    }
+    page_id_t next_page_id = page->GetOverflowPageId();
+    if (page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page_id = next_page_id;
+    page = FetchBucketPage(page_id);
+  }
+  bucket_page->SetOverflowPageId(INVALID_PAGE_ID);
+}
+
+/*
+ * The keys of a bucket agree on the low local depth bits of their hash, a
+ * split looks at the next one, and the directory has at most
+ * DIRECTORY_MAX_DEPTH bits.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::IsSeparable(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key) -> bool {
+  uint32_t hash = Hash(key);
+  uint32_t differing_bits = 0;
+  HASH_TABLE_BUCKET_TYPE *page = bucket_page;
+  page_id_t page_id = INVALID_PAGE_ID;
+  while (true) {
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (page->IsReadable(i)) {
+        differing_bits |= Hash(page->KeyAt(i)) ^ hash;
+      }
+    }
+    page_id_t next_page_id = page->GetOverflowPageId();
+    if (page_id != INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page_id = next_page_id;
+    page = FetchBucketPage(page_id);
+  }
+  return (differing_bits & ((1U << DIRECTORY_MAX_DEPTH) - 1)) != 0;
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
   table_latch_.RLock();
-  auto dir_page = FetchDirectoryPage();
-  auto page_id = KeyToPageId(key, dir_page);
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-  auto state = bucket_page->GetValue(key, comparator_, result);
+  page_id_t page_id;
+  {
+    HashTableDirectory dir(buffer_pool_manager_, directory_page_id_);
+    page_id = KeyToPageId(key, &dir);
+  }
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  page->RLatch();
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  auto state = GetChainValue(bucket_page, key, result);
+  page->RUnlatch();
   // unpin these page
   buffer_pool_manager_->UnpinPage(page_id, false);
   table_latch_.RUnlock();
   return state;
 }
 
+/*
+ * Group prefetching: the work is split into stages that each run for all the
+ * keys, so that the cache misses of one key overlap with the work on the
+ * others. The keys are hashed, then mapped to bucket pages under one pin of
+ * the directory, and sorted by bucket page. Every bucket page is then fetched
+ * once, and its flags and fingerprints are prefetched while the previous page
+ * is scanned; within a page the matching slots of all its keys are prefetched
+ * before any key is compared.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *results) {
+  size_t num_keys = keys.size();
+  results->assign(num_keys, {});
+  std::vector<uint32_t> hashes(num_keys);
+  for (size_t i = 0; i < num_keys; i++) {
+    hashes[i] = Hash(keys[i]);
+  }
+
+  table_latch_.RLock();
+  // the bucket page of every key, with the key's index
+  std::vector<std::pair<page_id_t, size_t>> probes(num_keys);
+  {
+    HashTableDirectory dir(buffer_pool_manager_, directory_page_id_);
+    uint32_t mask = dir.GetGlobalDepthMask();
+    for (size_t i = 0; i < num_keys; i++) {
+      probes[i] = {dir.GetBucketPageId(hashes[i] & mask), i};
+    }
+  }
+  std::sort(probes.begin(), probes.end());
+
+  std::vector<KeyType> bucket_keys;
+  std::vector<std::vector<ValueType> *> bucket_results;
+  Page *page = num_keys > 0 ? buffer_pool_manager_->FetchPage(probes[0].first) : nullptr;
+  for (size_t begin = 0, end; begin < num_keys; begin = end) {
+    page_id_t page_id = probes[begin].first;
+    bucket_keys.clear();
+    bucket_results.clear();
+    for (end = begin; end < num_keys && probes[end].first == page_id; end++) {
+      bucket_keys.push_back(keys[probes[end].second]);
+      bucket_results.push_back(&(*results)[probes[end].second]);
+    }
+    Page *next_page = nullptr;
+    if (end < num_keys) {
+      next_page = buffer_pool_manager_->FetchPage(probes[end].first);
+      reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(next_page->GetData())->Prefetch();
+    }
+
+    page->RLatch();
+    GetChainValues(reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData()), bucket_keys.data(), bucket_keys.size(),
+                   bucket_results.data());
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page = next_page;
+  }
+  table_latch_.RUnlock();
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+/*
+ * Under the read latch of the table, so that inserts into different buckets
+ * run side by side: only the first page of the bucket is latched. A full
+ * bucket has to be split or get another overflow page, and a split changes
+ * the directory, so the insert starts over under the write latch of the table
+ * in SplitInsert().
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
+  table_latch_.RLock();
+  page_id_t page_id;
+  {
+    HashTableDirectory dir(buffer_pool_manager_, directory_page_id_);
+    page_id = KeyToPageId(key, &dir);
+  }
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  page->WLatch();
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+
+  std::vector<ValueType> exist_val;
+  GetChainValue(bucket_page, key, &exist_val);
+  bool exists = std::find(exist_val.begin(), exist_val.end(), value) != exist_val.end();
+  bool ret = !exists && InsertIntoChain(bucket_page, key, value, false);
+  bool full = !exists && !ret;
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, ret);
+  table_latch_.RUnlock();
+  if (!full) {
+    return ret;
+  }
+
   table_latch_.WLock();
+  ret = SplitInsert(transaction, key, value);
+  table_latch_.WUnlock();
+  return ret;
+}
+
+/*
+ * Called with the write latch of the table held, which keeps out every other
+ * operation, so the bucket pages need no latches of their own. The bucket may
+ * have changed since Insert() saw it full.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   // 找到桶之后，看是否存在？是否满了？是否可以split？是否global split？
-  auto dir_page = FetchDirectoryPage();
-  uint32_t old_idx = KeyToDirectoryIndex(key, dir_page);
-  auto old_local_d = dir_page->GetLocalDepth(old_idx);
+  HashTableDirectory dir(buffer_pool_manager_, directory_page_id_);
+  auto dir_page = &dir;
   page_id_t page_id = KeyToPageId(key, dir_page);
   HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
 
   // 这样page肯定存在，先验证key value是否已经存在
   std::vector<ValueType> exist_val;
-  bucket_page->GetValue(key, comparator_, &exist_val);
+  GetChainValue(bucket_page, key, &exist_val);
   for (const auto &val : exist_val) {
     if (val == value) {
-      table_latch_.WUnlock();
+      buffer_pool_manager_->UnpinPage(page_id, false);
       return false;
     }
   }
 
   // 桶是否已满？ 如果已满，是增加全局还是局部的depth？
-  while (bucket_page->IsFull()) {
-    if (dir_page->GetGlobalDepth() == dir_page->GetLocalDepth(old_idx)) {
+  while (!InsertIntoChain(bucket_page, key, value, false)) {
+    if (!IsSeparable(bucket_page, key)) {
+      // no split would make room, so the chain grows instead of the directory
+      InsertIntoChain(bucket_page, key, value, true);
+      break;
+    }
+
+    // the bucket the key is in now, after the splits so far
+    uint32_t old_idx = KeyToDirectoryIndex(key, dir_page);
+    auto old_local_d = dir_page->GetLocalDepth(old_idx);
+    if (dir_page->GetGlobalDepth() == old_local_d) {
       // 先增全局，然后局部。  需要对元素重新摆放位置（当localdepth增加时，这个桶里的就得重新分配）？ 这里怎么增？wtf
       // 一个bucket，全局增加一位后，这个bucket可以被两个同时指向，此时局部的不变，然后重新分配，找到bucket下标
-      uint32_t glb_depth = dir_page->GetGlobalDepth();
-      uint32_t upper_index = 1 << glb_depth;
-      // 新增这一位到底是0是1，对于local暂时不影响
-      for (uint32_t cur_idx = 0; cur_idx < upper_index; cur_idx++) {
-        dir_page->SetBucketPageId(cur_idx | upper_index, dir_page->GetBucketPageId(cur_idx));
-        dir_page->SetLocalDepth(cur_idx | upper_index, old_local_d);
-      }
+      // the keys differ in a bit the directory can still reach
+      assert(dir_page->CanGrow());
       dir_page->IncrGlobalDepth();
     }
 
     // 增局部，然后判断还可能得增全局 （当localdepth增加时，这个桶里的就得重新分配）
     // 1. 首先要创建一个新的桶
-    // uint32_t new_idx = dir_page->GetSplitImageIndex(old_idx);
     page_id_t new_page_id;
     auto t = buffer_pool_manager_->NewPage(&new_page_id);
-    HASH_TABLE_BUCKET_TYPE *new_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(t);
+    HASH_TABLE_BUCKET_TYPE *new_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(t->GetData());
+    new_bucket_page->Init();
 
     // 2. 将原来桶里的值重新分配到两个桶子中，这时候直接插即可
-    for (uint32_t cur_idx = 0; cur_idx < BUCKET_ARRAY_SIZE; cur_idx++) {
-      if (bucket_page->IsReadable(cur_idx)) {
-        auto raw_key = bucket_page->KeyAt(cur_idx);
-        auto the_key = Hash(raw_key);
-        auto the_value = bucket_page->ValueAt(cur_idx);
-        if ((the_key >> old_local_d) & 1) {
-          // 删除老桶 放到新桶之中, 新桶的最后一位是1，最后重定位时
-          bucket_page->SetReadable(cur_idx, false);
-          new_bucket_page->Insert(raw_key, the_value, comparator_);
-        }
+    // the overflow pages are rebuilt for each half
+    std::vector<MappingType> pairs;
+    TakeChain(bucket_page, &pairs);
+    for (const auto &[raw_key, the_value] : pairs) {
+      if ((Hash(raw_key) >> old_local_d) & 1) {
+        InsertIntoChain(new_bucket_page, raw_key, the_value, true);
+      } else {
+        InsertIntoChain(bucket_page, raw_key, the_value, true);
       }
     }
 
     // 3. 重新配置索引（注意：可能会有多个指向同一个桶的，所以这里更新bucket要循环）, 增加local depth
+    // the slots of the bucket are the ones with its low old_local_d bits
     auto mask = (1U << old_local_d) - 1;
     uint32_t upper_index = 1 << dir_page->GetGlobalDepth();
-    for (uint32_t cur_idx = 0; cur_idx < upper_index; cur_idx++) {
-      if ((cur_idx & mask) == (old_idx & mask)) {
-        assert(dir_page->GetLocalDepth(cur_idx) == old_local_d);
-        if (((cur_idx >> old_local_d) & 1) == 1) {
-          dir_page->SetBucketPageId(cur_idx, new_page_id);
-        } else {
-          dir_page->SetBucketPageId(cur_idx, page_id);
-        }
-        dir_page->SetLocalDepth(cur_idx, old_local_d + 1);
+    for (uint32_t cur_idx = old_idx & mask; cur_idx < upper_index; cur_idx += 1U << old_local_d) {
+      assert(dir_page->GetLocalDepth(cur_idx) == old_local_d);
+      if (((cur_idx >> old_local_d) & 1) == 1) {
+        dir_page->SetBucketPageId(cur_idx, new_page_id);
+      } else {
+        dir_page->SetBucketPageId(cur_idx, page_id);
       }
+      dir_page->SetLocalDepth(cur_idx, old_local_d + 1);
     }
-    // 4. 就算这个时候也有可能会再次full，因此这段可能需要个循环，不过我暂时不想在这里处理
+    // 4. 就算这个时候也有可能会再次full
+    // if so, the loop tries again with the half the key is in
     page_id_t final_page_id = KeyToPageId(key, dir_page);
     assert(final_page_id == page_id || final_page_id == new_page_id);
     if (final_page_id == page_id) {
@@ -205,16 +509,8 @@ auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
     }
   }
 
-  auto ret = bucket_page->Insert(key, value, comparator_);
   buffer_pool_manager_->UnpinPage(page_id, true);
-  table_latch_.WUnlock();
-  return ret;
-}
-
-template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  // eh i do not use this api
-  return false;
+  return true;
 }
 
 /*****************************************************************************
@@ -223,56 +519,91 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   // 找到对应的bucket（如果存在的话，事实上它一定存在），从bucket删除，然后如果为空，调用shrink
-  table_latch_.WLock();
-  auto dir_page = FetchDirectoryPage();
-  auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
-  page_id_t page_id = KeyToPageId(key, dir_page);
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-
-  auto ret = bucket_page->Remove(key, value, comparator_);
-
-  // 找到他的另一半，问题是什么时候能合并？注意他的另一半page一定存在
-  // 首先，local depth相同。当前为空
-  if (dir_page->GetLocalDepth(bucket_idx) > 0) {
-    auto img_bucket_idx = dir_page->GetMergeImageIndex(bucket_idx);
-    auto img_page_id = dir_page->GetBucketPageId(img_bucket_idx);
-    // HASH_TABLE_BUCKET_TYPE *img_bucket_page = FetchBucketPage(img_page_id);
-    // assert(dir_page->GetLocalDepth(bucket_idx) == dir_page->GetLocalDepth(bucket_img_idx));
-
-    if (bucket_page->IsEmpty() && dir_page->GetLocalDepth(bucket_idx) == dir_page->GetLocalDepth(img_bucket_idx) &&
-        dir_page->GetLocalDepth(bucket_idx) > 0) {
-      // 合并之后，localdepth减少
-      buffer_pool_manager_->UnpinPage(page_id, true);
-      buffer_pool_manager_->DeletePage(page_id);
-      // 我觉得其实就只需要修改一下dir的table,删除老的page
-      auto old_local_d = dir_page->GetLocalDepth(bucket_idx);
-      auto mask = dir_page->GetLocalDepthMask(bucket_idx) >> 1;
-
-      dir_page->SetBucketPageId(bucket_idx, img_page_id);
-      // 修改之后global 的也可能会变化，如果每个localdepth 都小于global depth，global depth应该等于其中最大值
-      uint32_t max_glb_d = 0;
-      uint32_t upper_index = 1 << dir_page->GetGlobalDepth();
-      for (uint32_t cur_idx = 0; cur_idx < upper_index; cur_idx++) {
-        if ((cur_idx & mask) == (bucket_idx & mask)) {
-          dir_page->SetBucketPageId(cur_idx, img_page_id);
-          dir_page->SetLocalDepth(cur_idx, old_local_d - 1);
-        }
-        max_glb_d = std::max(max_glb_d, dir_page->GetLocalDepth(cur_idx));
-      }
-      dir_page->SetGlobalDepth(max_glb_d);
-    }
+  table_latch_.RLock();
+  page_id_t page_id;
+  uint32_t local_depth;
+  {
+    HashTableDirectory dir(buffer_pool_manager_, directory_page_id_);
+    page_id = KeyToPageId(key, &dir);
+    local_depth = dir.GetLocalDepth(KeyToDirectoryIndex(key, &dir));
   }
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  page->WLatch();
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
 
+  auto ret = RemoveFromChain(bucket_page, key, value);
+  bool merge = bucket_page->IsEmpty() && local_depth > 0;
+  page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page_id, ret);
-  table_latch_.WUnlock();
+  table_latch_.RUnlock();
+
+  // a merge changes the directory, so it takes the write latch of the table
+  if (merge) {
+    table_latch_.WLock();
+    Merge(transaction, key, value);
+    table_latch_.WUnlock();
+  }
   return ret;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
+/*
+ * Called with the write latch of the table held, see SplitInsert(). An insert
+ * may have filled the bucket again since Remove() emptied it.
+ *
+ * A merged bucket is merged again while it or its image is empty, which also
+ * merges the empty buckets that were skipped because their image was split
+ * further at the time.
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  HashTableDirectory dir(buffer_pool_manager_, directory_page_id_);
+  auto dir_page = &dir;
+  auto bucket_idx = KeyToDirectoryIndex(key, dir_page);
+  bool shrink = false;
+
+  // 找到他的另一半，问题是什么时候能合并？注意他的另一半page一定存在
+  // 首先，local depth相同。当前为空
+  while (dir_page->GetLocalDepth(bucket_idx) > 0) {
+    auto old_local_d = dir_page->GetLocalDepth(bucket_idx);
+    auto img_bucket_idx = dir_page->GetMergeImageIndex(bucket_idx);
+    if (dir_page->GetLocalDepth(img_bucket_idx) != old_local_d) {
+      break;
+    }
+    page_id_t page_id = dir_page->GetBucketPageId(bucket_idx);
+    page_id_t img_page_id = dir_page->GetBucketPageId(img_bucket_idx);
+    bool empty = FetchBucketPage(page_id)->IsEmpty();
+    bool img_empty = FetchBucketPage(img_page_id)->IsEmpty();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->UnpinPage(img_page_id, false);
+    if (!empty && !img_empty) {
+      break;
+    }
+
+    // 合并之后，localdepth减少
+    // the empty one of the two is deleted
+    page_id_t kept_page_id = empty ? img_page_id : page_id;
+    buffer_pool_manager_->DeletePage(empty ? page_id : img_page_id);
+    // the slots of both buckets are the ones with their low old_local_d - 1 bits
+    auto mask = dir_page->GetLocalDepthMask(bucket_idx) >> 1;
+    bucket_idx &= mask;
+    uint32_t upper_index = 1 << dir_page->GetGlobalDepth();
+    for (uint32_t cur_idx = bucket_idx; cur_idx < upper_index; cur_idx += 1U << (old_local_d - 1)) {
+      dir_page->SetBucketPageId(cur_idx, kept_page_id);
+      dir_page->SetLocalDepth(cur_idx, old_local_d - 1);
+    }
+    shrink |= old_local_d == dir_page->GetGlobalDepth();
+  }
+
+  // 修改之后global 的也可能会变化，如果每个localdepth 都小于global depth，global depth应该等于其中最大值
+  if (shrink) {
+    while (dir_page->CanShrink()) {
+      dir_page->DecrGlobalDepth();
+    }
+  }
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
@@ -293,9 +624,7 @@ auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  HashTableDirectory(buffer_pool_manager_, directory_page_id_).VerifyIntegrity();
   table_latch_.RUnlock();
 }
 
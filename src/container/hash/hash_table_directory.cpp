@@ -0,0 +1,226 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory.cpp
+//
+// Identification: src/container/hash/hash_table_directory.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/hash_table_directory.h"
+
+#include <cassert>
+#include <unordered_map>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+HashTableDirectory::HashTableDirectory(BufferPoolManager *buffer_pool_manager, page_id_t directory_page_id)
+    : buffer_pool_manager_(buffer_pool_manager), directory_page_id_(directory_page_id) {
+  directory_page_ =
+      reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_)->GetData());
+}
+
+HashTableDirectory::~HashTableDirectory() {
+  ReleaseSegment();
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty_);
+}
+
+/*****************************************************************************
+ * DEPTHS
+ *****************************************************************************/
+auto HashTableDirectory::GetGlobalDepth() -> uint32_t { return directory_page_->GetGlobalDepth(); }
+
+auto HashTableDirectory::GetGlobalDepthMask() -> uint32_t { return directory_page_->GetGlobalDepthMask(); }
+
+auto HashTableDirectory::CanGrow() -> bool { return GetGlobalDepth() < DIRECTORY_MAX_DEPTH; }
+
+void HashTableDirectory::IncrGlobalDepth() {
+  assert(CanGrow());
+  uint32_t size = 1U << GetGlobalDepth();
+  if (size < DIRECTORY_ARRAY_SIZE) {
+    // the new half is in the directory page as well
+    for (uint32_t bucket_idx = 0; bucket_idx < size; bucket_idx++) {
+      directory_page_->SetBucketPageId(bucket_idx | size, directory_page_->GetBucketPageId(bucket_idx));
+      directory_page_->SetLocalDepth(bucket_idx | size, directory_page_->GetLocalDepth(bucket_idx));
+    }
+  } else {
+    // copy every segment into a new one
+    uint32_t segments = size / DIRECTORY_ARRAY_SIZE;
+    for (uint32_t segment = 0; segment < segments; segment++) {
+      page_id_t copy_page_id;
+      auto copy = reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPage(&copy_page_id)->GetData());
+      uint32_t offset;
+      HashTableDirectoryPage *original = SlotPage(segment * DIRECTORY_ARRAY_SIZE, false, &offset);
+      for (uint32_t i = 0; i < DIRECTORY_ARRAY_SIZE; i++) {
+        copy->SetBucketPageId(i, original->GetBucketPageId(i));
+        copy->SetLocalDepth(i, original->GetLocalDepth(i));
+      }
+      buffer_pool_manager_->UnpinPage(copy_page_id, true);
+      SetSegmentPageId(segments + segment, copy_page_id);
+    }
+  }
+  directory_page_->IncrGlobalDepth();
+  directory_dirty_ = true;
+}
+
+auto HashTableDirectory::CanShrink() -> bool {
+  uint32_t global_depth = GetGlobalDepth();
+  if (global_depth == 0) {
+    return false;
+  }
+  for (uint32_t bucket_idx = 0; bucket_idx < (1U << global_depth); bucket_idx++) {
+    if (GetLocalDepth(bucket_idx) == global_depth) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void HashTableDirectory::DecrGlobalDepth() {
+  uint32_t size = 1U << GetGlobalDepth();
+  if (size > DIRECTORY_ARRAY_SIZE) {
+    ReleaseSegment();
+    uint32_t segments = size / DIRECTORY_ARRAY_SIZE;
+    for (uint32_t segment = segments / 2; segment < segments; segment++) {
+      buffer_pool_manager_->DeletePage(GetSegmentPageId(segment));
+    }
+    for (uint32_t segment = segments / 2; segment < segments; segment++) {
+      if (IsFirstInTable(segment)) {
+        buffer_pool_manager_->DeletePage(directory_page_->GetTablePageId(segment / DIRECTORY_TABLE_PAGE_SIZE));
+      }
+    }
+  }
+  directory_page_->DecrGlobalDepth();
+  directory_dirty_ = true;
+}
+
+/*****************************************************************************
+ * SLOTS
+ *****************************************************************************/
+auto HashTableDirectory::GetBucketPageId(uint32_t bucket_idx) -> page_id_t {
+  uint32_t offset;
+  return SlotPage(bucket_idx, false, &offset)->GetBucketPageId(offset);
+}
+
+void HashTableDirectory::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
+  uint32_t offset;
+  SlotPage(bucket_idx, true, &offset)->SetBucketPageId(offset, bucket_page_id);
+}
+
+auto HashTableDirectory::GetLocalDepth(uint32_t bucket_idx) -> uint32_t {
+  uint32_t offset;
+  return SlotPage(bucket_idx, false, &offset)->GetLocalDepth(offset);
+}
+
+void HashTableDirectory::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
+  uint32_t offset;
+  SlotPage(bucket_idx, true, &offset)->SetLocalDepth(offset, local_depth);
+}
+
+auto HashTableDirectory::GetLocalDepthMask(uint32_t bucket_idx) -> uint32_t {
+  return (1U << GetLocalDepth(bucket_idx)) - 1;
+}
+
+auto HashTableDirectory::GetMergeImageIndex(uint32_t bucket_idx) -> uint32_t {
+  return (1U << (GetLocalDepth(bucket_idx) - 1)) ^ bucket_idx;
+}
+
+auto HashTableDirectory::SlotPage(uint32_t bucket_idx, bool dirty, uint32_t *offset) -> HashTableDirectoryPage * {
+  uint32_t segment = bucket_idx / DIRECTORY_ARRAY_SIZE;
+  *offset = bucket_idx % DIRECTORY_ARRAY_SIZE;
+  if (segment == 0) {
+    directory_dirty_ |= dirty;
+    return directory_page_;
+  }
+  if (segment != segment_) {
+    ReleaseSegment();
+    segment_ = segment;
+    segment_page_id_ = GetSegmentPageId(segment);
+    segment_page_ =
+        reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(segment_page_id_)->GetData());
+  }
+  segment_dirty_ |= dirty;
+  return segment_page_;
+}
+
+void HashTableDirectory::ReleaseSegment() {
+  if (segment_ == 0) {
+    return;
+  }
+  buffer_pool_manager_->UnpinPage(segment_page_id_, segment_dirty_);
+  segment_ = 0;
+  segment_page_id_ = INVALID_PAGE_ID;
+  segment_page_ = nullptr;
+  segment_dirty_ = false;
+}
+
+// segment 0 is the directory page, which no table lists
+auto HashTableDirectory::IsFirstInTable(uint32_t segment) -> bool {
+  return segment == 1 || segment % DIRECTORY_TABLE_PAGE_SIZE == 0;
+}
+
+auto HashTableDirectory::GetSegmentPageId(uint32_t segment) -> page_id_t {
+  page_id_t table_page_id = directory_page_->GetTablePageId(segment / DIRECTORY_TABLE_PAGE_SIZE);
+  auto table = reinterpret_cast<page_id_t *>(buffer_pool_manager_->FetchPage(table_page_id)->GetData());
+  page_id_t segment_page_id = table[segment % DIRECTORY_TABLE_PAGE_SIZE];
+  buffer_pool_manager_->UnpinPage(table_page_id, false);
+  return segment_page_id;
+}
+
+// segments are added in order, so a directory table page is created with its first one
+void HashTableDirectory::SetSegmentPageId(uint32_t segment, page_id_t segment_page_id) {
+  page_id_t table_page_id;
+  Page *table_page;
+  if (IsFirstInTable(segment)) {
+    table_page = buffer_pool_manager_->NewPage(&table_page_id);
+    directory_page_->SetTablePageId(segment / DIRECTORY_TABLE_PAGE_SIZE, table_page_id);
+    directory_dirty_ = true;
+  } else {
+    table_page_id = directory_page_->GetTablePageId(segment / DIRECTORY_TABLE_PAGE_SIZE);
+    table_page = buffer_pool_manager_->FetchPage(table_page_id);
+  }
+  reinterpret_cast<page_id_t *>(table_page->GetData())[segment % DIRECTORY_TABLE_PAGE_SIZE] = segment_page_id;
+  buffer_pool_manager_->UnpinPage(table_page_id, true);
+}
+
+/*****************************************************************************
+ * VERIFY INTEGRITY
+ *****************************************************************************/
+void HashTableDirectory::VerifyIntegrity() {
+  //  build maps of {bucket_page_id : pointer_count} and {bucket_page_id : local_depth}
+  std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+  std::unordered_map<page_id_t, uint32_t> page_id_to_ld;
+  uint32_t global_depth = GetGlobalDepth();
+
+  for (uint32_t curr_idx = 0; curr_idx < (1U << global_depth); curr_idx++) {
+    page_id_t curr_page_id = GetBucketPageId(curr_idx);
+    uint32_t curr_ld = GetLocalDepth(curr_idx);
+    assert(curr_ld <= global_depth);
+
+    ++page_id_to_count[curr_page_id];
+
+    if (page_id_to_ld.count(curr_page_id) > 0 && curr_ld != page_id_to_ld[curr_page_id]) {
+      LOG_WARN("Verify Integrity: curr_local_depth: %u, old_local_depth %u, for page_id: %u", curr_ld,
+               page_id_to_ld[curr_page_id], curr_page_id);
+      assert(curr_ld == page_id_to_ld[curr_page_id]);
+    } else {
+      page_id_to_ld[curr_page_id] = curr_ld;
+    }
+  }
+
+  for (const auto &[curr_page_id, curr_count] : page_id_to_count) {
+    uint32_t required_count = 0x1 << (global_depth - page_id_to_ld[curr_page_id]);
+    if (curr_count != required_count) {
+      LOG_WARN("Verify Integrity: curr_count: %u, required_count %u, for page_id: %u", curr_count, required_count,
+               curr_page_id);
+      assert(curr_count == required_count);
+    }
+  }
+}
+
+}  // namespace bustub
@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -26,21 +29,159 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : min_size_(std::max<size_t>(num_buckets, 1)),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)) {
+  NewTable(min_size_);
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::FetchHeaderPage(page_id_t header_page_id) -> HashTableHeaderPage * {
+  return reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::FetchBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE * {
+  return reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::Hash(const KeyType &key) -> uint64_t {
+  return hash_fn_.GetHash(key);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visit>
+auto HASH_TABLE_TYPE::Probe(page_id_t header_page_id, const KeyType &key, Visit &&visit) -> bool {
+  HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id);
+  size_t size = header_page->GetSize();
+  size_t slot = Hash(key) % size;
+  page_id_t block_page_id = INVALID_PAGE_ID;
+  HASH_TABLE_BLOCK_TYPE *block_page = nullptr;
+  bool stopped = false;
+  for (size_t i = 0; i < size; i++, slot = (slot + 1) % size) {
+    // the blocks hold the slots in order, so the probe moves to the next block at the first slot of it
+    if (block_page == nullptr || slot % BLOCK_ARRAY_SIZE == 0) {
+      if (block_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(block_page_id, false);
+      }
+      block_page_id = header_page->GetBlockPageId(slot / BLOCK_ARRAY_SIZE);
+      block_page = FetchBlockPage(block_page_id);
+    }
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    stopped = visit(block_page, offset);
+    if (stopped || !block_page->IsOccupied(offset)) {
+      break;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(block_page_id, stopped);
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  return stopped;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::GetTableValue(page_id_t header_page_id, const KeyType &key, std::vector<ValueType> *result)
+    -> bool {
+  bool found = false;
+  Probe(header_page_id, key, [&](HASH_TABLE_BLOCK_TYPE *block_page, slot_offset_t offset) {
+    if (block_page->IsReadable(offset) && comparator_(key, block_page->KeyAt(offset)) == 0) {
+      result->push_back(block_page->ValueAt(offset));
+      found = true;
+    }
+    return false;
+  });
+  return found;
+}
+
+/*
+ * A slot that is seen unoccupied may be claimed by another insert before this
+ * one gets to it, then the probe goes on past it.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::InsertIntoTable(const KeyType &key, const ValueType &value, bool check_duplicate)
+    -> InsertResult {
+  InsertResult result = InsertResult::FULL;
+  Probe(header_page_id_, key, [&](HASH_TABLE_BLOCK_TYPE *block_page, slot_offset_t offset) {
+    if (check_duplicate && block_page->IsReadable(offset) && comparator_(key, block_page->KeyAt(offset)) == 0 &&
+        block_page->ValueAt(offset) == value) {
+      result = InsertResult::DUPLICATE;
+      return true;
+    }
+    if (!block_page->IsOccupied(offset) && block_page->Insert(offset, key, value)) {
+      result = InsertResult::INSERTED;
+      return true;
+    }
+    return false;
+  });
+  if (result == InsertResult::INSERTED) {
+    num_occupied_++;
+  }
+  return result;
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  table_latch_.RLock();
+  bool found = GetTableValue(header_page_id_, key, result);
+  if (resizing_) {
+    found = GetTableValue(old_header_page_id_, key, result) || found;
+  }
+  table_latch_.RUnlock();
+  return found;
 }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
+/*
+ * Under the read latch of the table. Inserts of the same key start probing at
+ * the same slot, so they are serialized by the write latch of its block,
+ * which keeps two of them from both missing the other's pair. Lookups and
+ * removes rely on the atomic flags of the block pages instead.
+ */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  HelpResize();
+  while (true) {
+    table_latch_.RLock();
+    HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id_);
+    page_id_t home_page_id = header_page->GetBlockPageId(Hash(key) % size_ / BLOCK_ARRAY_SIZE);
+    buffer_pool_manager_->UnpinPage(header_page_id_, false);
+    Page *home_page = buffer_pool_manager_->FetchPage(home_page_id);
+    home_page->WLatch();
+
+    InsertResult result = InsertResult::DUPLICATE;
+    std::vector<ValueType> old_values;
+    if (!resizing_ || !GetTableValue(old_header_page_id_, key, &old_values) ||
+        std::find(old_values.begin(), old_values.end(), value) == old_values.end()) {
+      result = InsertIntoTable(key, value, true);
+    }
+    if (result == InsertResult::INSERTED) {
+      num_pairs_++;
+    }
+    bool crowded = IsCrowded();
+    home_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(home_page_id, false);
+    table_latch_.RUnlock();
+
+    if (result == InsertResult::DUPLICATE || (result == InsertResult::INSERTED && !crowded)) {
+      return result == InsertResult::INSERTED;
+    }
+    table_latch_.WLock();
+    bool grown = Grow();
+    table_latch_.WUnlock();
+    // a full table is tried again once there is room
+    if (result == InsertResult::INSERTED || !grown) {
+      return result == InsertResult::INSERTED;
+    }
+  }
 }
 
 /*****************************************************************************
@@ -48,21 +189,147 @@ auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  HelpResize();
+  auto remove = [&](HASH_TABLE_BLOCK_TYPE *block_page, slot_offset_t offset) {
+    return block_page->IsReadable(offset) && comparator_(key, block_page->KeyAt(offset)) == 0 &&
+           block_page->ValueAt(offset) == value && block_page->Remove(offset);
+  };
+  table_latch_.RLock();
+  bool removed = Probe(header_page_id_, key, remove);
+  if (!removed && resizing_ && Probe(old_header_page_id_, key, remove)) {
+    removed = true;
+    num_old_pairs_--;
+  }
+  if (removed) {
+    num_pairs_--;
+  }
+  table_latch_.RUnlock();
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  StartResize(2 * initial_size);
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::NewTable(size_t num_slots) {
+  size_t num_blocks = std::min((num_slots - 1) / BLOCK_ARRAY_SIZE + 1, HEADER_ARRAY_SIZE);
+  Page *page = buffer_pool_manager_->NewPage(&header_page_id_);
+  auto header_page = reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+  header_page->SetPageId(header_page_id_);
+  header_page->SetSize(num_blocks * BLOCK_ARRAY_SIZE);
+  for (size_t i = 0; i < num_blocks; i++) {
+    page_id_t block_page_id;
+    buffer_pool_manager_->NewPage(&block_page_id);
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+    header_page->AddBlockPageId(block_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
+  size_ = num_blocks * BLOCK_ARRAY_SIZE;
+  num_occupied_ = 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::IsCrowded() -> bool {
+  return (num_occupied_ + num_old_pairs_) * 4 > size_ * 3;
+}
+
+/*
+ * The new table gets twice as many slots as there are pairs, so it is at most
+ * half full, and less if the old one was mostly tombstones. A table that
+ * cannot get larger than it is already is only rebuilt to clear enough
+ * tombstones.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::Grow() -> bool {
+  if (!IsCrowded()) {
+    return false;
+  }
+  if (resizing_) {
+    MigrateBlocks(SIZE_MAX);
+    return true;
+  }
+  size_t new_size = std::min(std::max(min_size_, 2 * num_pairs_.load()), HEADER_ARRAY_SIZE * BLOCK_ARRAY_SIZE);
+  if (num_pairs_ * 8 > new_size * 5) {
+    return false;
+  }
+  StartResize(new_size);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::StartResize(size_t num_slots) {
+  if (resizing_) {
+    MigrateBlocks(SIZE_MAX);
+  }
+  // every pair of the old table has to fit
+  old_header_page_id_ = header_page_id_;
+  migrated_blocks_ = 0;
+  num_old_pairs_ = num_pairs_.load();
+  NewTable(std::max(num_slots, 2 * num_pairs_.load()));
+  resizing_ = true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::MigrateBlocks(size_t num_blocks) {
+  HashTableHeaderPage *old_header_page = FetchHeaderPage(old_header_page_id_);
+  size_t old_num_blocks = old_header_page->NumBlocks();
+  for (; num_blocks > 0 && migrated_blocks_ < old_num_blocks; num_blocks--, migrated_blocks_++) {
+    page_id_t block_page_id = old_header_page->GetBlockPageId(migrated_blocks_);
+    HASH_TABLE_BLOCK_TYPE *block_page = FetchBlockPage(block_page_id);
+    for (slot_offset_t offset = 0; offset < BLOCK_ARRAY_SIZE; offset++) {
+      // the pair stays in the old table as a tombstone, so that probes there still go past it
+      if (block_page->IsReadable(offset)) {
+        auto result = InsertIntoTable(block_page->KeyAt(offset), block_page->ValueAt(offset), false);
+        assert(result == InsertResult::INSERTED);
+        (void)result;
+        block_page->Remove(offset);
+        num_old_pairs_--;
+      }
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, true);
+  }
+  if (migrated_blocks_ < old_num_blocks) {
+    buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+    return;
+  }
+
+  for (size_t i = 0; i < old_num_blocks; i++) {
+    buffer_pool_manager_->DeletePage(old_header_page->GetBlockPageId(i));
+  }
+  buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+  buffer_pool_manager_->DeletePage(old_header_page_id_);
+  old_header_page_id_ = INVALID_PAGE_ID;
+  resizing_ = false;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::HelpResize() {
+  if (!resizing_) {
+    return;
+  }
+  table_latch_.WLock();
+  if (resizing_) {
+    MigrateBlocks(MIGRATE_BLOCKS_PER_OPERATION);
+  }
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetSize() -> size_t {
-  return 0;
+  table_latch_.RLock();
+  size_t size = size_;
+  table_latch_.RUnlock();
+  return size;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
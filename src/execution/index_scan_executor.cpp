@@ -11,12 +11,175 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "execution/expressions/column_value_expression.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "type/value_factory.h"
+
 namespace bustub {
+
+namespace {
+
+/*
+ * Wrap an iterator over the whole B+ tree index with keys of KeySize bytes in
+ * a function that appends the RIDs of its next batch of entries, expanding the
+ * posting lists of a non-unique index, and for index-only scans each RID's
+ * entry decoded into a tuple of the entry schema. A descending scan walks the
+ * leaves backwards and also returns the RIDs of a posting list backwards. The
+ * iterator holds no latch between batches, so the executors above the scan
+ * may modify the index.
+ */
+template <size_t KeySize>
+auto MakeBatchScan(Index *index, int batch_size, bool descending)
+    -> std::function<bool(std::vector<RID> *, std::vector<Tuple> *)> {
+  using TreeIndex = BPlusTreeIndex<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+  auto tree_index = dynamic_cast<TreeIndex *>(index);
+  if (tree_index == nullptr) {
+    throw NotImplementedException("index scans need a B+ tree index");
+  }
+  auto iterator = std::make_shared<IndexIterator<GenericKey<KeySize>, RID, GenericComparator<KeySize>>>(
+      descending ? tree_index->GetReverseBeginIterator() : tree_index->GetBeginIterator());
+  auto expand = [tree_index, descending](const std::pair<GenericKey<KeySize>, RID> &item, std::vector<RID> *rids,
+                                         std::vector<Tuple> *entries) {
+    size_t expanded = rids->size();
+    tree_index->ExpandValue(item.second, rids);
+    if (descending) {
+      std::reverse(rids->begin() + expanded, rids->end());
+    }
+    if (entries != nullptr && rids->size() > expanded) {
+      Schema *entry_schema = tree_index->GetEntrySchema();
+      std::vector<Value> values;
+      for (uint32_t i = 0; i < entry_schema->GetColumnCount(); i++) {
+        values.push_back(item.first.ToValue(entry_schema, i));
+      }
+      entries->resize(rids->size(), Tuple(values, entry_schema));
+    }
+  };
+  auto items = std::make_shared<std::vector<std::pair<GenericKey<KeySize>, RID>>>(batch_size);
+  return [iterator, items, expand](std::vector<RID> *rids, std::vector<Tuple> *entries) {
+    int count = iterator->NextBatch(items->data(), static_cast<int>(items->size()));
+    for (int i = 0; i < count; i++) {
+      expand((*items)[i], rids, entries);
+    }
+    return count > 0;
+  };
+}
+
+// appends the table columns an expression reads to columns
+void CollectColumns(const AbstractExpression *expression, std::vector<uint32_t> *columns) {
+  if (auto column = dynamic_cast<const ColumnValueExpression *>(expression); column != nullptr) {
+    columns->push_back(column->GetColIdx());
+  }
+  for (const auto *child : expression->GetChildren()) {
+    CollectColumns(child, columns);
+  }
+}
+
+}  // namespace
+
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  auto catalog = exec_ctx_->GetCatalog();
+  auto index_info = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info->table_name_);
+  index_ = index_info->index_.get();
+  bool descending = plan_->IsDescending();
+  switch (index_info->key_size_) {
+    case 4:
+      next_batch_ = MakeBatchScan<4>(index_, BATCH_SIZE, descending);
+      break;
+    case 8:
+      next_batch_ = MakeBatchScan<8>(index_, BATCH_SIZE, descending);
+      break;
+    case 16:
+      next_batch_ = MakeBatchScan<16>(index_, BATCH_SIZE, descending);
+      break;
+    case 32:
+      next_batch_ = MakeBatchScan<32>(index_, BATCH_SIZE, descending);
+      break;
+    case 64:
+      next_batch_ = MakeBatchScan<64>(index_, BATCH_SIZE, descending);
+      break;
+    default:
+      throw NotImplementedException("unsupported index key size");
+  }
+
+  // a covering index holds the key and included columns of every entry, and if the scan reads no others it builds the
+  // tuples from the entries instead of fetching them from the table
+  const Schema *table_schema = &table_info_->schema_;
+  std::vector<uint32_t> columns;
+  for (const auto &column : GetOutputSchema()->GetColumns()) {
+    columns.push_back(table_schema->GetColIdx(column.GetName()));
+  }
+  if (plan_->GetPredicate() != nullptr) {
+    CollectColumns(plan_->GetPredicate(), &columns);
+  }
+  const auto &entry_attrs = index_->GetEntryAttrs();
+  index_only_ = index_->GetMetadata()->IsCovering() &&
+                std::all_of(columns.begin(), columns.end(), [&](uint32_t column) {
+                  return std::find(entry_attrs.begin(), entry_attrs.end(), column) != entry_attrs.end();
+                });
+  rids_.clear();
+  entries_.clear();
+  cursor_ = 0;
+}
 
-void IndexScanExecutor::Init() {}
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  const Schema *table_schema = &table_info_->schema_;
+  while (true) {
+    // a batch of entries may expand to no RIDs at all if their posting lists were emptied meanwhile
+    if (cursor_ == rids_.size()) {
+      rids_.clear();
+      entries_.clear();
+      cursor_ = 0;
+      if (!next_batch_(&rids_, index_only_ ? &entries_ : nullptr)) {
+        return false;
+      }
+      continue;
+    }
+    size_t position = cursor_++;
+    RID tuple_rid = rids_[position];
+    Tuple table_tuple;
+    if (index_only_) {
+      table_tuple = TupleFromEntry(entries_[position]);
+    } else if (!table_info_->table_->GetTuple(tuple_rid, &table_tuple, exec_ctx_->GetTransaction())) {
+      continue;
+    }
+    const AbstractExpression *predicate = plan_->GetPredicate();
+    if (predicate != nullptr && !predicate->Evaluate(&table_tuple, table_schema).GetAs<bool>()) {
+      continue;
+    }
+    std::vector<Value> values;
+    for (const auto &column : GetOutputSchema()->GetColumns()) {
+      values.push_back(table_tuple.GetValue(table_schema, table_schema->GetColIdx(column.GetName())));
+    }
+    *tuple = Tuple(values, GetOutputSchema());
+    *rid = tuple_rid;
+    return true;
+  }
+}
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+/*
+ * Lay the columns of an entry out as a table tuple. The columns the entry
+ * does not hold are never read, so they get placeholder values.
+ */
+auto IndexScanExecutor::TupleFromEntry(const Tuple &entry) -> Tuple {
+  const Schema *table_schema = &table_info_->schema_;
+  std::vector<Value> values;
+  for (const auto &column : table_schema->GetColumns()) {
+    values.push_back(column.GetType() == TypeId::VARCHAR ? ValueFactory::GetVarcharValue("")
+                                                         : ValueFactory::GetNullValueByType(column.GetType()));
+  }
+  const auto &entry_attrs = index_->GetEntryAttrs();
+  for (uint32_t i = 0; i < entry_attrs.size(); i++) {
+    values[entry_attrs[i]] = entry.GetValue(index_->GetEntrySchema(), i);
+  }
+  return Tuple(values, table_schema);
+}
 
 }  // namespace bustub
@@ -55,7 +55,10 @@ void InsertExecutor::ExecuteInsert() {
             if (inserted_table_->table_->InsertTuple(temp_tuple, &temp_rid, exec_ctx_->GetTransaction())) {
                 // 3. update index of table
                 for (const auto &index_info : indexes_info) {
-                    index_info->index_->InsertEntry(temp_tuple, temp_rid, exec_ctx_->GetTransaction());
+                    const auto &index = index_info->index_;
+                    auto entry = temp_tuple.KeyFromTuple(inserted_table_->schema_, *index->GetEntrySchema(),
+                                                         index->GetEntryAttrs());
+                    index->InsertEntry(entry, temp_rid, exec_ctx_->GetTransaction());
                 }
             } 
         } 
@@ -64,7 +67,10 @@ void InsertExecutor::ExecuteInsert() {
             if (inserted_table_->table_->InsertTuple(temp_tuple, &temp_rid, exec_ctx_->GetTransaction())) {
                 // 3. update index of table
                 for (const auto &index_info : indexes_info) {
-                    index_info->index_->InsertEntry(temp_tuple, temp_rid, exec_ctx_->GetTransaction());
+                    const auto &index = index_info->index_;
+                    auto entry = temp_tuple.KeyFromTuple(inserted_table_->schema_, *index->GetEntrySchema(),
+                                                         index->GetEntryAttrs());
+                    index->InsertEntry(entry, temp_rid, exec_ctx_->GetTransaction());
                 }   
             }
         }
@@ -51,7 +51,10 @@ void UpdateExecutor::ExecuteUpdate() {
           const auto & index = index_info->index_;
           auto key = temp_tuple.KeyFromTuple(*child_executor_->GetOutputSchema(), *index->GetKeySchema(), index->GetKeyAttrs());
           index_info->index_->DeleteEntry(key, temp_rid, exec_ctx_->GetTransaction());
-          index_info->index_->InsertEntry(key, temp_rid, exec_ctx_->GetTransaction());
+          // a covering index also stores the included columns, which come from the updated tuple
+          auto entry =
+              updated_tuple.KeyFromTuple(table_info_->schema_, *index->GetEntrySchema(), index->GetEntryAttrs());
+          index_info->index_->InsertEntry(entry, temp_rid, exec_ctx_->GetTransaction());
       }
     }
   }
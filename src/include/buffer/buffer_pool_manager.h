@@ -15,6 +15,8 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
@@ -87,6 +89,23 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return true iff the database has no pages yet, neither in its file nor allocated since */
+  virtual auto IsEmpty() -> bool = 0;
+
+  /**
+   * Snapshot the dirty page table, used for fuzzy checkpointing.
+   * @param[out] dirty_page_table (page id, recLSN) of every dirty page in the buffer pool
+   */
+  virtual void GetDirtyPageTable(std::vector<std::pair<page_id_t, lsn_t>> *dirty_page_table) = 0;
+
+  /**
+   * Read pages that are about to be fetched into the buffer pool without pinning them. Pages that are already
+   * resident are skipped, and reading stops once every frame is pinned. Safe to call from a background thread: the
+   * reads do not hold up other operations, except fetches of the page being read, which wait for it.
+   * @param page_ids ids of the pages to read, in the order they will be needed
+   */
+  virtual void PrefetchPages(const std::vector<page_id_t> &page_ids) = 0;
+
  protected:
   /**
    * Grading function. Do not modify!
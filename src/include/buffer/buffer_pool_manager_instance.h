@@ -12,9 +12,13 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/lru_replacer.h"
@@ -55,9 +59,15 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
+  auto IsEmpty() -> bool override { return next_page_id_ == static_cast<page_id_t>(instance_index_); }
+
   /** @return pointer to all the pages in the buffer pool */
   auto GetPages() -> Page * { return pages_; }
 
+  void GetDirtyPageTable(std::vector<std::pair<page_id_t, lsn_t>> *dirty_page_table) override;
+
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) override;
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -113,6 +123,21 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void FindUseableFrame(frame_id_t *frame_id);
 
+  /**
+   * Write the page held in a frame back to disk and mark it clean. The log is forced up to the page LSN first.
+   * @param frame_id the frame to write back
+   */
+  void WriteBackFrame(frame_id_t frame_id);
+
+  /** @return the lsn the next log record will get, used as recLSN of pages that are clean right now */
+  auto CleanRecLSN() -> lsn_t;
+
+  /**
+   * Wait until a page that is being prefetched has been read, must be called with latch_ held.
+   * @return the frame holding the page, -1 if it is not in the buffer pool
+   */
+  auto WaitForLoad(std::unique_lock<std::mutex> *lock, page_id_t page_id) -> frame_id_t;
+
   /**
    * Deallocate a page on disk.
    * @param page_id id of the page to deallocate
@@ -151,5 +176,9 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   std::list<frame_id_t> free_list_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+  /** Frames PrefetchPages() is reading into without holding latch_, they are pinned and in the page table. */
+  std::unordered_set<frame_id_t> loading_frames_;
+  /** Notified whenever a frame leaves loading_frames_. */
+  std::condition_variable loaded_cv_;
 };
 }  // namespace bustub
@@ -43,6 +43,12 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override;
 
+  auto IsEmpty() -> bool override;
+
+  void GetDirtyPageTable(std::vector<std::pair<page_id_t, lsn_t>> *dirty_page_table) override;
+
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) override;
+
  protected:
   /**
    * @param page_id id of page
@@ -21,8 +21,12 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/adaptive_radix_tree_index.h"
+#include "storage/index/b_epsilon_tree_index.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/page/header_page.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -34,6 +38,9 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** The data structure an index is built on. */
+enum class IndexType { HASH_TABLE, B_PLUS_TREE, ADAPTIVE_RADIX_TREE, B_EPSILON_TREE };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -106,13 +113,23 @@ class Catalog {
   static constexpr IndexInfo *NULL_INDEX_INFO{nullptr};
 
   /**
-   * Construct a new Catalog instance.
+   * Construct a new Catalog instance. The first page of a new database
+   * becomes the header page that indexes record their root pages in, a
+   * database that was opened again keeps the header page it has.
    * @param bpm The buffer pool manager backing tables created by this catalog
    * @param lock_manager The lock manager in use by the system
    * @param log_manager The log manager in use by the system
    */
   Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager)
-      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager} {}
+      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager} {
+    if (!bpm_->IsEmpty()) {
+      return;
+    }
+    page_id_t header_page_id;
+    auto header_page = static_cast<HeaderPage *>(bpm_->NewPage(&header_page_id));
+    header_page->Init();
+    bpm_->UnpinPage(header_page_id, true);
+  }
 
   /**
    * Create a new table and return its metadata.
@@ -186,12 +203,19 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param unique Whether each key has a single RID, a non-unique index keeps posting lists
+   * @param include_attrs Included (non-key) columns, stored in the leaves of a B+ tree index so that scans reading
+   * only them and the key columns need not fetch the tuples; an index with included columns is always a B+ tree
+   * @param index_type The data structure of an index without included columns, an adaptive radix tree keeps the
+   * whole index in memory, a B-epsilon tree buffers writes in its internal nodes
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, bool unique = true,
+                   const std::vector<uint32_t> &include_attrs = {}, IndexType index_type = IndexType::HASH_TABLE)
+      -> IndexInfo * {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
@@ -208,21 +232,41 @@ class Catalog {
     }
 
     // Construct index metdata
-    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs, unique, include_attrs);
 
     // Construct the index, take ownership of metadata
     // TODO(Kyle): We should update the API for CreateIndex
     // to allow specification of the index type itself, not
     // just the key, value, and comparator types
-    auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
-                                                                                               hash_function);
+    std::unique_ptr<Index> index;
+    if (!include_attrs.empty() || index_type == IndexType::B_PLUS_TREE) {
+      index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    } else if (index_type == IndexType::ADAPTIVE_RADIX_TREE) {
+      index = std::make_unique<AdaptiveRadixTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    } else if (index_type == IndexType::B_EPSILON_TREE) {
+      index = std::make_unique<BEpsilonTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    } else {
+      index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                            hash_function);
+    }
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap, as one batch so that the index can bulk load it
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
-    }
+    auto tuple = heap->Begin(txn);
+    const Schema &entry_schema = include_attrs.empty() ? key_schema : *index->GetEntrySchema();
+    const std::vector<uint32_t> &entry_attrs = include_attrs.empty() ? key_attrs : index->GetEntryAttrs();
+    index->InsertEntries(
+        [&](Tuple *key, RID *rid) {
+          if (tuple == heap->End()) {
+            return false;
+          }
+          *key = tuple->KeyFromTuple(schema, entry_schema, entry_attrs);
+          *rid = tuple->GetRid();
+          ++tuple;
+          return true;
+        },
+        txn);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
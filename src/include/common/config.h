@@ -35,11 +35,13 @@ static constexpr int PAGE_SIZE = 4096;                                        //
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int64_t LOG_SEGMENT_SIZE = 16 * 1024 * 1024;                 // size of a log segment file in byte
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
 using txn_id_t = int32_t;      // transaction id type
-using lsn_t = int32_t;         // log sequence number type
+using lsn_t = int64_t;         // log sequence number type
+using log_offset_t = int64_t;  // byte address in the (segmented) log
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
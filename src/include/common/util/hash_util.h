@@ -13,7 +13,9 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -24,27 +26,123 @@ namespace bustub {
 
 using hash_t = std::size_t;
 
+/**
+ * Hashes for in-memory structures, such as the hash tables of joins,
+ * aggregations and distinct.
+ *
+ * HashBytes() is in the style of wyhash: it reads the input a word at a time
+ * and folds each pair of words with a 64x64->128 bit multiply. A fixed-width
+ * value is hashed as one word with HashWord(), and HashWords() and
+ * HashValues() hash a whole column at once, converting all its values before
+ * hashing any, so the multiplies of neighbouring values overlap.
+ *
+ * The hashes are not stable across versions and must not be stored. On-disk
+ * structures use HashFunction (murmur3) instead.
+ */
 class HashUtil {
  private:
   static const hash_t PRIME_FACTOR = 10000019;
+  static constexpr uint64_t SECRET0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t SECRET1 = 0xe7037ed1a0b428dbULL;
+  // the number of values HashValues() converts to words at a time
+  static constexpr size_t BATCH_SIZE = 64;
+
+  /** @return the high and low halves of the 128 bit product a * b, xor'ed */
+  static inline auto Mix(uint64_t a, uint64_t b) -> uint64_t {
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+  }
+
+  static inline auto Read8(const char *bytes) -> uint64_t {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  static inline auto Read4(const char *bytes) -> uint64_t {
+    uint32_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  /** @return the hash of the two words a and b that stand for length bytes */
+  static inline auto Finish(uint64_t a, uint64_t b, uint64_t seed, size_t length) -> hash_t {
+    a ^= SECRET1;
+    b ^= seed;
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return Mix(static_cast<uint64_t>(product) ^ SECRET0 ^ length, static_cast<uint64_t>(product >> 64) ^ SECRET1);
+  }
+
+  // the word a fixed-width value is hashed as, integers of all widths are sign-extended so that equal ones hash alike
+  static inline auto ToWord(int8_t raw) -> uint64_t { return static_cast<uint64_t>(static_cast<int64_t>(raw)); }
+  static inline auto ToWord(int16_t raw) -> uint64_t { return static_cast<uint64_t>(static_cast<int64_t>(raw)); }
+  static inline auto ToWord(int32_t raw) -> uint64_t { return static_cast<uint64_t>(static_cast<int64_t>(raw)); }
+  static inline auto ToWord(int64_t raw) -> uint64_t { return static_cast<uint64_t>(raw); }
+  static inline auto ToWord(uint64_t raw) -> uint64_t { return raw; }
+  static inline auto ToWord(bool raw) -> uint64_t { return static_cast<uint64_t>(raw); }
+  static inline auto ToWord(double raw) -> uint64_t {
+    uint64_t word;
+    std::memcpy(&word, &raw, sizeof(word));
+    return word;
+  }
+
+  template <typename T>
+  static inline void ToWords(const Value *vals, size_t n, uint64_t *words) {
+    for (size_t i = 0; i < n; i++) {
+      words[i] = ToWord(vals[i].GetAs<T>());
+    }
+  }
 
  public:
   static inline auto HashBytes(const char *bytes, size_t length) -> hash_t {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
-    for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+    // https://github.com/wangyi-fudan/wyhash, with a fixed seed and a simpler loop for long inputs
+    uint64_t seed = SECRET0;
+    uint64_t a;
+    uint64_t b;
+    if (length <= 16) {
+      if (length >= 4) {
+        // two overlapping 4 byte reads from each end cover all of 4 to 16 bytes
+        size_t middle = (length >> 3) << 2;
+        a = (Read4(bytes) << 32) | Read4(bytes + middle);
+        b = (Read4(bytes + length - 4) << 32) | Read4(bytes + length - 4 - middle);
+      } else if (length > 0) {
+        a = (static_cast<uint64_t>(static_cast<uint8_t>(bytes[0])) << 16) |
+            (static_cast<uint64_t>(static_cast<uint8_t>(bytes[length >> 1])) << 8) |
+            static_cast<uint8_t>(bytes[length - 1]);
+        b = 0;
+      } else {
+        a = 0;
+        b = 0;
+      }
+    } else {
+      size_t i = length;
+      const char *p = bytes;
+      while (i > 16) {
+        seed = Mix(Read8(p) ^ SECRET1, Read8(p + 8) ^ seed);
+        p += 16;
+        i -= 16;
+      }
+      // the last 16 bytes, which may overlap the ones folded in already
+      a = Read8(p + i - 16);
+      b = Read8(p + i - 8);
     }
-    return hash;
+    return Finish(a, b, seed, length);
   }
 
-  static inline auto CombineHashes(hash_t l, hash_t r) -> hash_t {
-    hash_t both[2] = {};
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
+  /** @return the hash of a word, the same as HashBytes() on its 8 bytes */
+  static inline auto HashWord(uint64_t word) -> hash_t {
+    return Finish((word << 32) | (word >> 32), word, SECRET0, sizeof(word));
   }
 
+  /** Hash n words into hashes, the same as HashWord() on each. */
+  static inline void HashWords(const uint64_t *words, size_t n, hash_t *hashes) {
+    for (size_t i = 0; i < n; i++) {
+      hashes[i] = HashWord(words[i]);
+    }
+  }
+
+  static inline auto CombineHashes(hash_t l, hash_t r) -> hash_t { return Finish(l, r, SECRET0, sizeof(hash_t) * 2); }
+
   static inline auto SumHashes(hash_t l, hash_t r) -> hash_t {
     return (l % PRIME_FACTOR + r % PRIME_FACTOR) % PRIME_FACTOR;
   }
@@ -56,50 +154,81 @@ class HashUtil {
 
   template <typename T>
   static inline auto HashPtr(const T *ptr) -> hash_t {
-    return HashBytes(reinterpret_cast<const char *>(&ptr), sizeof(void *));
+    return HashWord(reinterpret_cast<uintptr_t>(ptr));
   }
 
   /** @return the hash of the value */
   static inline auto HashValue(const Value *val) -> hash_t {
     switch (val->GetTypeId()) {
-      case TypeId::TINYINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int8_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::SMALLINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int16_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::INTEGER: {
-        auto raw = static_cast<int64_t>(val->GetAs<int32_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::BIGINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int64_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::BOOLEAN: {
-        auto raw = val->GetAs<bool>();
-        return Hash<bool>(&raw);
-      }
-      case TypeId::DECIMAL: {
-        auto raw = val->GetAs<double>();
-        return Hash<double>(&raw);
-      }
-      case TypeId::VARCHAR: {
-        auto raw = val->GetData();
-        auto len = val->GetLength();
-        return HashBytes(raw, len);
-      }
-      case TypeId::TIMESTAMP: {
-        auto raw = val->GetAs<uint64_t>();
-        return Hash<uint64_t>(&raw);
-      }
+      case TypeId::TINYINT:
+        return HashWord(ToWord(val->GetAs<int8_t>()));
+      case TypeId::SMALLINT:
+        return HashWord(ToWord(val->GetAs<int16_t>()));
+      case TypeId::INTEGER:
+        return HashWord(ToWord(val->GetAs<int32_t>()));
+      case TypeId::BIGINT:
+        return HashWord(ToWord(val->GetAs<int64_t>()));
+      case TypeId::BOOLEAN:
+        return HashWord(ToWord(val->GetAs<bool>()));
+      case TypeId::DECIMAL:
+        return HashWord(ToWord(val->GetAs<double>()));
+      case TypeId::VARCHAR:
+        return HashBytes(val->GetData(), val->GetLength());
+      case TypeId::TIMESTAMP:
+        return HashWord(ToWord(val->GetAs<uint64_t>()));
       default: {
         BUSTUB_ASSERT(false, "Unsupported type.");
       }
     }
   }
+
+  /**
+   * Hash a column of n values into hashes, the same as HashValue() on each.
+   * Runs of fixed-width values of one type are converted to words and then
+   * hashed together, without looking at the type of each one.
+   */
+  static inline void HashValues(const Value *vals, size_t n, hash_t *hashes) {
+    uint64_t words[BATCH_SIZE];
+    for (size_t start = 0; start < n; start += BATCH_SIZE) {
+      size_t count = std::min(BATCH_SIZE, n - start);
+      const Value *batch = vals + start;
+      TypeId type_id = batch[0].GetTypeId();
+      bool same_type = std::all_of(batch, batch + count, [&](const Value &val) { return val.GetTypeId() == type_id; });
+      if (!same_type || type_id == TypeId::VARCHAR) {
+        for (size_t i = 0; i < count; i++) {
+          hashes[start + i] = HashValue(&batch[i]);
+        }
+        continue;
+      }
+      switch (type_id) {
+        case TypeId::TINYINT:
+          ToWords<int8_t>(batch, count, words);
+          break;
+        case TypeId::SMALLINT:
+          ToWords<int16_t>(batch, count, words);
+          break;
+        case TypeId::INTEGER:
+          ToWords<int32_t>(batch, count, words);
+          break;
+        case TypeId::BIGINT:
+          ToWords<int64_t>(batch, count, words);
+          break;
+        case TypeId::BOOLEAN:
+          ToWords<bool>(batch, count, words);
+          break;
+        case TypeId::DECIMAL:
+          ToWords<double>(batch, count, words);
+          break;
+        case TypeId::TIMESTAMP:
+          ToWords<uint64_t>(batch, count, words);
+          break;
+        default: {
+          BUSTUB_ASSERT(false, "Unsupported type.");
+        }
+      }
+      HashWords(words, count, hashes + start);
+    }
+  }
 };
 
 }  // namespace bustub
@@ -254,6 +254,15 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return the LSN of the BEGIN record of this transaction */
+  inline auto GetFirstLSN() -> lsn_t { return first_lsn_; }
+
+  /**
+   * Set the LSN of the BEGIN record.
+   * @param first_lsn lsn of the BEGIN record
+   */
+  inline void SetFirstLSN(lsn_t first_lsn) { first_lsn_ = first_lsn; }
+
  private:
   /** The current transaction state. */
   TransactionState state_;
@@ -270,6 +279,8 @@ class Transaction {
   std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
+  /** The LSN of the BEGIN record written by the transaction. */
+  lsn_t first_lsn_{INVALID_LSN};
 
   /** Concurrent index: the pages that were latched during index operation. */
   std::shared_ptr<std::deque<Page *>> page_set_;
@@ -13,9 +13,12 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -85,6 +88,13 @@ class TransactionManager {
   /** Resumes all transactions, used for checkpointing. */
   void ResumeTransactions();
 
+  /**
+   * Snapshot the active transaction table, used for fuzzy checkpointing.
+   * @param[out] active_txn_table (txn id, last lsn) of every running transaction that has written a log record
+   * @return the smallest first lsn among those transactions, or INVALID_LSN if there are none
+   */
+  auto GetActiveTransactionTable(std::vector<std::pair<txn_id_t, lsn_t>> *active_txn_table) -> lsn_t;
+
  private:
   /**
    * Releases all the locks held by the given transaction.
@@ -105,10 +115,14 @@ class TransactionManager {
 
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** Transactions that have begun but not yet committed or aborted, used for fuzzy checkpointing. */
+  std::unordered_map<txn_id_t, Transaction *> running_txns_;
+  std::mutex running_txns_latch_;
 };
 
 }  // namespace bustub
@@ -19,6 +19,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
+#include "container/hash/hash_table_directory.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
@@ -30,19 +31,35 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * A bucket is a chain of bucket pages: the page the directory points to and
+ * the overflow pages linked from it. A full bucket is split as long as that
+ * separates its pairs, and only gets another overflow page when all of them
+ * have the same hash (within DIRECTORY_MAX_DEPTH bits), e.g. many values of
+ * one key, which would otherwise double the directory until it runs out of
+ * depth. A chain of n pages always holds more than n - 1 pages' worth of
+ * pairs, so its last page is folded into the others as soon as they fit, and
+ * the first page is empty only if the whole bucket is. The latch of the first
+ * page covers the whole chain.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
  public:
   /**
-   * Creates a new ExtendibleHashTable.
+   * Creates a new ExtendibleHashTable. Or opens one that was created before,
+   * possibly by an earlier run of the database, reading nothing but the
+   * header page and its directory page.
    *
+   * @param name the name of the table, shorter than 32 characters
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
-   * @param hash_fn the hash function
+   * @param hash_fn the hash function, the one the table was created with when it is opened
+   * @param use_header_page whether the database has a header page, to record the directory page id in under the name
+   * @param open_existing whether to open the table the header page records under the name
    */
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               bool use_header_page = false, bool open_existing = false);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -74,6 +91,19 @@ class ExtendibleHashTable {
    */
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
+  /**
+   * Performs point queries for many keys at once, e.g. the probes of an index
+   * nested loop join. The keys are all hashed and mapped to their buckets
+   * first, then each bucket page is pinned and scanned once for all of its
+   * keys, while the next one is already fetched and prefetched.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results results[i] gets the value(s) associated with keys[i]
+   */
+  void GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *results);
+
   /**
    * Returns the global depth.  Do not touch.
    */
@@ -107,19 +137,25 @@ class ExtendibleHashTable {
    * representation.
    *
    * @param key the key to use for lookup
-   * @param dir_page to use for lookup of global depth
+   * @param dir_page the directory, to use for lookup of global depth
    * @return the directory index
    */
-  inline auto KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t;
+  inline auto KeyToDirectoryIndex(KeyType key, HashTableDirectory *dir_page) -> uint32_t;
 
   /**
    * Get the bucket page_id corresponding to a key.
    *
    * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
+   * @param dir_page a pointer to the hash table's directory
    * @return the bucket page_id corresponding to the input key
    */
-  inline auto KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t;
+  inline auto KeyToPageId(KeyType key, HashTableDirectory *dir_page) -> uint32_t;
+
+  /**
+   * Records the directory page id under the name of the table in the header
+   * page, replacing the record of an earlier table of the same name.
+   */
+  void UpdateDirectoryPageId();
 
   /**
    * Fetches the directory page from the buffer pool manager.
@@ -136,6 +172,65 @@ class ExtendibleHashTable {
    */
   auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
 
+  /**
+   * Looks up a key in every page of a bucket's chain.
+   *
+   * @param bucket_page the first page of the chain
+   * @param key the key to look up
+   * @param[out] result the value(s) associated with the key
+   * @return whether any value was found
+   */
+  auto GetChainValue(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, std::vector<ValueType> *result) -> bool;
+
+  /**
+   * Looks up several keys in every page of a bucket's chain, see HashTableBucketPage::GetValues().
+   *
+   * @param bucket_page the first page of the chain
+   * @param keys the keys to look up
+   * @param num_keys the number of keys
+   * @param[out] results results[i] collects the values of keys[i]
+   */
+  void GetChainValues(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType *keys, size_t num_keys,
+                      std::vector<ValueType> *const *results);
+
+  /**
+   * Inserts a pair into the first page of a bucket's chain that is not full.
+   *
+   * @param bucket_page the first page of the chain
+   * @param key the key to insert
+   * @param value the value to insert
+   * @param append whether to add an overflow page to the chain if all of its pages are full
+   * @return false if the chain was full and nothing was appended
+   */
+  auto InsertIntoChain(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, const ValueType &value, bool append)
+      -> bool;
+
+  /**
+   * Removes a pair from a bucket's chain, and then folds the last overflow page
+   * into the others if they can hold all the pairs.
+   *
+   * @param bucket_page the first page of the chain
+   * @param key the key to remove
+   * @param value the value to remove
+   * @return whether the pair was found
+   */
+  auto RemoveFromChain(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, const ValueType &value) -> bool;
+
+  /**
+   * Moves all the pairs of a bucket's chain out of it, deleting the overflow pages.
+   *
+   * @param bucket_page the first page of the chain, which is left empty
+   * @param[out] pairs the pairs of the chain
+   */
+  void TakeChain(HASH_TABLE_BUCKET_TYPE *bucket_page, std::vector<MappingType> *pairs);
+
+  /**
+   * @param bucket_page the first page of the chain
+   * @param key a key that is to be inserted into the chain
+   * @return whether splitting the bucket often enough would separate the key and the keys of the chain
+   */
+  auto IsSeparable(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key) -> bool;
+
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -151,10 +246,12 @@ class ExtendibleHashTable {
    * if Remove makes a bucket empty.
    *
    * There are three conditions under which we skip the merge:
-   * 1. The bucket is no longer empty.
+   * 1. Neither the bucket nor its split image is empty.
    * 2. The bucket has local depth 0.
    * 3. The bucket's local depth doesn't match its split image's local depth.
    *
+   * The merged bucket is merged further under the same conditions.
+   *
    * @param transaction a pointer to the current transaction
    * @param key the key that was removed
    * @param value the value that was removed
@@ -162,6 +259,7 @@ class ExtendibleHashTable {
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
   // member variables
+  std::string index_name_;
   page_id_t directory_page_id_;
   page_id_t inf_;
   BufferPoolManager *buffer_pool_manager_;
@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory.h
+//
+// Identification: src/include/container/hash/hash_table_directory.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/hash_table_directory_page.h"
+
+namespace bustub {
+
+/**
+ * The directory of an extendible hash table, which may span many pages.
+ *
+ * The directory page holds the global depth and the first
+ * DIRECTORY_ARRAY_SIZE slots. Once the global depth goes past what fits,
+ * slot i is in segment i / DIRECTORY_ARRAY_SIZE, a page of the directory
+ * page's format, whose page id is in directory table page
+ * segment / DIRECTORY_TABLE_PAGE_SIZE, which the directory page lists.
+ * Looking up a slot thus reads at most three pages, however large the
+ * directory is. Doubling the directory copies it a segment at a time into
+ * new segments, and halving it deletes the upper half.
+ *
+ * An object of this class is an accessor for the duration of one operation:
+ * it keeps the directory page and the segment it used last pinned, and
+ * unpins them when it is destroyed. The caller latches the directory.
+ */
+class HashTableDirectory {
+ public:
+  /**
+   * @param buffer_pool_manager buffer pool manager the directory pages are in
+   * @param directory_page_id the page id of the directory page
+   */
+  HashTableDirectory(BufferPoolManager *buffer_pool_manager, page_id_t directory_page_id);
+
+  ~HashTableDirectory();
+
+  DISALLOW_COPY_AND_MOVE(HashTableDirectory);
+
+  /** @return the global depth of the directory */
+  auto GetGlobalDepth() -> uint32_t;
+
+  /** @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards) */
+  auto GetGlobalDepthMask() -> uint32_t;
+
+  /** @return true if the global depth is below DIRECTORY_MAX_DEPTH */
+  auto CanGrow() -> bool;
+
+  /** Doubles the directory, every new slot points to the bucket of the slot it is the split image of. */
+  void IncrGlobalDepth();
+
+  /** @return true if every local depth is below the global depth */
+  auto CanShrink() -> bool;
+
+  /** Halves the directory, deleting the segments and directory table pages that are no longer used. */
+  void DecrGlobalDepth();
+
+  auto GetBucketPageId(uint32_t bucket_idx) -> page_id_t;
+
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  auto GetLocalDepth(uint32_t bucket_idx) -> uint32_t;
+
+  void SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth);
+
+  auto GetLocalDepthMask(uint32_t bucket_idx) -> uint32_t;
+
+  auto GetMergeImageIndex(uint32_t bucket_idx) -> uint32_t;
+
+  /**
+   * Verify the invariants of HashTableDirectoryPage::VerifyIntegrity() over
+   * all the slots of the directory.
+   */
+  void VerifyIntegrity();
+
+ private:
+  /**
+   * The page holding a slot, pinned until another segment is needed.
+   *
+   * @param bucket_idx the slot
+   * @param dirty whether the slot is going to be changed
+   * @param[out] offset the index of the slot in the page
+   */
+  auto SlotPage(uint32_t bucket_idx, bool dirty, uint32_t *offset) -> HashTableDirectoryPage *;
+
+  /** Unpin the segment used last. */
+  void ReleaseSegment();
+
+  static auto IsFirstInTable(uint32_t segment) -> bool;
+
+  auto GetSegmentPageId(uint32_t segment) -> page_id_t;
+
+  void SetSegmentPageId(uint32_t segment, page_id_t segment_page_id);
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t directory_page_id_;
+  HashTableDirectoryPage *directory_page_;
+  bool directory_dirty_{false};
+  // the segment used last, 0 for none since segment 0 is the directory page
+  uint32_t segment_{0};
+  page_id_t segment_page_id_{INVALID_PAGE_ID};
+  HashTableDirectoryPage *segment_page_{nullptr};
+  bool segment_dirty_{false};
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -32,6 +33,17 @@ namespace bustub {
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * The slots of a table are spread over block pages, which its header page
+ * lists in order. A key is looked for from its slot onwards until a slot that
+ * was never occupied. Removing a pair leaves a tombstone that is only cleared
+ * by moving to a new table.
+ *
+ * Resizing is incremental: a new table is created next to the old one, and
+ * every insert and remove moves the pairs of a few blocks of the old table
+ * into the new one before it runs, so that no operation rehashes the whole
+ * table. In the meantime pairs are inserted into the new table and looked up
+ * in both. Once the last block is moved the old table is deleted.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -87,8 +99,91 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
   auto GetSize() -> size_t;
 
  private:
+  enum class InsertResult { INSERTED, DUPLICATE, FULL };
+
+  /**
+   * Probes a table for a key: visits the slots from the key's one onwards
+   * until visit returns true or after a slot that was never occupied, at most
+   * once around the table. The block of the slot visit stops at is unpinned
+   * dirty.
+   *
+   * @param header_page_id the header page of the table
+   * @param key the key to probe for
+   * @param visit called with each block page and index in it
+   * @return whether visit stopped the probe
+   */
+  template <typename Visit>
+  auto Probe(page_id_t header_page_id, const KeyType &key, Visit &&visit) -> bool;
+
+  /**
+   * Inserts a pair into the current table.
+   *
+   * @param check_duplicate whether to look for the pair on the way
+   */
+  auto InsertIntoTable(const KeyType &key, const ValueType &value, bool check_duplicate) -> InsertResult;
+
+  /** Collects the values of a key in the table with the given header page. */
+  auto GetTableValue(page_id_t header_page_id, const KeyType &key, std::vector<ValueType> *result) -> bool;
+
+  /**
+   * Creates an empty table with at least num_slots slots, up to as many as a
+   * header page can list the blocks of, and makes it the current one.
+   */
+  void NewTable(size_t num_slots);
+
+  /** @return whether the current table is more than 3/4 full, counting the pairs still to be moved into it */
+  auto IsCrowded() -> bool;
+
+  /**
+   * Makes room in a crowded table: finishes the resize in progress, or starts
+   * one if the new table would be at most 5/8 full. Called with the write
+   * latch of the table held.
+   *
+   * @return false if there was nothing to do
+   */
+  auto Grow() -> bool;
+
+  /**
+   * Replaces the current table with a new one with at least num_slots slots,
+   * whose pairs are moved over by MigrateBlocks(). Any resize that is in
+   * progress is finished first. Called with the write latch of the table held.
+   */
+  void StartResize(size_t num_slots);
+
+  /**
+   * Moves the pairs of up to num_blocks blocks of the old table into the
+   * current one, and deletes the old table after its last block. Called with
+   * the write latch of the table held.
+   */
+  void MigrateBlocks(size_t num_blocks);
+
+  /** Runs MigrateBlocks() for an insert or remove if a resize is in progress. */
+  void HelpResize();
+
+  auto FetchHeaderPage(page_id_t header_page_id) -> HashTableHeaderPage *;
+
+  auto FetchBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE *;
+
+  auto Hash(const KeyType &key) -> uint64_t;
+
+  // blocks moved by each insert or remove while resizing
+  static constexpr size_t MIGRATE_BLOCKS_PER_OPERATION = 2;
+
   // member variable
   page_id_t header_page_id_;
+  // the table that is being moved into the current one, INVALID_PAGE_ID if none
+  page_id_t old_header_page_id_{INVALID_PAGE_ID};
+  // the number of blocks of the old table that are moved already
+  size_t migrated_blocks_{0};
+  std::atomic<bool> resizing_{false};
+  // the size the table never shrinks below
+  size_t min_size_;
+  // the number of slots of the current table
+  size_t size_{0};
+  // the pairs in both tables, the ones in the old table, and the occupied slots of the current one including tombstones
+  std::atomic<size_t> num_pairs_{0};
+  std::atomic<size_t> num_old_pairs_{0};
+  std::atomic<size_t> num_occupied_{0};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
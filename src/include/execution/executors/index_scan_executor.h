@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 
+#include "catalog/catalog.h"
 #include "common/rid.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -23,7 +25,11 @@
 namespace bustub {
 
 /**
- * IndexScanExecutor executes an index scan over a table.
+ * IndexScanExecutor executes an index scan over a table. It takes the RIDs
+ * from a B+ tree index in batches, in ascending or descending key order, and
+ * looks each tuple up in the table. If the index is covering and holds every
+ * column the scan reads, the scan is index-only and builds the tuples from the
+ * index entries instead.
  */
 
 class IndexScanExecutor : public AbstractExecutor {
@@ -42,7 +48,28 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /** Builds a tuple of the table from an index entry, for index-only scans. */
+  auto TupleFromEntry(const Tuple &entry) -> Tuple;
+
+  /** Number of index entries taken from the index at a time. */
+  static constexpr int BATCH_SIZE = 128;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The index being scanned. */
+  Index *index_{nullptr};
+  /** The table the index is built on. */
+  TableInfo *table_info_{nullptr};
+  /**
+   * Appends the RIDs of the next batch of index entries, and the entries of the RIDs unless given nullptr, returns
+   * false once the index is exhausted.
+   */
+  std::function<bool(std::vector<RID> *, std::vector<Tuple> *)> next_batch_;
+  /** Whether the tuples are built from the index entries alone. */
+  bool index_only_{false};
+  /** RIDs of the current batch, their entries in an index-only scan, and the position in them. */
+  std::vector<RID> rids_;
+  std::vector<Tuple> entries_;
+  size_t cursor_{0};
 };
 }  // namespace bustub
@@ -12,6 +12,10 @@
 
 #pragma once
 
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -19,7 +23,8 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily, or fuzzy
+ * checkpoints that let transactions keep running.
  */
 class CheckpointManager {
  public:
@@ -29,15 +34,30 @@ class CheckpointManager {
         log_manager_(log_manager),
         buffer_pool_manager_(buffer_pool_manager) {}
 
-  ~CheckpointManager() = default;
+  ~CheckpointManager() { WaitForBackgroundFlush(); }
 
   void BeginCheckpoint();
   void EndCheckpoint();
 
+  /**
+   * Take an ARIES-style fuzzy checkpoint. The active transaction table and the dirty page table are written to the
+   * log between a CHECKPOINT_BEGIN and a CHECKPOINT_END record, then the dirty pages are written out by a background
+   * thread. Recovery starts its analysis at the last complete checkpoint and its redo at the smallest recLSN.
+   */
+  void FuzzyCheckpoint();
+
+  /** Wait until the pages of the last fuzzy checkpoint have been written out. */
+  void WaitForBackgroundFlush();
+
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Write out every page of the dirty page table, latching each page so that no half-updated image hits disk. */
+  void FlushDirtyPages(std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table);
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  /** Writes out the dirty pages of the last fuzzy checkpoint. */
+  std::thread flush_thread_;
 };
 
 }  // namespace bustub
@@ -16,6 +16,9 @@
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <utility>
+#include <vector>
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -29,7 +32,10 @@ namespace bustub {
 class LogManager {
  public:
   explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+      : next_lsn_(0),
+        persistent_lsn_(INVALID_LSN),
+        flushed_offset_(disk_manager->GetLogEnd()),
+        disk_manager_(disk_manager) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
   }
@@ -46,7 +52,35 @@ class LogManager {
 
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
+  /**
+   * Wait until every record appended so far is persistent. If force is false the caller only waits for the next
+   * periodic flush (group commit); otherwise the flush thread is woken up immediately.
+   */
+  void Flush(bool force);
+
+  /**
+   * @return a log offset at or before the record with the given lsn. Only valid for records that have been
+   * flushed, or for lsns newer than everything that has been flushed.
+   */
+  auto GetLogOffset(lsn_t lsn) -> log_offset_t;
+
+  /** @return the log offset at which the next appended record will be written */
+  auto GetNextOffset() -> log_offset_t;
+
+  /** Forget offset index entries that are only needed to locate records older than lsn. */
+  void TruncateOffsetIndex(lsn_t lsn);
+
+  /** Point the master record at a complete checkpoint whose CHECKPOINT_BEGIN record is at checkpoint_offset. */
+  inline void WriteMasterRecord(log_offset_t checkpoint_offset) {
+    disk_manager_->WriteMasterRecord(checkpoint_offset);
+  }
+
+  /** Delete the log segments that recovery will no longer read, i.e. those entirely before offset. */
+  inline void TruncateLog(log_offset_t offset) { disk_manager_->TruncateLog(offset); }
+
   inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+  /** Continue the lsn sequence of an existing log, see LogRecovery::GetNextLSN(). Call before appending. */
+  inline void SetNextLSN(lsn_t lsn) { next_lsn_ = lsn; }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
   inline auto GetLogBuffer() -> char * { return log_buffer_; }
@@ -59,16 +93,35 @@ class LogManager {
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
+  /** Swap the log buffer with the flush buffer and write it out. Must be called with latch_ held. */
+  void FlushBuffer(std::unique_lock<std::mutex> *lock);
+
   char *log_buffer_;
   char *flush_buffer_;
+  /** Number of bytes used in log_buffer_. */
+  int log_buffer_offset_{0};
+  /** The lsn of the first record in log_buffer_, INVALID_LSN if it is empty. */
+  lsn_t log_buffer_first_lsn_{INVALID_LSN};
+  /** The lsn of the last record in log_buffer_. */
+  lsn_t log_buffer_last_lsn_{INVALID_LSN};
+  /** The end of the log on disk, i.e. the log offset of log_buffer_. */
+  log_offset_t flushed_offset_;
+  /** (first lsn, log offset) of every flushed chunk since the last call to TruncateOffsetIndex(). */
+  std::vector<std::pair<lsn_t, log_offset_t>> offset_index_;
+  /** True while a flush is being requested or performed. */
+  bool flush_requested_{false};
+  bool flushing_{false};
 
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Wakes up appenders and committers waiting for a flush to finish. */
+  std::condition_variable flushed_cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
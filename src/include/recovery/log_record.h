@@ -13,7 +13,10 @@
 #pragma once
 
 #include <cassert>
+#include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,15 +35,24 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** Start of a fuzzy checkpoint. */
+  CHECKPOINT_BEGIN,
+  /** End of a fuzzy checkpoint, carrying the active transaction table and the dirty page table. */
+  CHECKPOINT_END,
+  /** Update of a tuple that keeps its size, only the changed byte ranges are logged. */
+  DELTAUPDATE,
+  /** Compensation of a change of a loser transaction, written by undo during recovery. */
+  CLR,
 };
 
 /**
  * For every write operation on the table page, you should write ahead a corresponding log record.
  *
- * For EACH log record, HEADER is like (5 fields in common, 20 bytes in total).
- *---------------------------------------------
- * | size | LSN | transID | prevLSN | LogType |
- *---------------------------------------------
+ * For EACH log record, HEADER is like (5 fields in common, each a LEB128 varint, at most 31 bytes in total).
+ *------------------------------------------------------------
+ * | size | LSN | transID + 1 | LSN - prevLSN (0: none) | LogType |
+ *------------------------------------------------------------
+ * size is the length of the whole record including the header, so a zero byte marks the end of the log.
  * For insert type log record
  *---------------------------------------------------------------
  * | HEADER | tuple_rid | tuple_size | tuple_data(char[] array) |
@@ -53,21 +65,50 @@ enum class LogRecordType {
  *-----------------------------------------------------------------------------------
  * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
  *-----------------------------------------------------------------------------------
+ * For delta update type log record, only written when the new tuple has the size of the old one
+ *--------------------------------------------------------------------------------------------------
+ * | HEADER | tuple_rid | tuple_size | range_count | (offset, length, old_bytes, new_bytes) ... |
+ *--------------------------------------------------------------------------------------------------
+ * tuple_size, range_count, offset and length are varints.
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *-------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *-------------------------------------
+ * For checkpoint begin type log record
+ *----------
+ * | HEADER |
+ *----------
+ * For checkpoint end type log record (ATT = active transaction table, DPT = dirty page table)
+ *-----------------------------------------------------------------------------------------------
+ * | HEADER | scan_offset | att_size | (txn_id, last_lsn) ... | dpt_size | (page_id, rec_lsn) ... |
+ *-----------------------------------------------------------------------------------------------
+ * scan_offset (8 bytes) is a log offset at or before the oldest record recovery may need, i.e. the minimum of the
+ * recLSNs in the DPT and of the first LSNs of the transactions in the ATT.
+ * For compensation log record (CLR)
+ *-----------------------------------------------------------------
+ * | HEADER | undo_next_lsn | action_type | body of action_type |
+ *-----------------------------------------------------------------
+ * The action is the change that reverts a record, logged like a record of its own type (INSERT, MARKDELETE,
+ * APPLYDELETE, ROLLBACKDELETE, UPDATE or DELTAUPDATE), so redo repeats it like any other. undo_next_lsn (8 bytes)
+ * is the prevLSN of the reverted record, where undo continues once it reaches the CLR; action_type is a varint.
  */
 class LogRecord {
   friend class LogManager;
   friend class LogRecovery;
 
  public:
+  /** A run of bytes changed by a delta update, with its before and after image. */
+  struct DeltaRange {
+    uint32_t offset_;
+    std::string old_bytes_;
+    std::string new_bytes_;
+  };
+
   LogRecord() = default;
 
   // constructor for Transaction type(BEGIN/COMMIT/ABORT)
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type)
-      : size_(HEADER_SIZE), txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type) {}
+      : size_(MAX_HEADER_SIZE), txn_id_(txn_id), prev_lsn_(prev_lsn), log_record_type_(log_record_type) {}
 
   // constructor for INSERT/DELETE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, const RID &rid, const Tuple &tuple)
@@ -82,7 +123,7 @@ class LogRecord {
       delete_tuple_ = tuple;
     }
     // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
+    size_ = MAX_HEADER_SIZE + sizeof(RID) + sizeof(int32_t) + tuple.GetLength();
   }
 
   // constructor for UPDATE type
@@ -95,19 +136,73 @@ class LogRecord {
         old_tuple_(old_tuple),
         new_tuple_(new_tuple) {
     // calculate log record size
-    size_ = HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
+    size_ = MAX_HEADER_SIZE + sizeof(RID) + old_tuple.GetLength() + new_tuple.GetLength() + 2 * sizeof(int32_t);
+  }
+
+  // constructor for DELTAUPDATE type, old_tuple and new_tuple must have the same length
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, const RID &update_rid, const Tuple &old_tuple, const Tuple &new_tuple)
+      : txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        log_record_type_(LogRecordType::DELTAUPDATE),
+        update_rid_(update_rid),
+        delta_tuple_size_(old_tuple.GetLength()) {
+    assert(old_tuple.GetLength() == new_tuple.GetLength());
+    const char *old_data = old_tuple.GetData();
+    const char *new_data = new_tuple.GetData();
+    uint32_t i = 0;
+    while (i < delta_tuple_size_) {
+      if (old_data[i] == new_data[i]) {
+        i++;
+        continue;
+      }
+      // extend the range over short runs of equal bytes, which are cheaper to repeat than a new range header
+      uint32_t end = i + 1;
+      uint32_t equal_run = 0;
+      while (end < delta_tuple_size_ && equal_run <= DELTA_MERGE_GAP) {
+        equal_run = old_data[end] == new_data[end] ? equal_run + 1 : 0;
+        end++;
+      }
+      end -= equal_run;
+      delta_ranges_.push_back({i, std::string(old_data + i, end - i), std::string(new_data + i, end - i)});
+      i = end;
+    }
+    // calculate log record size
+    size_ = MAX_HEADER_SIZE + sizeof(RID) + VarintSize(delta_tuple_size_) + VarintSize(delta_ranges_.size());
+    for (const auto &range : delta_ranges_) {
+      size_ += VarintSize(range.offset_) + VarintSize(range.old_bytes_.size()) + 2 * range.old_bytes_.size();
+    }
   }
 
   // constructor for NEWPAGE type
   LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType log_record_type, page_id_t prev_page_id, page_id_t page_id)
-      : size_(HEADER_SIZE),
+      : size_(MAX_HEADER_SIZE),
         txn_id_(txn_id),
         prev_lsn_(prev_lsn),
         log_record_type_(log_record_type),
         prev_page_id_(prev_page_id),
         page_id_(page_id) {
     // calculate log record size, header size + sizeof(prev_page_id) + sizeof(page_id)
-    size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
+    size_ = MAX_HEADER_SIZE + sizeof(page_id_t) * 2;
+  }
+
+  // constructor for CHECKPOINT_END type
+  LogRecord(log_offset_t scan_offset, std::vector<std::pair<txn_id_t, lsn_t>> active_txn_table,
+            std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table)
+      : log_record_type_(LogRecordType::CHECKPOINT_END),
+        scan_offset_(scan_offset),
+        active_txn_table_(std::move(active_txn_table)),
+        dirty_page_table_(std::move(dirty_page_table)) {
+    size_ = MAX_HEADER_SIZE + sizeof(log_offset_t) + sizeof(int32_t) * 2 +
+            active_txn_table_.size() * (sizeof(txn_id_t) + sizeof(lsn_t)) +
+            dirty_page_table_.size() * (sizeof(page_id_t) + sizeof(lsn_t));
+  }
+
+  // constructor for CLR type, action is a record of the change that compensates the one with prevLSN undo_next_lsn
+  LogRecord(lsn_t undo_next_lsn, LogRecord &&action) : LogRecord(std::move(action)) {
+    clr_type_ = log_record_type_;
+    log_record_type_ = LogRecordType::CLR;
+    undo_next_lsn_ = undo_next_lsn;
+    size_ += sizeof(lsn_t) + 1;
   }
 
   ~LogRecord() = default;
@@ -126,8 +221,31 @@ class LogRecord {
 
   inline auto GetUpdateRID() -> RID & { return update_rid_; }
 
+  inline auto GetDeltaRanges() -> std::vector<DeltaRange> & { return delta_ranges_; }
+
+  /**
+   * Patch a tuple with the ranges of a DELTAUPDATE record.
+   * @param tuple the tuple to patch in place
+   * @param undo true to write the before images, false to write the after images
+   */
+  inline void ApplyDelta(Tuple *tuple, bool undo) const {
+    assert(tuple->GetLength() == delta_tuple_size_);
+    for (const auto &range : delta_ranges_) {
+      const std::string &bytes = undo ? range.old_bytes_ : range.new_bytes_;
+      memcpy(tuple->GetData() + range.offset_, bytes.data(), bytes.size());
+    }
+  }
+
   inline auto GetNewPageRecord() -> page_id_t { return prev_page_id_; }
 
+  inline auto GetNewPageId() -> page_id_t { return page_id_; }
+
+  inline auto GetScanOffset() -> log_offset_t { return scan_offset_; }
+
+  inline auto GetActiveTxnTable() -> std::vector<std::pair<txn_id_t, lsn_t>> & { return active_txn_table_; }
+
+  inline auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> & { return dirty_page_table_; }
+
   inline auto GetSize() -> int32_t { return size_; }
 
   inline auto GetLSN() -> lsn_t { return lsn_; }
@@ -138,6 +256,54 @@ class LogRecord {
 
   inline auto GetLogRecordType() -> LogRecordType & { return log_record_type_; }
 
+  /** @return the type of the change the record makes to its page, the type of the action for a CLR */
+  inline auto GetActionType() const -> LogRecordType {
+    return log_record_type_ == LogRecordType::CLR ? clr_type_ : log_record_type_;
+  }
+
+  inline auto GetUndoNextLSN() -> lsn_t { return undo_next_lsn_; }
+
+  /** @return the number of bytes EncodeVarint needs for value */
+  static inline auto VarintSize(uint64_t value) -> int {
+    int size = 1;
+    while (value >= 0x80) {
+      value >>= 7;
+      size++;
+    }
+    return size;
+  }
+
+  /**
+   * Write value as a LEB128 varint, 7 bits per byte with the high bit set on every byte but the last.
+   * @return the number of bytes written
+   */
+  static inline auto EncodeVarint(uint64_t value, char *dst) -> int {
+    int size = 0;
+    while (value >= 0x80) {
+      dst[size++] = static_cast<char>((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    dst[size++] = static_cast<char>(value);
+    return size;
+  }
+
+  /**
+   * Read a varint written by EncodeVarint without reading at or past end.
+   * @return the number of bytes read, 0 if the varint is cut off by end or malformed
+   */
+  static inline auto DecodeVarint(const char *src, const char *end, uint64_t *value) -> int {
+    uint64_t result = 0;
+    for (int i = 0; i < MAX_VARINT_SIZE && src + i < end; i++) {
+      auto byte = static_cast<uint8_t>(src[i]);
+      result |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+      if ((byte & 0x80) == 0) {
+        *value = result;
+        return i + 1;
+      }
+    }
+    return 0;
+  }
+
   // For debug purpose
   inline auto ToString() const -> std::string {
     std::ostringstream os;
@@ -152,7 +318,7 @@ class LogRecord {
   }
 
  private:
-  // the length of log record(for serialization, in bytes)
+  // the length of log record(for serialization, in bytes), an upper bound until the record is appended
   int32_t size_{0};
   // must have fields
   lsn_t lsn_{INVALID_LSN};
@@ -173,10 +339,28 @@ class LogRecord {
   Tuple old_tuple_;
   Tuple new_tuple_;
 
+  // case3.1: for delta update operation
+  uint32_t delta_tuple_size_{0};
+  std::vector<DeltaRange> delta_ranges_;
+
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
-  static const int HEADER_SIZE = 20;
+
+  // case5: for checkpoint end operation
+  log_offset_t scan_offset_{0};
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txn_table_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table_;
+
+  // case6: for compensation records
+  LogRecordType clr_type_{LogRecordType::INVALID};
+  lsn_t undo_next_lsn_{INVALID_LSN};
+
+  static const int MAX_VARINT_SIZE = 10;
+  // size and transID take at most 5 bytes each, LSN and prevLSN 10 bytes each, LogType a single byte
+  static const int MAX_HEADER_SIZE = 31;
+  // a delta update range absorbs runs of up to this many unchanged bytes instead of starting a new range
+  static const uint32_t DELTA_MERGE_GAP = 2;
 };  // namespace bustub
 
 }  // namespace bustub
@@ -13,22 +13,33 @@
 #pragma once
 
 #include <algorithm>
+#include <deque>
+#include <functional>
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * If a fuzzy checkpoint has been taken, analysis starts at the last complete checkpoint and rebuilds the active
+ * transaction table and the dirty page table from it; redo then starts at the smallest recLSN instead of the
+ * beginning of the log, and skips records whose page was already clean when they were written.
+ *
+ * Undo reverts the changes of all loser transactions together, from the latest to the earliest. Given a log
+ * manager, it logs a CLR for every change it reverts and an ABORT record for every loser it is done with, so that
+ * recovering again after a crash during or after undo does not revert anything twice.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager = nullptr)
+      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), log_manager_(log_manager), offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
@@ -41,14 +52,45 @@ class LogRecovery {
   void Undo();
   auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
 
+  /** @return the lsn following the last record in the log, to be handed to LogManager::SetNextLSN() after Redo() */
+  inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /**
+   * Rebuild the active transaction table and the dirty page table, starting at the last complete checkpoint.
+   * @return the log offset redo has to start at
+   */
+  auto Analysis() -> log_offset_t;
+
+  /**
+   * Read the log from start_offset to its end, calling visit with every complete record and its offset.
+   * If given, scan_ahead is called with all records of a log buffer before the first of them is visited.
+   */
+  void ScanLog(log_offset_t start_offset, const std::function<void(LogRecord *, log_offset_t)> &visit,
+               const std::function<void(std::deque<LogRecord> *)> &scan_ahead = nullptr);
+
+  /** @return the id of the table page a record modifies, INVALID_PAGE_ID for records that touch no page */
+  static auto GetRecordPageId(LogRecord *log_record) -> page_id_t;
+
+  /** @return the page redo has to look at for this record, INVALID_PAGE_ID if the dirty page table rules it out */
+  auto GetRedoPageId(LogRecord *log_record) -> page_id_t;
+
+  void RedoRecord(LogRecord *log_record);
+  void UndoRecord(LogRecord *log_record);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  /** Where undo logs its CLRs, nullptr to undo without logging. */
+  LogManager *log_manager_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  std::unordered_map<lsn_t, log_offset_t> lsn_mapping_;
+  /** Pages that may be dirty at the time of the crash, with the lsn of the first record that may have dirtied them. */
+  std::unordered_map<page_id_t, lsn_t> dirty_page_table_;
+  /** One past the largest lsn seen in the log. */
+  lsn_t next_lsn_{0};
 
   int offset_ __attribute__((__unused__));
   char *log_buffer_;
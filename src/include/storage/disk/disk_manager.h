@@ -25,14 +25,18 @@ namespace bustub {
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The log is split into segment files of log_segment_size bytes named <db name>.log.<segment number>. Log offsets are
+ * addresses in the concatenation of all segments ever written, so they stay valid when old segments are truncated.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param log_segment_size the size of a log segment file in byte
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, log_offset_t log_segment_size = LOG_SEGMENT_SIZE);
 
   ~DiskManager() = default;
 
@@ -66,10 +70,38 @@ class DiskManager {
    * Read a log entry from the log file.
    * @param[out] log_data output buffer
    * @param size size of the log entry
-   * @param offset offset of the log entry in the file
+   * @param offset offset of the log entry in the log, the read may span several segments
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, log_offset_t offset) -> bool;
+
+  /**
+   * Delete the log segments that lie entirely before offset. The segment holding the end of the log is always kept.
+   * @param offset the oldest log offset that must stay readable
+   */
+  void TruncateLog(log_offset_t offset);
+
+  /** @return the offset of the oldest log byte that is still on disk */
+  auto GetLogStart() -> log_offset_t;
+
+  /** @return the offset one past the last log byte written */
+  auto GetLogEnd() -> log_offset_t;
+
+  /**
+   * Atomically replace the master record, which remembers where the last complete checkpoint begins in the log.
+   * @param checkpoint_offset log offset of the CHECKPOINT_BEGIN record
+   */
+  void WriteMasterRecord(log_offset_t checkpoint_offset);
+
+  /**
+   * Read the master record.
+   * @param[out] checkpoint_offset log offset of the last complete checkpoint
+   * @return true if a checkpoint has been taken on this log, false otherwise
+   */
+  auto ReadMasterRecord(log_offset_t *checkpoint_offset) -> bool;
+
+  /** @return the number of pages the database file holds, the page ids past them have never been written */
+  auto GetNumPages() -> page_id_t;
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -91,9 +123,22 @@ class DiskManager {
 
  private:
   auto GetFileSize(const std::string &file_name) -> int;
-  // stream to write log file
+  /** @return the file name of the given log segment */
+  auto GetLogSegmentName(int64_t segment) -> std::string;
+  // stream to append to the last log segment
   std::fstream log_io_;
+  // the segment log_io_ is open on, -1 if none
+  int64_t log_io_segment_{-1};
+  // base name of the log segments
   std::string log_name_;
+  log_offset_t log_segment_size_;
+  // the oldest segment that has not been truncated
+  int64_t first_log_segment_{0};
+  log_offset_t log_end_{0};
+  // protects the log segments and the fields above
+  std::mutex log_io_latch_;
+  // file holding the master record
+  std::string master_name_;
   // stream to write db file
   std::fstream db_io_;
   std::string file_name_;
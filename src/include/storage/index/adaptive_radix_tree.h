@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree.h
+//
+// Identification: src/include/storage/index/adaptive_radix_tree.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define ADAPTIVE_RADIX_TREE_TYPE AdaptiveRadixTree<KeyType, ValueType, KeyComparator>
+
+/**
+ * Adaptive radix tree (Leis et al., "The Adaptive Radix Tree: ARTful Indexing
+ * for Main-Memory Databases"), one value per key, kept in memory only.
+ *
+ * Keys are normalized (see generic_key.h), so the tree branches on their
+ * bytes one at a time. Inner nodes come in four sizes, for 4, 16, 48 and 256
+ * children, and grow or shrink to the next size as children come and go. A
+ * node stores the bytes that all keys below it share (path compression), and
+ * a child that would be the only key below it is stored as a leaf right away
+ * (lazy expansion). All keys have the same length, so no key is a prefix of
+ * another and leaves only hang off inner nodes.
+ *
+ * Concurrency control is optimistic lock coupling (Leis et al., "The ART of
+ * Practical Synchronization"). Every inner node has a version. Readers never
+ * write to shared memory: they read a node's version before its contents and
+ * restart from the root if it changed afterwards. Writers lock only the nodes
+ * they change, by bumping the version they read, so they restart as well if
+ * a node changed since. A node that is replaced is marked obsolete and freed
+ * once no operation that may still read it is running (see Retire()).
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class AdaptiveRadixTree {
+  enum class NodeType : uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+  struct Node {
+    explicit Node(NodeType type) : type_(type) {}
+    // bit 0: obsolete, bit 1: locked, the rest counts the changes
+    std::atomic<uint64_t> version_{0};
+    const NodeType type_;
+    std::atomic<uint16_t> count_{0};
+    // the key bytes shared by everything below, between the parent's byte and this node's
+    std::atomic<uint8_t> prefix_length_{0};
+    std::atomic<uint8_t> prefix_[sizeof(KeyType)]{};
+  };
+
+  // children sorted by key byte
+  struct Node4 : Node {
+    Node4() : Node(NodeType::NODE4) {}
+    std::atomic<uint8_t> keys_[4]{};
+    std::atomic<Node *> children_[4]{};
+  };
+
+  // children sorted by key byte
+  struct Node16 : Node {
+    Node16() : Node(NodeType::NODE16) {}
+    std::atomic<uint8_t> keys_[16]{};
+    std::atomic<Node *> children_[16]{};
+  };
+
+  // a key byte's child is children_[child_index_[byte] - 1], 0 means none
+  struct Node48 : Node {
+    Node48() : Node(NodeType::NODE48) {}
+    std::atomic<uint8_t> child_index_[256]{};
+    std::atomic<Node *> children_[48]{};
+  };
+
+  struct Node256 : Node {
+    Node256() : Node(NodeType::NODE256) {}
+    std::atomic<Node *> children_[256]{};
+  };
+
+  // a leaf never changes once it is in the tree, child pointers to it are tagged with the lowest bit
+  struct Leaf {
+    KeyType key_;
+    ValueType value_;
+  };
+
+ public:
+  explicit AdaptiveRadixTree(const KeyComparator &comparator);
+  ~AdaptiveRadixTree();
+
+  DISALLOW_COPY_AND_MOVE(AdaptiveRadixTree);
+
+  // Returns true if this tree has no keys and values.
+  auto IsEmpty() const -> bool;
+
+  // Insert a key-value pair into this tree, false if the key is there already.
+  auto Insert(const KeyType &key, const ValueType &value) -> bool;
+
+  // Remove a key and its value from this tree, false if it is not there.
+  auto Remove(const KeyType &key) -> bool;
+
+  // return the value associated with a given key
+  auto GetValue(const KeyType &key, std::vector<ValueType> *result) -> bool;
+
+ private:
+  // each returns false if the operation has to restart
+  auto TryInsert(const KeyType &key, const ValueType &value, bool *inserted) -> bool;
+  auto TryRemove(const KeyType &key, bool *removed) -> bool;
+  auto TryGetValue(const KeyType &key, ValueType *value, bool *found) -> bool;
+
+  // optimistic lock coupling, see the class comment
+  static auto ReadLock(Node *node, uint64_t *version) -> bool;
+  static auto Validate(Node *node, uint64_t version) -> bool;
+  static auto UpgradeToWriteLock(Node *node, uint64_t version) -> bool;
+  static void WriteUnlock(Node *node);
+  static void WriteUnlockObsolete(Node *node);
+
+  // inner node operations, all but FindChild() under the node's write lock
+  static auto FindChild(Node *node, uint8_t byte) -> Node *;
+  static auto IsFull(Node *node) -> bool;
+  static auto IsUnderfull(Node *node) -> bool;
+  static void AddChild(Node *node, uint8_t byte, Node *child);
+  static void ChangeChild(Node *node, uint8_t byte, Node *child);
+  static void RemoveChild(Node *node, uint8_t byte);
+  // the children of the node in key byte order
+  static void Children(Node *node, std::vector<std::pair<uint8_t, Node *>> *children);
+  // the key bytes and children of a Node4 or Node16
+  static auto SortedKeys(Node *node) -> std::atomic<uint8_t> *;
+  static auto SortedChildren(Node *node) -> std::atomic<Node *> *;
+  // a copy of the node with room for one more child, or with one child more than the next smaller size holds
+  static auto Resize(Node *node, bool grow) -> Node *;
+
+  static auto MergePrefix(Node *node, uint8_t byte, Node *child) -> bool;
+
+  // the first position in the node's prefix at which key differs from it, the prefix length if it does not
+  static auto PrefixMismatch(Node *node, const uint8_t *key, size_t depth) -> size_t;
+  static auto KeyBytes(const KeyType &key) -> const uint8_t *;
+
+  static auto IsLeaf(const Node *child) -> bool;
+  static auto ToLeaf(Node *child) -> Leaf *;
+  static auto FromLeaf(Leaf *leaf) -> Node *;
+  static void Free(Node *child);
+  static void FreeSubtree(Node *child);
+
+  // an operation that reads the tree runs between Enter() and Exit()
+  void Enter();
+  void Exit();
+  // free the node or leaf once every operation that may have reached it is done
+  void Retire(Node *child);
+
+  KeyComparator comparator_;
+  // a node 256 that is never replaced, so that every other node has a parent
+  Node256 *root_;
+  // the number of running operations in the lower half, the number of times there was none in the upper half
+  std::atomic<uint64_t> epoch_{0};
+  // nodes and leaves that were taken out of the tree, with the epoch they were taken out in
+  std::vector<std::pair<Node *, uint64_t>> retired_;
+  std::atomic<size_t> retired_size_{0};
+  std::mutex retired_latch_;
+};
+
+}  // namespace bustub
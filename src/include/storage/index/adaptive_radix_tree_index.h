@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree_index.h
+//
+// Identification: src/include/storage/index/adaptive_radix_tree_index.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "storage/index/adaptive_radix_tree.h"
+#include "storage/index/index.h"
+#include "storage/index/posting_list.h"
+
+namespace bustub {
+
+#define ADAPTIVE_RADIX_TREE_INDEX_TYPE AdaptiveRadixTreeIndex<KeyType, ValueType, KeyComparator>
+
+/**
+ * An index for small tables that are read often, kept in memory only (see
+ * adaptive_radix_tree.h), so that lookups go through neither the buffer pool
+ * nor page latches.
+ *
+ * Nothing of the index is written to disk. It is built from the table heap
+ * when it is created, which is also how it comes back after a restart: the
+ * catalog is not persisted either, and creating the index again scans the
+ * heap. A non-unique index keeps the RIDs of keys with several of them in
+ * posting list pages, like a B+ tree index does.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class AdaptiveRadixTreeIndex : public Index {
+ public:
+  AdaptiveRadixTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+ protected:
+  /** Access to the value of index_key for the posting lists of a non-unique index. */
+  auto PostingEntry(const KeyType &index_key) -> PostingList::Entry;
+
+  // comparator for key
+  KeyComparator comparator_;
+  // container
+  AdaptiveRadixTree<KeyType, ValueType, KeyComparator> container_;
+  // RIDs of the keys of a non-unique index
+  PostingList posting_list_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/index/b_epsilon_tree.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "concurrency/transaction.h"
+#include "storage/page/b_epsilon_tree_internal_page.h"
+#include "storage/page/b_epsilon_tree_leaf_page.h"
+
+namespace bustub {
+
+#define B_EPSILON_TREE_TYPE BEpsilonTree<KeyType, ValueType, KeyComparator>
+
+/**
+ * Write optimized B epsilon tree (Brodal and Fagerberg; Bender et al.), one
+ * value per key.
+ *
+ * The internal pages spend a small part of the page on children and the rest
+ * on a buffer of messages. An insert or remove only adds a message to the
+ * buffer of the root, without reading the leaf. When a buffer fills up, the
+ * messages for the child that has the most of them are moved down in one
+ * batch, into the child's buffer or, at the bottom, into the leaves, which
+ * split as they fill up. A page is thus written once per batch of messages
+ * rather than once per key, and random inserts mostly dirty the few pages at
+ * the top of the tree.
+ *
+ * A lookup checks the buffers on the path from the root to the leaf. The
+ * first message it finds for the key is the latest one and decides the
+ * result, only if there is none the leaf does.
+ *
+ * Pages split when they are full but never merge: a remove only ever deletes
+ * the key from the leaf, which may end up empty. Since every write changes
+ * the root, operations are serialized by a latch on the whole tree, which
+ * lookups share.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BEpsilonTree {
+  using InternalPage = BEpsilonTreeInternalPage<KeyType, ValueType, KeyComparator>;
+  using LeafPage = BEpsilonTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using Message = BEpsilonTreeMessage<KeyType, ValueType>;
+
+ public:
+  /**
+   * @param buffer_max_size the number of messages an internal page buffers, 0 for as many as fit next to
+   * internal_max_size children
+   */
+  explicit BEpsilonTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                        int leaf_max_size = B_EPSILON_TREE_LEAF_PAGE_SIZE,
+                        int internal_max_size = B_EPSILON_TREE_INTERNAL_PAGE_SIZE, int buffer_max_size = 0);
+
+  // Returns true if this tree has no pages. A tree whose keys were all removed keeps its pages and is not empty.
+  auto IsEmpty() const -> bool;
+
+  // Set the value of a key, replacing the one it has without looking it up.
+  void Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  // Remove a key and its value, if it has one.
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
+
+ private:
+  void Put(const Message &message);
+
+  void FlushBuffer(InternalPage *node);
+
+  void FlushToInternal(InternalPage *node, int index, InternalPage *child);
+
+  void FlushToLeaf(InternalPage *node, int index, LeafPage *leaf);
+
+  auto Split(BPlusTreePage *node, KeyType *middle_key) -> Page *;
+
+  auto SplitRoot(BPlusTreePage *root) -> InternalPage *;
+
+  auto FetchTreePage(page_id_t page_id) -> Page *;
+
+  auto NewTreePage(page_id_t *page_id) -> Page *;
+
+  void UpdateRootPageId(int insert_record = 0);
+
+  // member variable
+  std::string index_name_;
+  page_id_t root_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  int leaf_max_size_;
+  int internal_max_size_;
+  int buffer_max_size_;
+  // serializes the writes, which all change the root, and is shared by lookups
+  ReaderWriterLatch latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/index/b_epsilon_tree_index.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "storage/index/b_epsilon_tree.h"
+#include "storage/index/index.h"
+#include "storage/index/posting_list.h"
+
+namespace bustub {
+
+#define B_EPSILON_TREE_INDEX_TYPE BEpsilonTreeIndex<KeyType, ValueType, KeyComparator>
+
+/**
+ * An index for tables that take many more inserts than lookups, see
+ * b_epsilon_tree.h. Inserting into a unique index replaces the RID a key has,
+ * since the tree does not look keys up on insert; a non-unique index keeps
+ * posting lists like a B+ tree index does.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BEpsilonTreeIndex : public Index {
+ public:
+  BEpsilonTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+
+  void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+ protected:
+  /** Access to the value of index_key for the posting lists of a non-unique index. */
+  auto PostingEntry(const KeyType &index_key, Transaction *transaction) -> PostingList::Entry;
+
+  // comparator for key
+  KeyComparator comparator_;
+  // container
+  BEpsilonTree<KeyType, ValueType, KeyComparator> container_;
+  // RIDs of the keys of a non-unique index
+  PostingList posting_list_;
+};
+
+}  // namespace bustub
@@ -10,10 +10,12 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <functional>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -23,6 +25,12 @@ namespace bustub {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/** The kind of access a descent is made for, which decides the latch mode and when a node counts as safe. */
+enum class BPlusTreeOperation { FIND, INSERT, REMOVE };
+
+/** How concurrent operations on a tree are synchronized, see BPlusTree. */
+enum class BPlusTreeMode { LATCH_CRABBING, B_LINK };
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
@@ -32,6 +40,19 @@ namespace bustub {
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency control is optimistic latch crabbing. Lookups and writes that fit into their leaf descend with read
+ * latches and only write latch the leaf, so concurrent writers to different leaves never block each other on the
+ * root. Only when the leaf would split or underflow is the operation restarted with pessimistic crabbing, which
+ * write latches the path and releases all ancestors whenever it reaches a node that is safe for the operation.
+ *
+ * In B-link mode (Lehman and Yao) every page instead links to its right sibling and carries a high key, the smallest
+ * key that may no longer be found below it. An operation that lands on a page whose high key is not above its key
+ * knows the page was split after it read the pointer to it, and moves right instead of restarting. No operation ever
+ * holds more than one page latch: a split links the new page to its left half, releases it and only then latches the
+ * parent, which it remembers from the descent and reaches again by moving right. Deletes only ever remove from the
+ * leaf and never merge, so pages are not freed and may run below min size. A tree must always be opened in the mode
+ * it was built in.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -40,9 +61,11 @@ class BPlusTree {
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     BPlusTreeMode mode = BPlusTreeMode::LATCH_CRABBING);
 
-  // Returns true if this B+ tree has no keys and values.
+  // Returns true if this B+ tree has no keys and values. In B-link mode a tree that emptied out keeps its pages and
+  // is not empty.
   auto IsEmpty() const -> bool;
 
   // Insert a key-value pair into this B+ tree.
@@ -58,6 +81,20 @@ class BPlusTree {
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
   auto End() -> INDEXITERATOR_TYPE;
+  // index iterator over the keys in [low, high), unbounded on the side whose key is nullptr
+  auto Begin(const KeyType *low, const KeyType *high) -> INDEXITERATOR_TYPE;
+
+  // split [low, high) into up to count sub-ranges of about the same size, at keys of the upper internal levels
+  auto PartitionRange(const KeyType *low, const KeyType *high, int count) -> std::vector<KeyType>;
+
+  // scan the sub-ranges of [low, high) on a thread each, passing the sub-range's number and own iterator to worker
+  void ParallelScan(const KeyType *low, const KeyType *high, int count,
+                    const std::function<void(int, INDEXITERATOR_TYPE *)> &worker);
+
+  // reverse index iterator, from the greatest key (or the greatest one not above key) down to the smallest
+  auto RBegin() -> INDEXITERATOR_TYPE;
+  auto RBegin(const KeyType &key) -> INDEXITERATOR_TYPE;
+  auto REnd() -> INDEXITERATOR_TYPE;
 
   // print the B+ tree
   void Print(BufferPoolManager *bpm);
@@ -65,15 +102,92 @@ class BPlusTree {
   // draw the B+ tree
   void Draw(BufferPoolManager *bpm, const std::string &outf);
 
-  // read data from file and insert one by one
+  // build an empty tree bottom-up from key & value pairs produced in ascending key order
+  auto BulkLoad(const std::function<bool(KeyType *, ValueType *)> &next_entry, double fill_factor = 1.0) -> bool;
+
+  // insert key & value pairs produced in any order, external sorting and bulk loading them if the tree is empty
+  void BulkInsert(const std::function<bool(KeyType *, ValueType *)> &next_entry, double fill_factor = 1.0,
+                  Transaction *transaction = nullptr);
+
+  // read data from file and insert them, bulk loading if the tree is empty
   void InsertFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
-  // expose for test purpose
+  // expose for test purpose; the returned leaf is pinned and read latched
   auto FindLeafPage(const KeyType &key, bool leftMost = false) -> Page *;
 
  private:
+  auto FindRightmostLeafPage() -> Page *;
+
+  // an iterator over the leaf held in page, see IndexIterator for bound
+  auto MakeIterator(Page *page, int index, const KeyType *bound, bool reverse) -> INDEXITERATOR_TYPE;
+
+  auto CollectSeparators(Page *page, int depth, const KeyType *low, const KeyType *high,
+                         std::vector<KeyType> *separators) -> bool;
+
+  auto FindLeafPageOptimistic(const KeyType &key, BPlusTreeOperation op) -> Page *;
+
+  auto FindLeafPagePessimistic(const KeyType &key, BPlusTreeOperation op, Transaction *transaction) -> Page *;
+
+  auto IsSafe(BPlusTreePage *node, BPlusTreeOperation op, const KeyType &key) const -> bool;
+
+  auto FindLeafPageBLink(const KeyType &key, bool leftMost, bool exclusive, std::vector<page_id_t> *path) -> Page *;
+
+  auto MoveRight(Page *page, const KeyType &key, bool exclusive) -> Page *;
+
+  auto RightSiblingFor(BPlusTreePage *node, const KeyType &key) const -> page_id_t;
+
+  template <typename N>
+  void LinkRight(N *node, N *right_node, const KeyType &high_key);
+
+  void LinkBack(page_id_t page_id, page_id_t prev_page_id);
+
+  auto InsertBLink(const KeyType &key, const ValueType &value) -> bool;
+
+  void InsertIntoParentBLink(Page *page, const KeyType &key, page_id_t new_page_id, std::vector<page_id_t> *path);
+
+  void RemoveBLink(const KeyType &key);
+
+  auto Separator(const KeyType &left, const KeyType &right) const -> KeyType;
+
+  void ReleaseLatchedPages(Transaction *transaction, bool is_dirty);
+
+  auto FetchTreePage(page_id_t page_id) -> Page *;
+
+  auto NewTreePage(page_id_t *page_id) -> Page *;
+
+  /**
+   * Bulk loading state. Each level keeps its two rightmost pages pinned: `pending_` is filled up but not yet linked
+   * into its parent, so that it can still give entries to an underfull `current_` when the input ends.
+   */
+  struct BulkLoadLevel {
+    Page *pending_{nullptr};
+    Page *current_{nullptr};
+  };
+  struct BulkLoadContext {
+    std::vector<BulkLoadLevel> levels_;
+    int leaf_fill_;
+    int internal_fill_;
+    // last key of the leaf linked into its parent most recently
+    KeyType last_leaf_key_;
+    bool linked_leaf_{false};
+  };
+
+  void BulkLoadLeaf(BulkLoadContext *context, const KeyType &key, const ValueType &value);
+
+  void BulkLoadInternal(BulkLoadContext *context, size_t level, const KeyType &key, page_id_t child_page_id);
+
+  void BulkLoadShift(BulkLoadContext *context, size_t level, Page *page);
+
+  void BulkLoadPushUp(BulkLoadContext *context, size_t level, Page *page, Page *right_page);
+
+  auto BulkLoadRebalance(Page *pending_page, Page *current_page) -> bool;
+
+  void BulkLoadFinish(BulkLoadContext *context);
+
+  void DeleteSubtree(page_id_t page_id);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
@@ -92,7 +206,10 @@ class BPlusTree {
                 int index, Transaction *transaction = nullptr) -> bool;
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void Redistribute(N *neighbor_node, N *node, int index, Transaction *transaction = nullptr);
+
+  void ReplaceSeparator(InternalPage *parent, int index, BPlusTreePage *left, BPlusTreePage *right,
+                        const KeyType &key, Transaction *transaction);
 
   auto AdjustRoot(BPlusTreePage *node) -> bool;
 
@@ -110,6 +227,9 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  bool b_link_;
+  // guards root_page_id_; a nullptr entry in a transaction's page set stands for this latch held in write mode
+  ReaderWriterLatch root_latch_;
 };
 
 }  // namespace bustub
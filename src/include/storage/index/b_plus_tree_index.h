@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -18,6 +19,7 @@
 
 #include "storage/index/b_plus_tree.h"
 #include "storage/index/index.h"
+#include "storage/index/posting_list.h"
 
 namespace bustub {
 
@@ -30,6 +32,8 @@ class BPlusTreeIndex : public Index {
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  void InsertEntries(const std::function<bool(Tuple *, RID *)> &next_entry, Transaction *transaction) override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
@@ -40,11 +44,33 @@ class BPlusTreeIndex : public Index {
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  auto GetReverseBeginIterator() -> INDEXITERATOR_TYPE;
+
+  auto GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
+
+  auto GetReverseEndIterator() -> INDEXITERATOR_TYPE;
+
+  /** Appends the RIDs that the value of an entry the iterators return stands for to result. */
+  void ExpandValue(const ValueType &value, std::vector<RID> *result);
+
  protected:
+  /** Access to the value of index_key for the posting lists of a non-unique index. */
+  auto PostingEntry(const KeyType &index_key, Transaction *transaction) -> PostingList::Entry;
+
+  /** Insert and delete for a covering index, which keeps the included columns in its keys. */
+  void InsertCovered(const Tuple &key, RID rid, Transaction *transaction);
+  void DeleteCovered(const Tuple &key, RID rid, Transaction *transaction);
+  /** Appends the entries of a covering index whose key columns equal those of key to entries. */
+  void CoveredEntries(const Tuple &key, std::vector<MappingType> *entries);
+
   // comparator for key
   KeyComparator comparator_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
+  // RIDs of the keys of a non-unique index
+  PostingList posting_list_;
+  // serializes the inserts into a unique covering index
+  ReaderWriterLatch covering_latch_;
 };
 
 }  // namespace bustub
@@ -20,6 +20,7 @@
 #include "container/hash/extendible_hash_table.h"
 #include "container/hash/hash_function.h"
 #include "storage/index/index.h"
+#include "storage/index/posting_list.h"
 
 namespace bustub {
 
@@ -28,8 +29,10 @@ namespace bustub {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTableIndex : public Index {
  public:
+  // The container records its directory page in the header page, like a B+ tree index records its root. It opens the
+  // index the header page records under its name instead of creating one when open_existing is set.
   ExtendibleHashTableIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
-                           const HashFunction<KeyType> &hash_fn);
+                           const HashFunction<KeyType> &hash_fn, bool open_existing = false);
 
   ~ExtendibleHashTableIndex() override = default;
 
@@ -40,10 +43,15 @@ class ExtendibleHashTableIndex : public Index {
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
  protected:
+  /** Access to the value of index_key for the posting lists of a non-unique index. */
+  auto PostingEntry(const KeyType &index_key, Transaction *transaction) -> PostingList::Entry;
+
   // comparator for key
   KeyComparator comparator_;
   // container
   ExtendibleHashTable<KeyType, ValueType, KeyComparator> container_;
+  // RIDs of the keys of a non-unique index
+  PostingList posting_list_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.h
+//
+// Identification: src/include/storage/index/external_sort.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define EXTERNAL_SORT_TYPE ExternalSort<KeyType, ValueType, KeyComparator>
+
+/**
+ * Sorts key & value pairs that do not have to fit in memory, e.g. the entries of an index that is bulk loaded.
+ *
+ * Pairs are buffered until `run_size` of them are collected, sorted and spilled as a run of buffer pool pages.
+ * Sort() merges the runs `fan_in` at a time until at most `fan_in` are left, which Next() then merges on the fly
+ * while streaming the pairs out in ascending key order. If everything fits into one run nothing is spilled.
+ *
+ * Run page format (pairs are stored in order, runs are chained through NextPageId):
+ *  ---------------------------------------------------------------------------
+ * | NextPageId (4) | Count (4) | KEY(1) + VALUE(1) | ... | KEY(n) + VALUE(n) |
+ *  ---------------------------------------------------------------------------
+ * Run pages are deleted from the buffer pool as soon as they have been read back.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class ExternalSort {
+ public:
+  /** Number of pairs sorted in memory before a run is spilled. */
+  static constexpr size_t DEFAULT_RUN_SIZE = 1 << 16;
+  /** Number of runs merged at once; each pins one page while merging. */
+  static constexpr size_t DEFAULT_FAN_IN = 8;
+
+  ExternalSort(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+               size_t run_size = DEFAULT_RUN_SIZE, size_t fan_in = DEFAULT_FAN_IN);
+  ~ExternalSort();
+
+  DISALLOW_COPY_AND_MOVE(ExternalSort);
+
+  /** Adds a pair to the input. Must not be called after Sort(). */
+  void Add(const KeyType &key, const ValueType &value);
+
+  /** Ends the input and prepares the sorted output. */
+  void Sort();
+
+  /**
+   * Produces the next pair in ascending key order. Must only be called after Sort().
+   * @return false once all pairs have been returned
+   */
+  auto Next(KeyType *key, ValueType *value) -> bool;
+
+  /** @return the number of runs that were spilled to the buffer pool */
+  auto GetRunCount() const -> size_t { return spilled_runs_; }
+
+ private:
+  /** Sequential reader over a run that frees each page once it has been consumed. */
+  struct RunReader {
+    page_id_t page_id_;
+    Page *page_;
+    int index_;
+  };
+
+  /** Appends pairs to a run, chaining in new pages as they fill up. */
+  class RunWriter {
+   public:
+    explicit RunWriter(ExternalSort *sorter) : sorter_(sorter) {}
+    void Append(const MappingType &item);
+    /** @return the first page of the run */
+    auto Finish() -> page_id_t;
+
+   private:
+    ExternalSort *sorter_;
+    page_id_t first_page_id_{INVALID_PAGE_ID};
+    Page *page_{nullptr};
+  };
+
+  auto Less(const MappingType &a, const MappingType &b) const -> bool { return comparator_(a.first, b.first) < 0; }
+
+  void SpillRun();
+  auto MergeRuns(const std::vector<page_id_t> &runs) -> page_id_t;
+
+  void OpenReaders(const std::vector<page_id_t> &runs);
+  auto PopMin(MappingType *item) -> bool;
+  auto ReaderGreater(size_t a, size_t b) const -> bool;
+  void AdvanceReader(RunReader *reader);
+  void CloseReaders();
+
+  void DeleteRun(page_id_t page_id);
+
+  static auto GetNextPageId(Page *page) -> page_id_t;
+  static void SetNextPageId(Page *page, page_id_t next_page_id);
+  static auto GetCount(Page *page) -> int;
+  static void SetCount(Page *page, int count);
+  static auto GetItems(Page *page) -> MappingType *;
+
+  static constexpr size_t RUN_PAGE_HEADER_SIZE = 2 * sizeof(int32_t);
+  static constexpr int RUN_PAGE_CAPACITY = (PAGE_SIZE - RUN_PAGE_HEADER_SIZE) / sizeof(MappingType);
+
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  size_t run_size_;
+  size_t fan_in_;
+  bool sorted_{false};
+  size_t spilled_runs_{0};
+
+  /** Unsorted input of the current run, or the whole sorted output if nothing was spilled. */
+  std::vector<MappingType> buffer_;
+  size_t buffer_pos_{0};
+  /** First pages of the runs that still have to be merged. */
+  std::vector<page_id_t> runs_;
+  /** Readers of the merge in progress, and a min-heap of indexes into them ordered by their current pair. */
+  std::vector<RunReader> readers_;
+  std::vector<size_t> heap_;
+};
+
+}  // namespace bustub
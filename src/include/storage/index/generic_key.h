@@ -14,6 +14,7 @@
 
 #include <cstring>
 
+#include "storage/index/key_normalizer.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -24,46 +25,51 @@ namespace bustub {
  *
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
- * with a template argument.
+ * with a template argument. The columns are stored normalized (see
+ * KeyNormalizer) and zero padded, so keys compare with a single memcmp.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  // returns the length of the encoded columns, which is more than KeySize if they were cut short
+  inline auto SetFromKey(const Tuple &tuple, const Schema *key_schema) -> size_t {
     // intialize to 0
     memset(data_, 0, KeySize);
-    assert(data_ != nullptr);
     assert(tuple.GetData() != nullptr);
-    // std::cout << "length of tuple is " << tuple.GetLength() << std::endl;
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    size_t offset = 0;
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      KeyNormalizer::Encode(tuple.GetValue(key_schema, i), data_, KeySize, &offset);
+    }
+    return offset;
   }
 
   // NOTE: for test purpose only
+  // set the key to a single bigint column
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    size_t offset = 0;
+    KeyNormalizer::Encode(Value(TypeId::BIGINT, key), data_, KeySize, &offset);
   }
 
   inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    // columns before this one have to be decoded to find where it starts
+    size_t offset = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      KeyNormalizer::Decode(schema->GetColumn(i).GetType(), data_, KeySize, &offset);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return KeyNormalizer::Decode(schema->GetColumn(column_idx).GetType(), data_, KeySize, &offset);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline auto ToString() const -> int64_t { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the first 8 bytes as a bigint column
+  inline auto ToString() const -> int64_t {
+    size_t offset = 0;
+    Value key = KeyNormalizer::Decode(TypeId::BIGINT, data_, KeySize, &offset);
+    return key.GetAs<int64_t>();
+  }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // interpret the first 8 bytes as a bigint column
   friend auto operator<<(std::ostream &os, const GenericKey &key) -> std::ostream & {
     os << key.ToString();
     return os;
@@ -79,22 +85,9 @@ class GenericKey {
 template <size_t KeySize>
 class GenericComparator {
  public:
+  // normalized keys order like their columns, and NULLs compare equal to each other
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
-    uint32_t column_count = key_schema_->GetColumnCount();
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
-        return -1;
-      }
-      if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
+    return memcmp(lhs.data_, rhs.data_, KeySize);
   }
 
   GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -43,14 +44,26 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param unique Whether the index maps each key to a single RID; a non-unique index keeps a posting list per key
+   * @param include_attrs The mapping from included (non-key) columns to base table columns, which a covering index
+   * stores with every entry
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, bool unique = true, const std::vector<uint32_t> &include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        unique_(unique),
+        entry_attrs_(key_attrs_) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs.begin(), include_attrs.end());
+    entry_schema_ = Schema::CopySchema(tuple_schema, entry_attrs_);
   }
 
-  ~IndexMetadata() { delete key_schema_; }
+  ~IndexMetadata() {
+    delete key_schema_;
+    delete entry_schema_;
+  }
 
   /** @return The name of the index */
   inline auto GetName() const -> const std::string & { return name_; }
@@ -72,6 +85,21 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return key_attrs_; }
 
+  /** @return Whether the index maps each key to a single RID */
+  inline auto IsUnique() const -> bool { return unique_; }
+
+  /** @return Whether the index stores included columns besides the key */
+  inline auto IsCovering() const -> bool { return entry_attrs_.size() > key_attrs_.size(); }
+
+  /**
+   * @return A schema object pointer that represents an index entry: the key columns followed by the included ones. It
+   * equals the key schema unless the index is covering.
+   */
+  inline auto GetEntrySchema() const -> Schema * { return entry_schema_; }
+
+  /** @return The mapping relation between entry columns and base table columns */
+  inline auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return entry_attrs_; }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -92,8 +120,14 @@ class IndexMetadata {
   std::string table_name_;
   /** The mapping relation between key schema and tuple schema */
   const std::vector<uint32_t> key_attrs_;
+  /** Whether the index maps each key to a single RID */
+  const bool unique_;
+  /** The mapping relation between entry schema and tuple schema */
+  std::vector<uint32_t> entry_attrs_;
   /** The schema of the indexed key */
   Schema *key_schema_;
+  /** The schema of the indexed key and the included columns */
+  Schema *entry_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -139,6 +173,12 @@ class Index {
   /** @return The index key attributes */
   auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetKeyAttrs(); }
 
+  /** @return The index entry schema, the key schema followed by the included columns */
+  auto GetEntrySchema() const -> Schema * { return metadata_->GetEntrySchema(); }
+
+  /** @return The index entry attributes */
+  auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetEntryAttrs(); }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -153,15 +193,29 @@ class Index {
 
   /**
    * Insert an entry into the index.
-   * @param key The index key
+   * @param key The index key, with the included columns after it (see GetEntrySchema())
    * @param rid The RID associated with the key (unused)
    * @param transaction The transaction context
    */
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  /**
+   * Insert a batch of entries, e.g. every tuple of the table an index is created on. The default inserts them one by
+   * one; indexes that can be built faster from a whole batch override it.
+   * @param next_entry Produces the next index key and RID, returns false once the batch is exhausted
+   * @param transaction The transaction context
+   */
+  virtual void InsertEntries(const std::function<bool(Tuple *, RID *)> &next_entry, Transaction *transaction) {
+    Tuple key;
+    RID rid;
+    while (next_entry(&key, &rid)) {
+      InsertEntry(key, rid, transaction);
+    }
+  }
+
   /**
    * Delete an index entry by key.
-   * @param key The index key
+   * @param key The index key, the included columns after it are not needed
    * @param rid The RID associated with the key (unused)
    * @param transaction The transaction context
    */
@@ -13,6 +13,10 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <functional>
+#include <future>  // NOLINT
+
+#include "common/macros.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -21,9 +25,25 @@ namespace bustub {
 
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  /** Constructs an end iterator. */
   IndexIterator();
+  /**
+   * Constructs an iterator positioned at `index` of the leaf held in `page`. The iterator takes over the caller's pin
+   * and read latch on the page and releases them once it moves past the leaf or is destroyed. A forward iterator
+   * becomes an end iterator at the first key that is not less than `bound`, if given. A reverse iterator moves from
+   * greater keys to smaller ones, and skips to the greatest key below `bound`, if given, when `index` is before the
+   * start of the leaf. `find_leaf` descends from the root to the leaf a key belongs to, or to the rightmost leaf for
+   * nullptr, and returns it pinned and read latched; the iterator uses it to find its place again after a batch, and
+   * a reverse one also when the leaves around it changed while it was moving left.
+   */
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, const KeyType *bound,
+                const KeyComparator &comparator, std::function<Page *(const KeyType *)> find_leaf, bool reverse);
+  IndexIterator(IndexIterator &&that) noexcept;
+  auto operator=(IndexIterator &&that) noexcept -> IndexIterator &;
+  DISALLOW_COPY(IndexIterator);
   ~IndexIterator();  // NOLINT
 
   auto IsEnd() -> bool;
@@ -32,12 +52,63 @@ class IndexIterator {
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  /**
+   * Copies up to `max_count` pairs from the current position into `items` and moves past them, a leaf's slice at a
+   * time. Once the scan nears the end of a leaf, the leaves after it are read into the buffer pool in the background.
+   * The iterator then gives up its latch and pin, so the caller may change the tree between batches, and descends
+   * from the root again to the pair after the last one copied when it is used next.
+   * @return the number of pairs copied, 0 only once the iterator is at the end
+   */
+  auto NextBatch(MappingType *items, int max_count) -> int;
+  /**
+   * Same as above, but stops before the first key that is not less than `end_key`, and becomes an end iterator there.
+   * An iterator with an end key of its own stops there in any case. Forward iterators only.
+   */
+  auto NextBatch(MappingType *items, int max_count, const KeyType &end_key, const KeyComparator &comparator) -> int;
+
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return GetPageId() == itr.GetPageId() && index_ == itr.index_ && parked_ == itr.parked_;
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  auto GetPageId() const -> page_id_t { return page_ == nullptr ? INVALID_PAGE_ID : page_->GetPageId(); }
+  /** Moves right along the leaf chain until the position is valid or the chain or the end key is reached. */
+  void SkipExhaustedLeaves();
+  /** Moves left along the leaf chain until the position is valid or the chain ends, for reverse iterators. */
+  void SkipExhaustedLeavesBackward();
+  void Release();
+  /** Releases the current leaf between batches, remembering the last key returned. */
+  void Park();
+  /** Descends to the leaf of the pair after the last key returned, if the iterator is parked. */
+  void Resume();
+  auto CopyBatch(MappingType *items, int max_count, const KeyType *end_key, const KeyComparator *comparator) -> int;
+  /** Starts reading the leaves after the current one in the background, unless that is already done or underway. */
+  void ReadAhead();
+
+  /** Number of leaves a read ahead brings into the buffer pool. */
+  static constexpr int READ_AHEAD_LEAVES = 4;
+
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  Page *page_{nullptr};
+  LeafPage *leaf_{nullptr};
+  int index_{0};
+  // leaves store compressed keys, so the current pair is decoded here
+  MappingType item_;
+  // leaves right of the current one that a read ahead has covered or is covering
+  int leaves_ahead_{0};
+  std::future<void> read_ahead_;
+  // a reverse iterator returns the keys below bound_ next, which is the last key it returned, if any; a forward one
+  // ends at bound_, if it is bounded
+  bool reverse_{false};
+  const KeyComparator *comparator_{nullptr};
+  std::function<Page *(const KeyType *)> find_leaf_;
+  KeyType bound_;
+  bool bounded_{false};
+  // a parked iterator holds no leaf and goes on above last_key_, or below bound_ for a reverse one
+  bool parked_{false};
+  KeyType last_key_;
 };
 
 }  // namespace bustub
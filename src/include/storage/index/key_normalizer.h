@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer.h
+//
+// Identification: src/include/storage/index/key_normalizer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * KeyNormalizer encodes values into a byte string that sorts with memcmp in
+ * the same order as the values themselves, so that index keys compare
+ * without deserializing any column.
+ *
+ * - integers and booleans are stored big-endian with the sign bit flipped
+ * - decimals are stored big-endian with the sign bit flipped if positive and
+ *   all bits flipped if negative
+ * - timestamps are stored big-endian
+ * - varchars are stored as a 0x01 marker (0x00 if NULL), the characters with
+ *   every 0x00 escaped as 0x00 0xFF, and a 0x00 0x00 terminator
+ *
+ * NULL integers, booleans and decimals are stored as their type's smallest
+ * value and NULL varchars by their marker, so they sort before everything
+ * else; NULL timestamps are the largest timestamp and sort last. Encodings of
+ * consecutive columns are concatenated, and a key is cut short once it runs
+ * out of space, which keeps the order of the bytes that do fit.
+ */
+class KeyNormalizer {
+ public:
+  /**
+   * Encode value at data + offset and advance offset past it.
+   * @param value the value to encode
+   * @param data the key being built
+   * @param size the size of the key, bytes beyond it are dropped
+   * @param offset[in,out] where the value starts, on return where the next one does
+   */
+  static void Encode(const Value &value, char *data, size_t size, size_t *offset);
+
+  /**
+   * Decode a value of the given type at data + offset and advance offset past it.
+   * Bytes beyond the size of the key read as zero.
+   */
+  static auto Decode(TypeId type_id, const char *data, size_t size, size_t *offset) -> Value;
+};
+
+}  // namespace bustub
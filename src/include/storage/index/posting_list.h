@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list.h
+//
+// Identification: src/include/storage/index/posting_list.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
+#include "storage/page/posting_list_page.h"
+
+namespace bustub {
+
+/**
+ * The RIDs of the keys of a non-unique index.
+ *
+ * The index container keeps one value per key: the key's RID while it has a
+ * single one, and a reference to a chain of posting list pages holding all of
+ * its RIDs once it has more. A reference is a RID whose slot number is
+ * POSTING_LIST_SLOT and whose page id is the head page of the chain. A key
+ * keeps its posting list until the last RID is removed.
+ *
+ * Adding or removing a RID of a key that already has a posting list only
+ * latches the list's head page, under a shared latch on the whole index;
+ * changing the value the container keeps for a key takes the latch
+ * exclusively. Only the head latch guards the rest of the chain.
+ */
+class PostingList {
+ public:
+  /** The slot number that marks an index value as a reference to a posting list. */
+  static constexpr uint32_t POSTING_LIST_SLOT = UINT32_MAX;
+
+  /** Access to the value the index container keeps for one key. */
+  struct Entry {
+    /** Returns false if the container has no value for the key. */
+    std::function<bool(RID *value)> get_;
+    /** Stores a value for the key, which has none. */
+    std::function<void(const RID &value)> put_;
+    /** Removes the value of the key. */
+    std::function<void(const RID &value)> erase_;
+  };
+
+  explicit PostingList(BufferPoolManager *buffer_pool_manager);
+
+  static auto IsPostingList(const RID &value) -> bool { return value.GetSlotNum() == POSTING_LIST_SLOT; }
+
+  /** Adds rid to the RIDs of the key, unless it is there already. */
+  void Insert(const Entry &entry, const RID &rid);
+  /** Removes rid from the RIDs of the key, if it is there. */
+  void Remove(const Entry &entry, const RID &rid);
+  /** Appends the RIDs of the key to result, sorted if there is a posting list. */
+  void Scan(const Entry &entry, std::vector<RID> *result);
+
+  /**
+   * Appends the RIDs that a value read from the container stands for to result. Unlike the other operations this
+   * does not latch the index, so it can be called while holding latches of the container. A list that was dropped
+   * after the value was read is seen as empty.
+   */
+  void Expand(const RID &value, std::vector<RID> *result);
+
+ private:
+  auto Create(const std::vector<RID> &rids) -> page_id_t;
+  void InsertInto(page_id_t head_page_id, const RID &rid);
+  void RemoveFrom(page_id_t head_page_id, const RID &rid);
+  void ScanList(page_id_t head_page_id, std::vector<RID> *result);
+  auto IsEmpty(page_id_t head_page_id) -> bool;
+  void Drop(page_id_t head_page_id);
+  auto FetchListPage(page_id_t page_id) -> Page *;
+
+  BufferPoolManager *buffer_pool_manager_;
+  ReaderWriterLatch latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_epsilon_tree_internal_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <utility>
+
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_EPSILON_TREE_INTERNAL_PAGE_TYPE BEpsilonTreeInternalPage<KeyType, ValueType, KeyComparator>
+#define B_EPSILON_TREE_INTERNAL_PAGE_HEADER_SIZE 40
+#define B_EPSILON_TREE_PIVOT_SIZE sizeof(std::pair<KeyType, page_id_t>)
+#define B_EPSILON_TREE_MESSAGE_SIZE sizeof(BEpsilonTreeMessage<KeyType, ValueType>)
+// number of messages that fit into an internal page next to max_size children
+#define B_EPSILON_TREE_BUFFER_SIZE(max_size)                                                        \
+  static_cast<int>((PAGE_SIZE - B_EPSILON_TREE_INTERNAL_PAGE_HEADER_SIZE -                         \
+                    static_cast<size_t>(max_size) * B_EPSILON_TREE_PIVOT_SIZE) / B_EPSILON_TREE_MESSAGE_SIZE)
+// the children take about the square root of the page, that is epsilon = 1/2
+#define B_EPSILON_TREE_INTERNAL_PAGE_SIZE \
+  BEpsilonTreeFanout((PAGE_SIZE - B_EPSILON_TREE_INTERNAL_PAGE_HEADER_SIZE) / B_EPSILON_TREE_MESSAGE_SIZE)
+
+/** What a buffered message does to its key once it reaches the leaf. */
+enum class BEpsilonTreeMessageType : int32_t { UPSERT = 0, DELETE };
+
+/** A write to one key that has not reached its leaf yet. */
+template <typename KeyType, typename ValueType>
+struct BEpsilonTreeMessage {
+  KeyType key_;
+  ValueType value_;
+  BEpsilonTreeMessageType type_;
+};
+
+/** The largest fanout whose square does not exceed the number of messages a page could hold, and at least 3. */
+constexpr auto BEpsilonTreeFanout(size_t page_messages) -> int {
+  int fanout = 3;
+  while (static_cast<size_t>((fanout + 1) * (fanout + 1)) <= page_messages) {
+    fanout++;
+  }
+  return fanout;
+}
+
+/**
+ * Store n indexed keys and n+1 child pointers (page_id) like a B+ tree
+ * internal page (see b_plus_tree_internal_page.h), the first key invalid, and
+ * a buffer of the messages for the subtree that have not been flushed to the
+ * children yet.
+ *
+ * The messages are sorted by key, with at most one per key: a newer message
+ * replaces the one the buffer has. The messages for a child are the ones
+ * between its key and the next one, so they make a contiguous range.
+ *
+ * Internal page format:
+ *  ------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) + PAGE_ID(1) | ... | KEY(max) + PAGE_ID(max) | MESSAGE(1) | ... | MESSAGE(m) |
+ *  ------------------------------------------------------------------------------------------
+ *
+ * The children take max size slots, whatever the current size, and the
+ * buffer starts right after them.
+ *
+ * Header format (size in byte, 40 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | MinSize (4) | LSN (8) | CurrentSize (4) | MaxSize (4) |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | BufferSize (4) | BufferMaxSize (4) |
+ *  ---------------------------------------------------------------------
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BEpsilonTreeInternalPage : public BPlusTreePage {
+  using Message = BEpsilonTreeMessage<KeyType, ValueType>;
+
+ public:
+  // must call initialize method after "create" a new node
+  void Init(page_id_t page_id, int max_size = B_EPSILON_TREE_INTERNAL_PAGE_SIZE,
+            int buffer_max_size = B_EPSILON_TREE_BUFFER_SIZE(B_EPSILON_TREE_INTERNAL_PAGE_SIZE));
+
+  auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> page_id_t;
+  /** @return the index of the child whose subtree key belongs to */
+  auto ChildIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+
+  void PopulateNewRoot(page_id_t old_value, const KeyType &new_key, page_id_t new_value);
+  /** Inserts new_key and new_value as the child after the one at index. */
+  void InsertChildAfter(int index, const KeyType &new_key, page_id_t new_value);
+
+  auto GetBufferSize() const -> int;
+  auto GetBufferMaxSize() const -> int;
+  auto IsBufferFull() const -> bool;
+  auto MessageAt(int index) const -> const Message &;
+  /** @return the message for key, or nullptr if the buffer has none */
+  auto FindMessage(const KeyType &key, const KeyComparator &comparator) const -> const Message *;
+  /**
+   * Adds message to the buffer, replacing the one for its key.
+   * @return false if the key has no message and the buffer is full
+   */
+  auto PutMessage(const Message &message, const KeyComparator &comparator) -> bool;
+  /** Sets begin and end to the range of the messages for the child at index. */
+  void ChildMessages(int index, const KeyComparator &comparator, int *begin, int *end) const;
+  void RemoveMessages(int begin, int end);
+
+  // Split utility method, moves the upper half of the children and their messages and returns the key between them
+  auto MoveHalfTo(BEpsilonTreeInternalPage *recipient, const KeyComparator &comparator) -> KeyType;
+
+ private:
+  auto MessageIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+  auto Pivots() -> std::pair<KeyType, page_id_t> *;
+  auto Pivots() const -> const std::pair<KeyType, page_id_t> *;
+  auto Messages() -> Message *;
+  auto Messages() const -> const Message *;
+
+  int buffer_size_;
+  int buffer_max_size_;
+  // Flexible array member for the children and the buffer.
+  char data_[1];
+};
+
+}  // namespace bustub
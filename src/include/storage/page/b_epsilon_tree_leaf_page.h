@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_epsilon_tree_leaf_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <utility>
+
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_EPSILON_TREE_LEAF_PAGE_TYPE BEpsilonTreeLeafPage<KeyType, ValueType, KeyComparator>
+#define B_EPSILON_TREE_LEAF_PAGE_HEADER_SIZE 32
+#define B_EPSILON_TREE_LEAF_PAGE_SIZE \
+  static_cast<int>((PAGE_SIZE - B_EPSILON_TREE_LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+
+/**
+ * Store the key & value pairs a B epsilon tree (see b_epsilon_tree.h) has
+ * flushed all the way down, sorted by key, one value per key.
+ *
+ * Leaf page format (keys are stored in order):
+ *  -----------------------------------------------------------------------
+ * | HEADER | KEY(1) + VALUE(1) | KEY(2) + VALUE(2) | ... | KEY(n) + VALUE(n)
+ *  -----------------------------------------------------------------------
+ *
+ * The header is that of a B+ tree page (see b_plus_tree_page.h). Leaves are
+ * not linked, the tree is only ever searched from the root.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BEpsilonTreeLeafPage : public BPlusTreePage {
+ public:
+  // must call initialize method after "create" a new node
+  void Init(page_id_t page_id, int max_size = B_EPSILON_TREE_LEAF_PAGE_SIZE);
+
+  auto KeyAt(int index) const -> KeyType;
+  auto GetItem(int index) const -> const MappingType &;
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+
+  auto Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
+  /** Sets the value of key, which may be new only if the page is not full. */
+  void Upsert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
+  /** Removes key, if the page has it. */
+  void Delete(const KeyType &key, const KeyComparator &comparator);
+
+  // Split utility method
+  void MoveHalfTo(BEpsilonTreeLeafPage *recipient);
+
+ private:
+  // Flexible array member for page data.
+  MappingType array_[1];
+};
+
+}  // namespace bustub
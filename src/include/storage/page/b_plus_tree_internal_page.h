@@ -13,12 +13,18 @@
 #include <queue>
 
 #include "storage/page/b_plus_tree_page.h"
+#include "storage/page/b_plus_tree_slot_array.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_HEADER_SIZE 36
+#define INTERNAL_PAGE_SLOT_SPACE (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE - sizeof(KeyType) - SLOT_ARRAY_HEADER_SIZE)
+// number of children that fit into an internal page even if their keys share nothing
+#define INTERNAL_PAGE_SLOT_COUNT (INTERNAL_PAGE_SLOT_SPACE / FULL_SLOT_SIZE)
+// compressed keys let an internal page hold up to twice as many children; a
+// page split in half then always has room for the entry that did not fit
+#define INTERNAL_PAGE_SIZE (2 * INTERNAL_PAGE_SLOT_COUNT - 2)
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -27,10 +33,27 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal page format (keys are stored in increasing order and compressed,
+ * see b_plus_tree_slot_array.h):
+ *  ------------------------------------------------------------------------------------------------------------
+ * | HEADER | HIGH KEY | SLOT ARRAY HEADER | KEY(1) | ... | KEY(n) | free space | PAGE_ID(n) | ... | PAGE_ID(1) |
+ *  ------------------------------------------------------------------------------------------------------------
+ *
+ * The first key takes part in the compression like every other key, so it is
+ * always kept equal to a real separator.
+ *
+ * Header format (size in byte, 36 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | MinSize (4) | LSN (8) | CurrentSize (4) | MaxSize (4) |
+ *  ---------------------------------------------------------------------
+ *  -----------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4)
+ *  -----------------------------------------------
+ *
+ * The next page id and the high key are only kept up to date in B-link mode
+ * (see b_plus_tree.h), where they link every internal page to its right
+ * sibling on the same level like leaves are linked, and bound the keys of its
+ * subtree from above. The rightmost page of a level has neither.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
@@ -38,6 +61,11 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
 
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
+  auto GetHighKey() const -> const KeyType &;
+  void SetHighKey(const KeyType &high_key);
+
   auto KeyAt(int index) const -> KeyType;
   void SetKeyAt(int index, const KeyType &key);
   auto ValueIndex(const ValueType &value) const -> int;
@@ -46,9 +74,15 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   auto InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value) -> int;
+  auto InsertNode(const KeyType &new_key, const ValueType &new_value) -> int;
   void Remove(int index);
+  void AppendChild(const KeyType &key, const ValueType &value, BufferPoolManager *buffer_pool_manager);
   auto RemoveAndReturnOnlyChild() -> ValueType;
 
+  auto HasRoomFor(const KeyType &key) const -> bool;
+  auto HasRoomForAnyKey() const -> bool;
+  auto HasRoomForAll(const BPlusTreeInternalPage *other, const KeyType &middle_key) const -> bool;
+
   // Split and Merge utility methods
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key, BufferPoolManager *buffer_pool_manager);
   void MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
@@ -58,10 +92,13 @@ class BPlusTreeInternalPage : public BPlusTreePage {
                          BufferPoolManager *buffer_pool_manager);
 
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
+  void CopyNFrom(const BPlusTreeInternalPage *donor, int from, int size, BufferPoolManager *buffer_pool_manager);
   void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  // Flexible array member for page data.
-  MappingType array_[1];
+  void Adopt(const ValueType &child_page_id, BufferPoolManager *buffer_pool_manager);
+  page_id_t next_page_id_;
+  KeyType high_key_;
+  // Flexible slot array for page data.
+  BPlusTreeSlotArray<KeyType, ValueType> array_;
 };
 }  // namespace bustub
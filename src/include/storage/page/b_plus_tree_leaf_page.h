@@ -10,34 +10,54 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <utility>
 #include <vector>
 
 #include "storage/page/b_plus_tree_page.h"
+#include "storage/page/b_plus_tree_slot_array.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 40
+#define LEAF_PAGE_SLOT_SPACE (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - sizeof(KeyType) - SLOT_ARRAY_HEADER_SIZE)
+// number of pairs that fit into a leaf even if their keys share nothing
+#define LEAF_PAGE_SLOT_COUNT (LEAF_PAGE_SLOT_SPACE / FULL_SLOT_SIZE)
+// compressed keys let a leaf hold up to twice as many pairs; a leaf split in
+// half then always has room for the key that did not fit
+#define LEAF_PAGE_SIZE (2 * LEAF_PAGE_SLOT_COUNT - 1)
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Leaf page format (keys are stored in order and compressed, see
+ * b_plus_tree_slot_array.h):
+ *  ----------------------------------------------------------------------------------------------------
+ * | HEADER | HIGH KEY | SLOT ARRAY HEADER | KEY(1) | ... | KEY(n) | free space | RID(n) | ... | RID(1) |
+ *  ----------------------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ * Besides max size, a leaf is limited by the space its compressed slots
+ * take, so a key that shares less with the others may not fit even though
+ * the leaf is below max size. HasRoomFor() tells whether it does.
+ *
+ *  Header format (size in byte, 40 bytes in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ * | PageType (4) | Padding (4) | LSN (8) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  --------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | PrevPageId (4)
+ *  --------------------------------------------------------------
+ *
+ * Leaves are linked both ways, so that they can be scanned in either
+ * direction. A leaf that was merged away keeps both of its links.
+ *
+ * In B-link mode (see b_plus_tree.h) the high key is an upper bound on the
+ * keys of the leaf: every key of the leaf is smaller, and every key of the
+ * leaves right of it is at least as large. The rightmost leaf, which has no
+ * next page, has no high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -48,9 +68,17 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
+  auto GetPrevPageId() const -> page_id_t;
+  void SetPrevPageId(page_id_t prev_page_id);
+  auto GetHighKey() const -> const KeyType &;
+  void SetHighKey(const KeyType &high_key);
   auto KeyAt(int index) const -> KeyType;
   auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
-  auto GetItem(int index) -> const MappingType &;
+  auto GetItem(int index) const -> MappingType;
+  void GetItems(int from, int count, MappingType *items) const;
+  auto HasRoomFor(const KeyType &key) const -> bool;
+  auto HasRoomForAnyKey() const -> bool;
+  auto HasRoomForAll(const BPlusTreeLeafPage *other) const -> bool;
 
   // insert and delete methods
   auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> int;
@@ -64,11 +92,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
+  void CopyNFrom(const BPlusTreeLeafPage *donor, int from, int size);
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item);
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[1];
+  // written under the latch of the leaf to the left rather than this one's, see BPlusTree::LinkBack()
+  std::atomic<page_id_t> prev_page_id_;
+  KeyType high_key_;
+  // Flexible slot array for page data.
+  BPlusTreeSlotArray<KeyType, ValueType> array_;
 };
 }  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_plus_tree_slot_array.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+namespace bustub {
+
+#define SLOT_ARRAY_HEADER_SIZE (3 * sizeof(uint16_t) + sizeof(KeyType))
+#define FULL_SLOT_SIZE (sizeof(KeyType) + sizeof(ValueType))
+
+/**
+ * Prefix and suffix compressed array of key & value pairs, the tail of both
+ * leaf and internal pages.
+ *
+ * The bytes every key in the array starts with (the shared prefix) and ends
+ * with (the shared suffix) are stored once in a pattern key, and each slot
+ * only keeps the middle bytes of its key. Keys of an index are usually zero
+ * padded and often share their leading bytes with their neighbours, so slots
+ * tend to be much smaller than a full key & value pair.
+ *
+ * Slot array format (w = key size - prefix size - suffix size, or 0 if all keys are equal):
+ *  -----------------------------------------------------------------------------------------------------
+ * | PrefixSize (2) | SuffixSize (2) | Space (2) | PATTERN KEY | MIDDLE(1) | ... | MIDDLE(n) | free space
+ *  -----------------------------------------------------------------------------------------------------
+ *  -------------------------------------------
+ *   free space | VALUE(n) | ... | VALUE(1) |
+ *  -------------------------------------------
+ *              <-- sizeof(ValueType) -->
+ *
+ * The middles are kept apart from the values, packed at w bytes each from the
+ * front of the space while the values grow from its back, so a search only
+ * touches the middles. Keys are normalized (see GenericKey) and order like
+ * their bytes, so a search compares the big-endian integers the middles make
+ * up if w is at most 8, which covers every single integer column key.
+ *
+ * Storing a key that shares less with the pattern re-encodes every slot with
+ * wider middles, so the space a number of pairs needs depends on their keys;
+ * callers check SlotSize() before growing the array. Removing keys never
+ * narrows the slots until Compact() is called. The array does not know its
+ * own size, which lives in the page header and is passed in.
+ */
+template <typename KeyType, typename ValueType>
+class BPlusTreeSlotArray {
+ public:
+  /** Sets up an empty array with space bytes for its slots. */
+  void Init(size_t space);
+
+  auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> ValueType;
+  void SetKeyAt(int index, const KeyType &key, int size);
+  void SetValueAt(int index, const ValueType &value);
+  /** Decodes the pairs in [from, from + count) into items in one pass over the slots. */
+  void CopyOut(int from, int count, std::pair<KeyType, ValueType> *items) const;
+
+  /** Opens a slot at index for the pair, moving the slots behind it. */
+  void Insert(int index, const KeyType &key, const ValueType &value, int size);
+  /** Closes the slot at index, moving the slots behind it. */
+  void Remove(int index, int size);
+  /** Narrows the slots as far as the remaining keys allow. */
+  void Compact(int size);
+
+  /** @return the first index in [from, size) whose key is not less than key, or size */
+  auto LowerBound(const KeyType &key, int from, int size) const -> int;
+  /** @return the first index in [from, size) whose key is greater than key, or size */
+  auto UpperBound(const KeyType &key, int from, int size) const -> int;
+
+  /** @return the size of a slot once key is stored as well */
+  auto SlotSize(const KeyType &key, int size) const -> size_t;
+  /** @return the size of a slot once all keys of other are stored as well */
+  auto SlotSize(const BPlusTreeSlotArray &other, int other_size, int size) const -> size_t;
+  /** @return the size of a slot once all keys of other and key are stored as well */
+  auto SlotSize(const BPlusTreeSlotArray &other, int other_size, const KeyType &key, int size) const -> size_t;
+
+ private:
+  auto MiddleSize() const -> size_t;
+  auto MiddleData(int index) -> char *;
+  auto MiddleData(int index) const -> const char *;
+  auto ValueData(int index) -> char *;
+  auto ValueData(int index) const -> const char *;
+  auto Bound(const KeyType &key, int from, int size, bool upper) const -> int;
+  /** Widens the slots until the pattern covers key. */
+  void Widen(const KeyType &key, int size);
+  /** Re-encodes all slots against a new pattern. */
+  void Reencode(const KeyType &pattern, size_t prefix_size, size_t suffix_size, int size);
+
+  static auto CommonPrefix(const KeyType &a, const KeyType &b, size_t limit) -> size_t;
+  static auto CommonSuffix(const KeyType &a, const KeyType &b, size_t limit) -> size_t;
+  static auto MiddleSize(size_t prefix_size, size_t suffix_size) -> size_t;
+
+  uint16_t prefix_size_;
+  uint16_t suffix_size_;
+  uint16_t space_;
+  KeyType pattern_;
+  // Flexible array member for the slots.
+  char slots_[1];
+};
+
+}  // namespace bustub
@@ -71,11 +71,13 @@ class HashTableBlockPage {
   auto Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) -> bool;
 
   /**
-   * Removes a key and value at index.
+   * Removes a key and value at index, leaving a tombstone: the index stays
+   * occupied, so that probes for the keys after it go on past it.
    *
    * @param bucket_ind ind to remove the value
+   * @return false if the index was not readable, e.g. because another thread removed it first
    */
-  void Remove(slot_offset_t bucket_ind);
+  auto Remove(slot_offset_t bucket_ind) -> bool;
 
   /**
    * Returns whether or not an index is occupied (key/value pair or tombstone)
@@ -93,51 +95,6 @@ class HashTableBlockPage {
    */
   auto IsReadable(slot_offset_t bucket_ind) const -> bool;
 
-  /**
-   * Scan the bucket and collect values that have the matching key
-   *
-   * @return true if at least one key matched
-   */
-  auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool;
-
-  /**
-   * Attempts to insert a key and value in the bucket.
-   * The insert is thread safe. It uses compare and swap to claim the index,
-   * and then writes the key and value into the index, and then marks the
-   * index as readable.
-   *
-   * @param key key to insert
-   * @param value value to insert
-   * @return true if inserted, false if duplicate KV pair or bucket is full
-   */
-  auto Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool;
-
-  /**
-   * Removes a key and value.
-   * @return true if removed, false if not found
-   */
-  auto Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool;
-
-  /**
-   * @return the number of readable elements, i.e. current size
-   */
-  auto NumReadable() -> uint32_t;
-
-  /**
-   * @return whether the bucket is full
-   */
-  auto IsFull() -> bool;
-
-  /**
-   * @return whether the bucket is empty
-   */
-  auto IsEmpty() -> bool;
-
-  /**
-   * Prints the bucket's occupancy information
-   */
-  void PrintBucket();
-
  private:
   std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
 
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -30,9 +31,20 @@ namespace bustub {
  *  ----------------------------------------------------------------
  *
  *  Here '+' means concatenation.
- *  The above format omits the space required for the occupied_ and
- *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
+ *  The above format omits the space required for the readable count, the
+ *  occupied_ and readable_ arrays and the fingerprints. More information is
+ *  in storage/page/hash_table_page_defs.h.
  *
+ * Every slot has a one byte fingerprint of its key, a hash that equal keys
+ * share. A lookup compares the fingerprints of a group of slots with the
+ * key's at once and only reads the keys of the readable slots that match, so
+ * a probe rarely calls the comparator on a key it is not looking for. Keys
+ * are equal only if their bytes are, which holds for integers and the
+ * normalized generic keys.
+ *
+ * A bucket whose pairs all have the same hash cannot be split, so when it is
+ * full it continues in an overflow page, which may continue in another one.
+ * The pages of a bucket are its chain (see ExtendibleHashTable).
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -40,6 +52,18 @@ class HashTableBucketPage {
   // Delete all constructor / destructor to ensure memory safety
   HashTableBucketPage() = delete;
 
+  /**
+   * Init method after creating a new bucket page, the page data is zeroed already
+   */
+  void Init();
+
+  /**
+   * @return the page id of the next page of the bucket's chain, INVALID_PAGE_ID if this is the last one
+   */
+  auto GetOverflowPageId() const -> page_id_t;
+
+  void SetOverflowPageId(page_id_t overflow_page_id);
+
   /**
    * Scan the bucket and collect values that have the matching key
    *
@@ -47,6 +71,23 @@ class HashTableBucketPage {
    */
   auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool;
 
+  /**
+   * Scan the bucket for several keys at once. The slots whose fingerprint
+   * matches are found for all the keys and prefetched before any key is
+   * compared, so that the cache misses on them overlap.
+   *
+   * @param keys the keys to look up
+   * @param num_keys the number of keys
+   * @param[out] results results[i] collects the values of keys[i]
+   */
+  void GetValues(const KeyType *keys, size_t num_keys, KeyComparator cmp, std::vector<ValueType> *const *results);
+
+  /**
+   * Prefetches the flags and fingerprints, which every lookup reads, ahead of
+   * a lookup in this page.
+   */
+  void Prefetch() const;
+
   /**
    * Attempts to insert a key and value in the bucket.  Uses the occupied_
    * and readable_ arrays to keep track of each slot's availability.
@@ -138,10 +179,26 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  // slots whose fingerprints are matched at once, as many as fit in an AVX2 register
+  static constexpr uint32_t GROUP_SIZE = 32;
+  static constexpr uint32_t NUM_GROUPS = (BUCKET_ARRAY_SIZE - 1) / GROUP_SIZE + 1;
+
+  // the fingerprint of a key, one byte of a hash of its bytes
+  static auto Fingerprint(const KeyType &key) -> uint8_t;
+
+  // the readable_ bits of a group, the slots past the end of the array are never readable
+  auto ReadableInGroup(uint32_t group) const -> uint32_t;
+
+  // the readable slots of a group whose fingerprint is the given one
+  auto MatchInGroup(uint32_t group, uint8_t fingerprint) const -> uint32_t;
+
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
-  unsigned char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  uint32_t num_readable_;
+  page_id_t overflow_page_id_;
+  unsigned char occupied_[NUM_GROUPS * GROUP_SIZE / 8];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
-  unsigned char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  unsigned char readable_[NUM_GROUPS * GROUP_SIZE / 8];
+  uint8_t fingerprints_[NUM_GROUPS * GROUP_SIZE];
   MappingType array_[1];
 };
 
@@ -27,9 +27,16 @@ namespace bustub {
  * Directory Page for extendible hash table.
  *
  * Directory format (size in byte):
- * --------------------------------------------------------------------------------------------
- * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
- * --------------------------------------------------------------------------------------------
+ * ------------------------------------------------------------------------------------------------------------------
+ * | PageId(4) | Padding(4) | LSN (8) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | TablePageIds(1024)
+ * ------------------------------------------------------------------------------------------------------------------
+ * | Free(492) |
+ * -------------
+ *
+ * A page holds the first DIRECTORY_ARRAY_SIZE slots of the directory. A
+ * larger directory is continued in segments, pages of the same format of
+ * which only the slots are used, that directory table pages list (see
+ * container/hash/hash_table_directory.h).
  */
 class HashTableDirectoryPage {
  public:
@@ -73,6 +80,18 @@ class HashTableDirectoryPage {
    */
   void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
 
+  /**
+   * @param table_idx the index of a directory table page
+   * @return the page_id of the directory table page
+   */
+  auto GetTablePageId(uint32_t table_idx) -> page_id_t;
+
+  /**
+   * @param table_idx the index of a directory table page
+   * @param table_page_id the page_id of the directory table page
+   */
+  void SetTablePageId(uint32_t table_idx, page_id_t table_page_id);
+
   /**
    * Gets the split image of an index
    *
@@ -199,6 +218,7 @@ class HashTableDirectoryPage {
   uint32_t global_depth_{0};
   uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
   page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+  page_id_t table_page_ids_[DIRECTORY_TABLE_SIZE];
 };
 
 }  // namespace bustub
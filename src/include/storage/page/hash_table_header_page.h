@@ -26,9 +26,9 @@ namespace bustub {
  *
  * Header Page for linear probing hash table.
  *
- * Header format (size in byte, 16 bytes in total):
+ * Header format (size in byte, 32 bytes in total):
  * -------------------------------------------------------------
- * | LSN (4) | Size (4) | PageId(4) | NextBlockIndex(4)
+ * | PageId(4) | Padding(4) | LSN (8) | Size (8) | NextBlockIndex(8)
  * -------------------------------------------------------------
  */
 class HashTableHeaderPage {
@@ -70,7 +70,7 @@ class HashTableHeaderPage {
   void SetLSN(lsn_t lsn);
 
   /**
-   * Adds a block page_id to the end of header page
+   * Adds a block page_id to the end of header page, which holds at most HEADER_ARRAY_SIZE of them
    *
    * @param page_id page_id to be added
    */
@@ -90,12 +90,12 @@ class HashTableHeaderPage {
   auto NumBlocks() -> size_t;
 
  private:
-  __attribute__((unused)) lsn_t lsn_;
-  __attribute__((unused)) size_t size_;
-  __attribute__((unused)) page_id_t page_id_;
-  __attribute__((unused)) size_t next_ind_;
+  page_id_t page_id_;
+  lsn_t lsn_;
+  size_t size_;
+  size_t next_ind_;
   // Flexible array member for page data.
-  __attribute__((unused)) page_id_t block_page_ids_[1];
+  page_id_t block_page_ids_[1];
 };
 
 }  // namespace bustub
@@ -29,17 +29,35 @@
 // how many entities can matained by each block
 #define BLOCK_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
 
+/**
+ * HEADER_ARRAY_SIZE is the number of block page ids that fit in a linear probe hash header page after its 32 bytes of
+ * fields, which bounds the number of blocks of a table.
+ */
+#define HEADER_ARRAY_SIZE ((PAGE_SIZE - 32) / sizeof(page_id_t))
+
 /**
  * Extendible Hashing Definitions
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
 #define DIRECTORY_ARRAY_SIZE 512
 
+/**
+ * A directory that outgrows its page continues in segments of DIRECTORY_ARRAY_SIZE slots. Directory table pages list
+ * the page ids of DIRECTORY_TABLE_PAGE_SIZE segments each, and the directory page those of DIRECTORY_TABLE_SIZE
+ * table pages, which bounds the global depth to log2(DIRECTORY_ARRAY_SIZE * DIRECTORY_TABLE_PAGE_SIZE *
+ * DIRECTORY_TABLE_SIZE) = 9 + 10 + 8.
+ */
+#define DIRECTORY_TABLE_PAGE_SIZE (PAGE_SIZE / sizeof(page_id_t))
+#define DIRECTORY_TABLE_SIZE 256
+#define DIRECTORY_MAX_DEPTH 27
+
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
  * It is an approximate calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType).
- * For each key/value pair, we need two additional bits for occupied_ and readable_. 4 * (PAGE_SIZE - 4) / (4 * sizeof
- * (MappingType) + 1) = (PAGE_SIZE - 4)/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
- * to maintain the occupied and readable flags for a key value pair.
+ * For each key/value pair, we need two additional bits for occupied_ and readable_ and a byte for its fingerprint.
+ * 4 * (PAGE_SIZE - 64) / (4 * sizeof (MappingType) + 5) = (PAGE_SIZE - 64)/(sizeof (MappingType) + 1.25) because
+ * 1.25 bytes = 10 bits is the space required to maintain the flags and the fingerprint for a key value pair. The 64
+ * bytes cover the readable count, the overflow page id, the arrays rounding up to whole groups of 32 slots and the
+ * alignment of the pairs.
  */
-#define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+#define BUCKET_ARRAY_SIZE (4 * (PAGE_SIZE - 64) / (4 * sizeof(MappingType) + 5))
@@ -68,11 +68,15 @@ class Page {
 
  protected:
   static_assert(sizeof(page_id_t) == 4);
-  static_assert(sizeof(lsn_t) == 4);
+  static_assert(sizeof(lsn_t) == 8);
 
-  static constexpr size_t SIZE_PAGE_HEADER = 8;
+  /**
+   * Every page starts with | PageId (4) | (4 bytes left to the page type) | LSN (8) |, which keeps the LSN 8-byte
+   * aligned for page types that are laid out as structs.
+   */
+  static constexpr size_t SIZE_PAGE_HEADER = 16;
   static constexpr size_t OFFSET_PAGE_START = 0;
-  static constexpr size_t OFFSET_LSN = 4;
+  static constexpr size_t OFFSET_LSN = 8;
 
  private:
   /** Zeroes out the data that is held within the page. */
@@ -86,6 +90,8 @@ class Page {
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** A lower bound on the LSN of the first change since the page was last clean (recLSN). */
+  lsn_t rec_lsn_ = INVALID_LSN;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/posting_list_page.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define POSTING_LIST_PAGE_HEADER_SIZE 20
+
+/**
+ * Store a sorted run of the RIDs of one key of a non-unique index. The RIDs
+ * of a key that outgrow a page spill into more pages chained by their next
+ * page ids, each holding the RIDs between those of its neighbours.
+ *
+ * Each RID is stored as the variable length (7 bits per byte) difference to
+ * the one before it, taking RIDs as the 64 bit integers RID::Get() makes of
+ * them; the first is stored in full. RIDs on one table page mostly differ by
+ * a slot or two, so most of them take a single byte.
+ *
+ * Posting list page format:
+ *  ---------------------------------------------------------------------------------
+ * | LastRid (8) | NextPageId (4) | Size (4) | Bytes (4) | DELTA(1) | ... | DELTA(n) |
+ *  ---------------------------------------------------------------------------------
+ */
+class PostingListPage {
+ public:
+  void Init();
+
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
+  auto GetSize() const -> int;
+  /** @return the greatest RID of the page, undefined if it is empty */
+  auto GetLastRid() const -> RID;
+
+  /** Appends the RIDs of the page to rids. */
+  void GetRids(std::vector<RID> *rids) const;
+  /**
+   * Replaces the RIDs of the page with as many of the first count of rids as fit.
+   * @param rids sorted and distinct RIDs
+   * @return the number of RIDs stored
+   */
+  auto SetRids(const RID *rids, int count) -> int;
+  /**
+   * Adds rid after the last RID of the page without decoding the others.
+   * @param rid a RID greater than the last one
+   * @return false if it does not fit
+   */
+  auto Append(const RID &rid) -> bool;
+
+ private:
+  /** Writes the delta of rid to the RID before it at the end of the deltas, if it fits. */
+  auto PutDelta(uint64_t rid, uint64_t previous) -> bool;
+
+  int64_t last_rid_;
+  page_id_t next_page_id_;
+  int32_t size_;
+  uint32_t bytes_;
+  // Flexible array member for the deltas.
+  char data_[1];
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #include "recovery/log_manager.h"
 
+#include "common/exception.h"
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +24,226 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  flush_thread_ = new std::thread([&] {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (enable_logging) {
+      cv_.wait_for(lock, log_timeout, [&] { return flush_requested_ || !enable_logging; });
+      flush_requested_ = false;
+      if (log_buffer_offset_ > 0 && !flushing_) {
+        FlushBuffer(&lock);
+      }
+    }
+  });
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  if (flush_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock lock(latch_);
+    enable_logging = false;
+    cv_.notify_one();
+  }
+  flush_thread_->join();
+  delete flush_thread_;
+  flush_thread_ = nullptr;
+  // whatever is left in the buffer still has to reach the disk
+  Flush(true);
+}
+
+/*
+ * Swap the two buffers and write the full one out. The latch is released during the disk write so that other
+ * threads can keep appending into the (now empty) log buffer.
+ */
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) {
+  flushing_ = true;
+  std::swap(log_buffer_, flush_buffer_);
+  int size = log_buffer_offset_;
+  lsn_t first_lsn = log_buffer_first_lsn_;
+  lsn_t last_lsn = log_buffer_last_lsn_;
+  log_buffer_offset_ = 0;
+  log_buffer_first_lsn_ = INVALID_LSN;
+
+  lock->unlock();
+  disk_manager_->WriteLog(flush_buffer_, size);
+  lock->lock();
+
+  if (size > 0) {
+    offset_index_.emplace_back(first_lsn, flushed_offset_);
+    flushed_offset_ += size;
+    persistent_lsn_ = last_lsn;
+  }
+  flushing_ = false;
+  flushed_cv_.notify_all();
+}
+
+void LogManager::Flush(bool force) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn_t target = next_lsn_ - 1;
+  if (flush_thread_ == nullptr) {
+    // no background thread, flush synchronously
+    flushed_cv_.wait(lock, [&] { return !flushing_; });
+    if (persistent_lsn_ < target && log_buffer_offset_ > 0) {
+      FlushBuffer(&lock);
+    }
+    return;
+  }
+  if (force) {
+    flush_requested_ = true;
+    cv_.notify_one();
+  }
+  flushed_cv_.wait(lock, [&] { return persistent_lsn_ >= target; });
+}
+
+auto LogManager::GetLogOffset(lsn_t lsn) -> log_offset_t {
+  std::scoped_lock lock(latch_);
+  auto it = std::upper_bound(offset_index_.begin(), offset_index_.end(),
+                             std::make_pair(lsn, std::numeric_limits<log_offset_t>::max()));
+  if (it == offset_index_.begin()) {
+    // older than every chunk we know of; only the start of the log is safe
+    return offset_index_.empty() ? flushed_offset_ : disk_manager_->GetLogStart();
+  }
+  return std::prev(it)->second;
+}
+
+auto LogManager::GetNextOffset() -> log_offset_t {
+  std::scoped_lock lock(latch_);
+  return flushed_offset_ + log_buffer_offset_;
+}
+
+void LogManager::TruncateOffsetIndex(lsn_t lsn) {
+  std::scoped_lock lock(latch_);
+  auto it = std::upper_bound(offset_index_.begin(), offset_index_.end(),
+                             std::make_pair(lsn, std::numeric_limits<log_offset_t>::max()));
+  if (it != offset_index_.begin()) {
+    offset_index_.erase(offset_index_.begin(), std::prev(it));
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
+ * a record that does not fit into an empty log buffer is rejected, recovery could not read it back either
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  if (log_record->size_ > LOG_BUFFER_SIZE) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "log record is larger than the log buffer");
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  while (log_buffer_offset_ + log_record->size_ > LOG_BUFFER_SIZE) {
+    if (flushing_) {
+      flushed_cv_.wait(lock);
+    } else {
+      FlushBuffer(&lock);
+    }
+  }
+
+  log_record->lsn_ = next_lsn_++;
+  if (log_buffer_first_lsn_ == INVALID_LSN) {
+    log_buffer_first_lsn_ = log_record->lsn_;
+  }
+  log_buffer_last_lsn_ = log_record->lsn_;
+
+  // First, serialize the must have fields as varints. The size comes first but covers the whole record, its own
+  // varint included, so encode the other fields before we know it.
+  char fields[LogRecord::MAX_HEADER_SIZE];
+  int fields_size = 0;
+  fields_size += LogRecord::EncodeVarint(log_record->lsn_, fields + fields_size);
+  fields_size += LogRecord::EncodeVarint(log_record->txn_id_ + 1, fields + fields_size);
+  fields_size += LogRecord::EncodeVarint(
+      log_record->prev_lsn_ == INVALID_LSN ? 0 : log_record->lsn_ - log_record->prev_lsn_, fields + fields_size);
+  fields_size += LogRecord::EncodeVarint(static_cast<uint64_t>(log_record->log_record_type_), fields + fields_size);
+  int body_size = fields_size + log_record->size_ - LogRecord::MAX_HEADER_SIZE;
+  int size_size = LogRecord::VarintSize(body_size + 1);
+  while (LogRecord::VarintSize(body_size + size_size) > size_size) {
+    size_size++;
+  }
+  log_record->size_ = body_size + size_size;
+
+  char *pos = log_buffer_ + log_buffer_offset_;
+  pos += LogRecord::EncodeVarint(log_record->size_, pos);
+  memcpy(pos, fields, fields_size);
+  pos += fields_size;
+
+  LogRecordType body_type = log_record->log_record_type_;
+  if (body_type == LogRecordType::CLR) {
+    memcpy(pos, &log_record->undo_next_lsn_, sizeof(lsn_t));
+    pos += sizeof(lsn_t);
+    pos += LogRecord::EncodeVarint(static_cast<uint64_t>(log_record->clr_type_), pos);
+    body_type = log_record->clr_type_;
+  }
+  switch (body_type) {
+    case LogRecordType::INSERT:
+      memcpy(pos, &log_record->insert_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      // we have provided serialize function for tuple class
+      log_record->insert_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(pos, &log_record->delete_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->delete_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.SerializeTo(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::DELTAUPDATE:
+      memcpy(pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      pos += LogRecord::EncodeVarint(log_record->delta_tuple_size_, pos);
+      pos += LogRecord::EncodeVarint(log_record->delta_ranges_.size(), pos);
+      for (const auto &range : log_record->delta_ranges_) {
+        pos += LogRecord::EncodeVarint(range.offset_, pos);
+        pos += LogRecord::EncodeVarint(range.old_bytes_.size(), pos);
+        memcpy(pos, range.old_bytes_.data(), range.old_bytes_.size());
+        pos += range.old_bytes_.size();
+        memcpy(pos, range.new_bytes_.data(), range.new_bytes_.size());
+        pos += range.new_bytes_.size();
+      }
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      memcpy(pos + sizeof(page_id_t), &log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::CHECKPOINT_END: {
+      auto write = [&pos](auto v) {
+        memcpy(pos, &v, sizeof(v));
+        pos += sizeof(v);
+      };
+      write(log_record->scan_offset_);
+      write(static_cast<int32_t>(log_record->active_txn_table_.size()));
+      for (const auto &[txn_id, last_lsn] : log_record->active_txn_table_) {
+        write(txn_id);
+        write(last_lsn);
+      }
+      write(static_cast<int32_t>(log_record->dirty_page_table_.size()));
+      for (const auto &[page_id, rec_lsn] : log_record->dirty_page_table_) {
+        write(page_id);
+        write(rec_lsn);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  log_buffer_offset_ += log_record->size_;
+  return log_record->lsn_;
+}
 
 }  // namespace bustub
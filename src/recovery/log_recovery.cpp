@@ -12,6 +12,13 @@
 
 #include "recovery/log_recovery.h"
 
+#include <future>  // NOLINT
+#include <initializer_list>
+#include <queue>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,7 +27,260 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool { return false; }
+auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool {
+  const char *buffer_end = log_buffer_ + LOG_BUFFER_SIZE;
+  uint64_t size;
+  int read = LogRecord::DecodeVarint(data, buffer_end, &size);
+  if (read == 0 || size <= static_cast<uint64_t>(read) || size > static_cast<uint64_t>(buffer_end - data)) {
+    // zero padding at the end of the log, or a record cut off by the end of the buffer
+    return false;
+  }
+  const char *record_end = data + size;
+  const char *pos = data + read;
+  uint64_t fields[4];
+  for (auto &field : fields) {
+    read = LogRecord::DecodeVarint(pos, record_end, &field);
+    if (read == 0) {
+      return false;
+    }
+    pos += read;
+  }
+  log_record->size_ = static_cast<int32_t>(size);
+  log_record->lsn_ = static_cast<lsn_t>(fields[0]);
+  log_record->txn_id_ = static_cast<txn_id_t>(fields[1]) - 1;
+  log_record->prev_lsn_ = fields[2] == 0 ? INVALID_LSN : log_record->lsn_ - static_cast<lsn_t>(fields[2]);
+  log_record->log_record_type_ = static_cast<LogRecordType>(fields[3]);
+
+  // every field is checked against the end of the record, a torn or corrupt record ends the log like one that is
+  // cut off
+  auto read_bytes = [&pos, record_end](void *field, size_t size) {
+    if (static_cast<size_t>(record_end - pos) < size) {
+      return false;
+    }
+    memcpy(field, pos, size);
+    pos += size;
+    return true;
+  };
+  auto read_tuple = [&pos, record_end](Tuple *tuple) {
+    int32_t length;
+    if (static_cast<size_t>(record_end - pos) < sizeof(int32_t)) {
+      return false;
+    }
+    memcpy(&length, pos, sizeof(int32_t));
+    if (length < 0 || static_cast<size_t>(length) > static_cast<size_t>(record_end - pos) - sizeof(int32_t)) {
+      return false;
+    }
+    tuple->DeserializeFrom(pos);
+    pos += sizeof(int32_t) + length;
+    return true;
+  };
+
+  if (log_record->log_record_type_ == LogRecordType::CLR) {
+    uint64_t clr_type;
+    if (!read_bytes(&log_record->undo_next_lsn_, sizeof(lsn_t))) {
+      return false;
+    }
+    read = LogRecord::DecodeVarint(pos, record_end, &clr_type);
+    if (read == 0) {
+      return false;
+    }
+    pos += read;
+    log_record->clr_type_ = static_cast<LogRecordType>(clr_type);
+    switch (log_record->clr_type_) {
+      case LogRecordType::INSERT:
+      case LogRecordType::MARKDELETE:
+      case LogRecordType::APPLYDELETE:
+      case LogRecordType::ROLLBACKDELETE:
+      case LogRecordType::UPDATE:
+      case LogRecordType::DELTAUPDATE:
+        break;
+      default:
+        // only changes to tuples are compensated
+        return false;
+    }
+  }
+  switch (log_record->GetActionType()) {
+    case LogRecordType::INSERT:
+      return read_bytes(&log_record->insert_rid_, sizeof(RID)) && read_tuple(&log_record->insert_tuple_);
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      return read_bytes(&log_record->delete_rid_, sizeof(RID)) && read_tuple(&log_record->delete_tuple_);
+    case LogRecordType::UPDATE:
+      return read_bytes(&log_record->update_rid_, sizeof(RID)) && read_tuple(&log_record->old_tuple_) &&
+             read_tuple(&log_record->new_tuple_);
+    case LogRecordType::DELTAUPDATE: {
+      if (!read_bytes(&log_record->update_rid_, sizeof(RID))) {
+        return false;
+      }
+      uint64_t tuple_size;
+      uint64_t range_count;
+      for (uint64_t *field : {&tuple_size, &range_count}) {
+        read = LogRecord::DecodeVarint(pos, record_end, field);
+        if (read == 0) {
+          return false;
+        }
+        pos += read;
+      }
+      if (tuple_size > PAGE_SIZE) {
+        return false;
+      }
+      log_record->delta_tuple_size_ = static_cast<uint32_t>(tuple_size);
+      for (uint64_t i = 0; i < range_count; i++) {
+        uint64_t offset;
+        uint64_t length;
+        for (uint64_t *field : {&offset, &length}) {
+          read = LogRecord::DecodeVarint(pos, record_end, field);
+          if (read == 0) {
+            return false;
+          }
+          pos += read;
+        }
+        if (offset > tuple_size || length > tuple_size - offset ||
+            length > static_cast<uint64_t>(record_end - pos) / 2) {
+          return false;
+        }
+        log_record->delta_ranges_.push_back(
+            {static_cast<uint32_t>(offset), std::string(pos, length), std::string(pos + length, length)});
+        pos += 2 * length;
+      }
+      break;
+    }
+    case LogRecordType::NEWPAGE:
+      return read_bytes(&log_record->prev_page_id_, sizeof(page_id_t)) &&
+             read_bytes(&log_record->page_id_, sizeof(page_id_t));
+    case LogRecordType::CHECKPOINT_END: {
+      // a count is checked against the bytes left for its entries before anything is allocated for them
+      auto fits = [&pos, record_end](int32_t count, size_t entry_size) {
+        return count >= 0 && static_cast<size_t>(count) <= static_cast<size_t>(record_end - pos) / entry_size;
+      };
+      int32_t att_size;
+      if (!read_bytes(&log_record->scan_offset_, sizeof(log_record->scan_offset_)) ||
+          !read_bytes(&att_size, sizeof(int32_t)) || !fits(att_size, sizeof(txn_id_t) + sizeof(lsn_t))) {
+        return false;
+      }
+      log_record->active_txn_table_.resize(att_size);
+      for (auto &[txn_id, last_lsn] : log_record->active_txn_table_) {
+        read_bytes(&txn_id, sizeof(txn_id_t));
+        read_bytes(&last_lsn, sizeof(lsn_t));
+      }
+      int32_t dpt_size;
+      if (!read_bytes(&dpt_size, sizeof(int32_t)) || !fits(dpt_size, sizeof(page_id_t) + sizeof(lsn_t))) {
+        return false;
+      }
+      log_record->dirty_page_table_.resize(dpt_size);
+      for (auto &[page_id, rec_lsn] : log_record->dirty_page_table_) {
+        read_bytes(&page_id, sizeof(page_id_t));
+        read_bytes(&rec_lsn, sizeof(lsn_t));
+      }
+      break;
+    }
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+    case LogRecordType::CHECKPOINT_BEGIN:
+      break;
+    default:
+      // zero padding past the end of the log
+      return false;
+  }
+  return true;
+}
+
+void LogRecovery::ScanLog(log_offset_t start_offset, const std::function<void(LogRecord *, log_offset_t)> &visit,
+                          const std::function<void(std::deque<LogRecord> *)> &scan_ahead) {
+  log_offset_t offset = start_offset;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset)) {
+    // deserialize the whole buffer first, so that scan_ahead gets to see the records before they are visited
+    std::deque<LogRecord> log_records;
+    int pos = 0;
+    while (true) {
+      LogRecord &log_record = log_records.emplace_back();
+      if (!DeserializeLogRecord(log_buffer_ + pos, &log_record)) {
+        log_records.pop_back();
+        break;
+      }
+      pos += log_record.GetSize();
+    }
+    if (scan_ahead) {
+      scan_ahead(&log_records);
+    }
+    log_offset_t record_offset = offset;
+    for (auto &log_record : log_records) {
+      visit(&log_record, record_offset);
+      record_offset += log_record.GetSize();
+    }
+    if (pos == 0) {
+      // not even one record fits, we reached the end of the log
+      break;
+    }
+    // continue from the first record that was cut off
+    offset += pos;
+  }
+}
+
+auto LogRecovery::GetRecordPageId(LogRecord *log_record) -> page_id_t {
+  switch (log_record->GetActionType()) {
+    case LogRecordType::INSERT:
+      return log_record->insert_rid_.GetPageId();
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      return log_record->delete_rid_.GetPageId();
+    case LogRecordType::UPDATE:
+    case LogRecordType::DELTAUPDATE:
+      return log_record->update_rid_.GetPageId();
+    case LogRecordType::NEWPAGE:
+      return log_record->page_id_;
+    default:
+      return INVALID_PAGE_ID;
+  }
+}
+
+auto LogRecovery::Analysis() -> log_offset_t {
+  log_offset_t checkpoint_offset;
+  bool has_checkpoint = disk_manager_->ReadMasterRecord(&checkpoint_offset);
+  // without a checkpoint every segment that is left is needed, with one only those from the redo point on
+  log_offset_t redo_offset = has_checkpoint ? checkpoint_offset : disk_manager_->GetLogStart();
+  // transactions that finished after the checkpoint began must not be resurrected by its (older) snapshot
+  std::unordered_set<txn_id_t> finished_txn;
+
+  ScanLog(redo_offset, [&](LogRecord *log_record, log_offset_t offset) {
+    next_lsn_ = std::max(next_lsn_, log_record->lsn_ + 1);
+    txn_id_t txn_id = log_record->txn_id_;
+    switch (log_record->log_record_type_) {
+      case LogRecordType::CHECKPOINT_BEGIN:
+        break;
+      case LogRecordType::CHECKPOINT_END:
+        redo_offset = std::min(redo_offset, log_record->scan_offset_);
+        for (const auto &[att_txn_id, last_lsn] : log_record->active_txn_table_) {
+          if (finished_txn.count(att_txn_id) == 0 && active_txn_.count(att_txn_id) == 0) {
+            active_txn_[att_txn_id] = last_lsn;
+          }
+        }
+        for (const auto &[page_id, rec_lsn] : log_record->dirty_page_table_) {
+          auto it = dirty_page_table_.find(page_id);
+          if (it == dirty_page_table_.end() || rec_lsn < it->second) {
+            dirty_page_table_[page_id] = rec_lsn;
+          }
+        }
+        break;
+      case LogRecordType::COMMIT:
+      case LogRecordType::ABORT:
+        active_txn_.erase(txn_id);
+        finished_txn.insert(txn_id);
+        break;
+      default:
+        active_txn_[txn_id] = log_record->lsn_;
+        page_id_t page_id = GetRecordPageId(log_record);
+        if (page_id != INVALID_PAGE_ID) {
+          dirty_page_table_.emplace(page_id, log_record->lsn_);
+        }
+        break;
+    }
+  });
+  return redo_offset;
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
@@ -29,12 +289,245 @@ auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  log_offset_t redo_offset = Analysis();
+
+  // Pages the records of the current log buffer will redo, in order, and how far redo and prefetching have got.
+  // Prefetching runs in the background and stays at most half a buffer pool ahead of redo, so that prefetched
+  // pages are not evicted again before they are used.
+  std::vector<page_id_t> upcoming_pages;
+  size_t consumed = 0;
+  size_t issued = 0;
+  size_t window = std::max<size_t>(1, buffer_pool_manager_->GetPoolSize() / 2);
+  std::future<void> prefetch;
+  auto issue_prefetch = [&]() {
+    size_t end = std::min(upcoming_pages.size(), consumed + window);
+    if (end <= issued) {
+      return;
+    }
+    if (prefetch.valid()) {
+      prefetch.wait();
+    }
+    std::vector<page_id_t> batch(upcoming_pages.begin() + issued, upcoming_pages.begin() + end);
+    issued = end;
+    prefetch = std::async(std::launch::async, [this, batch = std::move(batch)] {
+      buffer_pool_manager_->PrefetchPages(batch);
+    });
+  };
+
+  auto scan_ahead = [&](std::deque<LogRecord> *log_records) {
+    upcoming_pages.clear();
+    consumed = 0;
+    issued = 0;
+    for (auto &log_record : *log_records) {
+      page_id_t page_id = GetRedoPageId(&log_record);
+      if (page_id != INVALID_PAGE_ID && (upcoming_pages.empty() || upcoming_pages.back() != page_id)) {
+        upcoming_pages.push_back(page_id);
+      }
+    }
+    issue_prefetch();
+  };
+
+  ScanLog(
+      redo_offset,
+      [&](LogRecord *log_record, log_offset_t offset) {
+        lsn_mapping_[log_record->lsn_] = offset;
+        page_id_t page_id = GetRedoPageId(log_record);
+        if (page_id == INVALID_PAGE_ID) {
+          return;
+        }
+        if (consumed < upcoming_pages.size() && upcoming_pages[consumed] == page_id) {
+          consumed++;
+          if (issued < consumed + window / 2 + 1) {
+            issue_prefetch();
+          }
+        }
+        RedoRecord(log_record);
+      },
+      scan_ahead);
+  if (prefetch.valid()) {
+    prefetch.wait();
+  }
+}
+
+auto LogRecovery::GetRedoPageId(LogRecord *log_record) -> page_id_t {
+  page_id_t page_id = GetRecordPageId(log_record);
+  if (page_id == INVALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
+  }
+  // the page was flushed after this change, or was not dirty at all when the change was made
+  auto it = dirty_page_table_.find(page_id);
+  if (it == dirty_page_table_.end() || log_record->lsn_ < it->second) {
+    return INVALID_PAGE_ID;
+  }
+  return page_id;
+}
+
+void LogRecovery::RedoRecord(LogRecord *log_record) {
+  page_id_t page_id = GetRecordPageId(log_record);
+  auto *page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page->GetLSN() >= log_record->lsn_) {
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return;
+  }
+
+  switch (log_record->GetActionType()) {
+    case LogRecordType::INSERT: {
+      RID rid;
+      page->InsertTuple(log_record->insert_tuple_, &rid, nullptr, nullptr, nullptr);
+      break;
+    }
+    case LogRecordType::MARKDELETE:
+      page->MarkDelete(log_record->delete_rid_, nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->ApplyDelete(log_record->delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->RollbackDelete(log_record->delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple old_tuple;
+      page->UpdateTuple(log_record->new_tuple_, &old_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+      break;
+    }
+    case LogRecordType::DELTAUPDATE: {
+      Tuple tuple;
+      Tuple old_tuple;
+      if (page->GetTuple(log_record->update_rid_, &tuple, nullptr, nullptr)) {
+        log_record->ApplyDelta(&tuple, false);
+        page->UpdateTuple(tuple, &old_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+      }
+      break;
+    }
+    case LogRecordType::NEWPAGE: {
+      page_id_t prev_page_id = log_record->prev_page_id_;
+      page->Init(page_id, PAGE_SIZE, prev_page_id, nullptr, nullptr);
+      if (prev_page_id != INVALID_PAGE_ID) {
+        auto *prev_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+        bool relink = prev_page->GetNextPageId() != page_id;
+        if (relink) {
+          prev_page->SetNextPageId(page_id);
+        }
+        buffer_pool_manager_->UnpinPage(prev_page_id, relink);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  page->SetLSN(log_record->lsn_);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
- *iterate through active txn map and undo each operation
+ *revert the changes of all loser transactions together, latest first, logging a CLR for every change reverted
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  if (log_manager_ != nullptr && log_manager_->GetNextLSN() < next_lsn_) {
+    log_manager_->SetNextLSN(next_lsn_);
+  }
+  // (lsn of the next record to undo, transaction), the largest lsn first
+  std::priority_queue<std::pair<lsn_t, txn_id_t>> to_undo;
+  for (const auto &[txn_id, last_lsn] : active_txn_) {
+    to_undo.emplace(last_lsn, txn_id);
+  }
+  while (!to_undo.empty()) {
+    auto [lsn, txn_id] = to_undo.top();
+    to_undo.pop();
+    auto it = lsn_mapping_.find(lsn);
+    if (it == lsn_mapping_.end() || !disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, it->second)) {
+      continue;
+    }
+    LogRecord log_record;
+    if (!DeserializeLogRecord(log_buffer_, &log_record)) {
+      continue;
+    }
+    lsn_t next_lsn;
+    if (log_record.log_record_type_ == LogRecordType::CLR) {
+      // everything from the compensated record on was undone before the last crash
+      next_lsn = log_record.undo_next_lsn_;
+    } else {
+      UndoRecord(&log_record);
+      next_lsn = log_record.prev_lsn_;
+    }
+    if (next_lsn != INVALID_LSN) {
+      to_undo.emplace(next_lsn, txn_id);
+    } else if (log_manager_ != nullptr) {
+      // fully rolled back, later recoveries leave the transaction alone
+      LogRecord abort_record(txn_id, active_txn_[txn_id], LogRecordType::ABORT);
+      log_manager_->AppendLogRecord(&abort_record);
+    }
+  }
+  if (log_manager_ != nullptr) {
+    log_manager_->Flush(true);
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+  dirty_page_table_.clear();
+}
+
+void LogRecovery::UndoRecord(LogRecord *log_record) {
+  page_id_t page_id = GetRecordPageId(log_record);
+  if (page_id == INVALID_PAGE_ID || log_record->log_record_type_ == LogRecordType::NEWPAGE) {
+    return;
+  }
+  txn_id_t txn_id = log_record->txn_id_;
+  lsn_t prev_lsn = active_txn_[txn_id];
+  auto *page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  // the change that reverts the record, logged as the action of a CLR
+  LogRecord action;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(log_record->insert_rid_, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::APPLYDELETE, log_record->insert_rid_,
+                         log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(log_record->delete_rid_, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::ROLLBACKDELETE, log_record->delete_rid_,
+                         log_record->delete_tuple_);
+      break;
+    case LogRecordType::APPLYDELETE: {
+      RID rid;
+      page->InsertTuple(log_record->delete_tuple_, &rid, nullptr, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::INSERT, rid, log_record->delete_tuple_);
+      break;
+    }
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(log_record->delete_rid_, nullptr, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::MARKDELETE, log_record->delete_rid_,
+                         log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      page->UpdateTuple(log_record->old_tuple_, &new_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+      action = LogRecord(txn_id, prev_lsn, LogRecordType::UPDATE, log_record->update_rid_, log_record->new_tuple_,
+                         log_record->old_tuple_);
+      break;
+    }
+    case LogRecordType::DELTAUPDATE: {
+      Tuple tuple;
+      Tuple new_tuple;
+      if (page->GetTuple(log_record->update_rid_, &tuple, nullptr, nullptr)) {
+        Tuple reverted = tuple;
+        log_record->ApplyDelta(&reverted, true);
+        page->UpdateTuple(reverted, &new_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+        action = LogRecord(txn_id, prev_lsn, log_record->update_rid_, tuple, reverted);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  if (log_manager_ != nullptr && action.log_record_type_ != LogRecordType::INVALID) {
+    // the page lsn keeps redo from repeating the original change on top of the reverted page
+    LogRecord clr(log_record->prev_lsn_, std::move(action));
+    active_txn_[txn_id] = log_manager_->AppendLogRecord(&clr);
+    page->SetLSN(active_txn_[txn_id]);
+  }
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 }  // namespace bustub
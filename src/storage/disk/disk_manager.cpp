@@ -11,8 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
@@ -27,30 +30,44 @@ namespace bustub {
 static char *buffer_used;
 
 /**
- * Constructor: open/create a single database file & log file
+ * Constructor: open/create a single database file & find the existing log segments
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
+DiskManager::DiskManager(const std::string &db_file, log_offset_t log_segment_size)
     : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+  log_segment_size_ = log_segment_size;
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  master_name_ = file_name_.substr(0, n) + ".master";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
+  // segments are created lazily by WriteLog(), look for the ones an earlier run left behind
+  std::filesystem::path log_path(log_name_);
+  std::filesystem::path log_dir = log_path.has_parent_path() ? log_path.parent_path() : ".";
+  std::string prefix = log_path.filename().string() + ".";
+  int64_t last_segment = -1;
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator(log_dir, ec)) {
+    std::string name = entry.path().filename().string();
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+        name.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+      continue;
     }
+    int64_t segment = std::stoll(name.substr(prefix.size()));
+    if (last_segment == -1 || segment < first_log_segment_) {
+      first_log_segment_ = segment;
+    }
+    last_segment = std::max(last_segment, segment);
+  }
+  if (last_segment != -1) {
+    log_end_ = last_segment * log_segment_size_ + GetFileSize(GetLogSegmentName(last_segment));
+  }
+  // a master record left behind by an older, removed log would point into garbage
+  if (log_end_ == 0) {
+    std::remove(master_name_.c_str());
   }
 
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
@@ -78,7 +95,9 @@ void DiskManager::ShutDown() {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
     db_io_.close();
   }
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
   log_io_.close();
+  log_io_segment_ = -1;
 }
 
 /**
@@ -100,6 +119,15 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   db_io_.flush();
 }
 
+/**
+ * A page that was never written but lies before one that was counts as well, it reads as zeros
+ */
+auto DiskManager::GetNumPages() -> page_id_t {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  int file_size = GetFileSize(file_name_);
+  return file_size <= 0 ? 0 : (file_size + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
@@ -110,6 +138,7 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   if (offset > GetFileSize(file_name_)) {
     LOG_DEBUG("I/O error reading past end of file");
     // std::cerr << "I/O error while reading" << std::endl;
+    memset(page_data, 0, PAGE_SIZE);
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
@@ -150,16 +179,33 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  // sequence write, switching to a new segment whenever the current one is full
+  while (size > 0) {
+    int64_t segment = log_end_ / log_segment_size_;
+    if (segment != log_io_segment_) {
+      log_io_.close();
+      log_io_.clear();
+      log_io_.open(GetLogSegmentName(segment), std::ios::binary | std::ios::app | std::ios::out);
+      if (!log_io_.is_open()) {
+        throw Exception("can't open dblog file");
+      }
+      log_io_segment_ = segment;
+    }
+    int chunk = static_cast<int>(std::min<log_offset_t>(size, (segment + 1) * log_segment_size_ - log_end_));
+    log_io_.write(log_data, chunk);
 
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
-    return;
+    // check for I/O error
+    if (log_io_.bad()) {
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    // needs to flush to keep disk file in sync
+    log_io_.flush();
+    log_data += chunk;
+    size -= chunk;
+    log_end_ += chunk;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
 }
 
@@ -168,29 +214,82 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
-  if (offset >= GetFileSize(log_name_)) {
+auto DiskManager::ReadLog(char *log_data, int size, log_offset_t offset) -> bool {
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  if (offset >= log_end_ || offset < first_log_segment_ * log_segment_size_) {
     // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while reading log");
-    return false;
+  int read_count = 0;
+  while (read_count < size && offset < log_end_) {
+    int64_t segment = offset / log_segment_size_;
+    std::ifstream segment_io(GetLogSegmentName(segment), std::ios::binary | std::ios::in);
+    segment_io.seekg(offset - segment * log_segment_size_);
+    int chunk = static_cast<int>(
+        std::min<log_offset_t>(size - read_count, std::min(log_end_, (segment + 1) * log_segment_size_) - offset));
+    segment_io.read(log_data + read_count, chunk);
+    if (segment_io.bad() || segment_io.gcount() != chunk) {
+      LOG_DEBUG("I/O error while reading log");
+      return false;
+    }
+    read_count += chunk;
+    offset += chunk;
   }
-  // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
+  // if log ends before reading "size"
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
   return true;
 }
 
+void DiskManager::TruncateLog(log_offset_t offset) {
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  int64_t last_segment = (log_end_ - 1) / log_segment_size_;
+  while (first_log_segment_ < last_segment && (first_log_segment_ + 1) * log_segment_size_ <= offset) {
+    std::remove(GetLogSegmentName(first_log_segment_).c_str());
+    first_log_segment_++;
+  }
+}
+
+auto DiskManager::GetLogStart() -> log_offset_t {
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  return first_log_segment_ * log_segment_size_;
+}
+
+auto DiskManager::GetLogEnd() -> log_offset_t {
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  return log_end_;
+}
+
+/**
+ * Write the master record into a temporary file and rename it over the old one, so that a crash in the middle
+ * leaves either the old or the new record behind
+ */
+void DiskManager::WriteMasterRecord(log_offset_t checkpoint_offset) {
+  std::string tmp_name = master_name_ + ".tmp";
+  std::ofstream master_io(tmp_name, std::ios::binary | std::ios::trunc | std::ios::out);
+  master_io.write(reinterpret_cast<const char *>(&checkpoint_offset), sizeof(checkpoint_offset));
+  master_io.close();
+  if (master_io.bad() || std::rename(tmp_name.c_str(), master_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing master record");
+  }
+}
+
+/**
+ * Read the master record
+ * @return: false means no checkpoint has been taken yet
+ */
+auto DiskManager::ReadMasterRecord(log_offset_t *checkpoint_offset) -> bool {
+  std::ifstream master_io(master_name_, std::ios::binary | std::ios::in);
+  if (!master_io.is_open()) {
+    return false;
+  }
+  master_io.read(reinterpret_cast<char *>(checkpoint_offset), sizeof(*checkpoint_offset));
+  return master_io.gcount() == sizeof(*checkpoint_offset) && *checkpoint_offset >= GetLogStart() &&
+         *checkpoint_offset < GetLogEnd();
+}
+
 /**
  * Returns number of flushes made so far
  */
@@ -206,6 +305,10 @@ auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
  */
 auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 
+auto DiskManager::GetLogSegmentName(int64_t segment) -> std::string {
+  return log_name_ + "." + std::to_string(segment);
+}
+
 /**
  * Private helper function to get disk file size
  */
@@ -0,0 +1,809 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree.cpp
+//
+// Identification: src/storage/index/adaptive_radix_tree.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <thread>  // NOLINT
+
+#include "common/rid.h"
+#include "storage/index/adaptive_radix_tree.h"
+
+namespace bustub {
+
+namespace {
+constexpr uint64_t OBSOLETE_BIT = 1;
+constexpr uint64_t LOCKED_BIT = 2;
+constexpr uint64_t ACTIVE_MASK = 0xffffffff;
+constexpr uint64_t EPOCH_ONE = ACTIVE_MASK + 1;
+constexpr uintptr_t LEAF_TAG = 1;
+}  // namespace
+
+INDEX_TEMPLATE_ARGUMENTS
+ADAPTIVE_RADIX_TREE_TYPE::AdaptiveRadixTree(const KeyComparator &comparator)
+    : comparator_(comparator), root_(new Node256()) {
+  static_assert(sizeof(KeyType) < 256, "prefix lengths must fit into a byte");
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ADAPTIVE_RADIX_TREE_TYPE::~AdaptiveRadixTree() {
+  FreeSubtree(root_);
+  for (auto &[child, epoch] : retired_) {
+    Free(child);
+  }
+}
+
+/*
+ * Helper function to decide whether current tree is empty. A Node4 always
+ * keeps at least two children, so the root has none only if there are no keys.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::IsEmpty() const -> bool { return root_->count_.load() == 0; }
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result) -> bool {
+  Enter();
+  ValueType value;
+  bool found;
+  while (!TryGetValue(key, &value, &found)) {
+  }
+  Exit();
+  if (found) {
+    result->push_back(value);
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::TryGetValue(const KeyType &key, ValueType *value, bool *found) -> bool {
+  const uint8_t *bytes = KeyBytes(key);
+  Node *node = root_;
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  size_t depth = 0;
+  while (true) {
+    size_t prefix_length = node->prefix_length_.load(std::memory_order_relaxed);
+    if (PrefixMismatch(node, bytes, depth) < prefix_length) {
+      *found = false;
+      return Validate(node, version);
+    }
+    depth += prefix_length;
+    Node *next = FindChild(node, bytes[depth]);
+    if (!Validate(node, version)) {
+      return false;
+    }
+    if (next == nullptr) {
+      *found = false;
+      return true;
+    }
+    if (IsLeaf(next)) {
+      // the leaf was the child at this version, and it never changes
+      Leaf *leaf = ToLeaf(next);
+      *found = comparator_(leaf->key_, key) == 0;
+      if (*found) {
+        *value = leaf->value_;
+      }
+      return true;
+    }
+    uint64_t parent_version = version;
+    Node *parent = node;
+    node = next;
+    depth++;
+    if (!ReadLock(node, &version) || !Validate(parent, parent_version)) {
+      return false;
+    }
+  }
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert constant key & value pair into the tree
+ * @return: since we only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::Insert(const KeyType &key, const ValueType &value) -> bool {
+  Enter();
+  bool inserted;
+  while (!TryInsert(key, value, &inserted)) {
+  }
+  Exit();
+  return inserted;
+}
+
+/*
+ * Descend like a lookup and lock only what changes: the node that gets the
+ * new leaf, and its parent as well if the node is replaced, by a larger one
+ * or by a Node4 that branches off in the middle of its prefix.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::TryInsert(const KeyType &key, const ValueType &value, bool *inserted) -> bool {
+  const uint8_t *bytes = KeyBytes(key);
+  Node *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_byte = 0;
+  Node *node = root_;
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  size_t depth = 0;
+  while (true) {
+    size_t prefix_length = node->prefix_length_.load(std::memory_order_relaxed);
+    size_t mismatch = PrefixMismatch(node, bytes, depth);
+    if (mismatch < prefix_length) {
+      // the root has no prefix, so there is a parent to hang the new Node4 into
+      if (!UpgradeToWriteLock(parent, parent_version)) {
+        return false;
+      }
+      if (!UpgradeToWriteLock(node, version)) {
+        WriteUnlock(parent);
+        return false;
+      }
+      auto branch = new Node4();
+      for (size_t i = 0; i < mismatch; i++) {
+        branch->prefix_[i].store(node->prefix_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+      branch->prefix_length_.store(mismatch, std::memory_order_relaxed);
+      AddChild(branch, node->prefix_[mismatch].load(std::memory_order_relaxed), node);
+      AddChild(branch, bytes[depth + mismatch], FromLeaf(new Leaf{key, value}));
+      // the node keeps what follows the byte it now hangs off
+      for (size_t i = mismatch + 1; i < prefix_length; i++) {
+        node->prefix_[i - mismatch - 1].store(node->prefix_[i].load(std::memory_order_relaxed),
+                                              std::memory_order_relaxed);
+      }
+      node->prefix_length_.store(prefix_length - mismatch - 1, std::memory_order_relaxed);
+      ChangeChild(parent, parent_byte, branch);
+      WriteUnlock(node);
+      WriteUnlock(parent);
+      *inserted = true;
+      return true;
+    }
+
+    depth += prefix_length;
+    uint8_t byte = bytes[depth];
+    Node *next = FindChild(node, byte);
+    if (!Validate(node, version)) {
+      return false;
+    }
+    if (next == nullptr) {
+      if (!IsFull(node)) {
+        if (!UpgradeToWriteLock(node, version)) {
+          return false;
+        }
+        AddChild(node, byte, FromLeaf(new Leaf{key, value}));
+        WriteUnlock(node);
+      } else {
+        if (!UpgradeToWriteLock(parent, parent_version)) {
+          return false;
+        }
+        if (!UpgradeToWriteLock(node, version)) {
+          WriteUnlock(parent);
+          return false;
+        }
+        Node *grown = Resize(node, true);
+        AddChild(grown, byte, FromLeaf(new Leaf{key, value}));
+        ChangeChild(parent, parent_byte, grown);
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        Retire(node);
+      }
+      *inserted = true;
+      return true;
+    }
+
+    if (IsLeaf(next)) {
+      Leaf *leaf = ToLeaf(next);
+      if (comparator_(leaf->key_, key) == 0) {
+        *inserted = false;
+        return true;
+      }
+      if (!UpgradeToWriteLock(node, version)) {
+        return false;
+      }
+      // lazy expansion: the two keys get a Node4 that branches at the first byte they differ in after this one
+      const uint8_t *leaf_bytes = KeyBytes(leaf->key_);
+      size_t shared = depth + 1;
+      while (leaf_bytes[shared] == bytes[shared]) {
+        shared++;
+      }
+      auto branch = new Node4();
+      for (size_t i = depth + 1; i < shared; i++) {
+        branch->prefix_[i - depth - 1].store(bytes[i], std::memory_order_relaxed);
+      }
+      branch->prefix_length_.store(shared - depth - 1, std::memory_order_relaxed);
+      AddChild(branch, leaf_bytes[shared], next);
+      AddChild(branch, bytes[shared], FromLeaf(new Leaf{key, value}));
+      ChangeChild(node, byte, branch);
+      WriteUnlock(node);
+      *inserted = true;
+      return true;
+    }
+
+    parent = node;
+    parent_version = version;
+    parent_byte = byte;
+    node = next;
+    depth++;
+    if (!ReadLock(node, &version) || !Validate(parent, parent_version)) {
+      return false;
+    }
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key
+ * @return: false if the key is not in the tree
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::Remove(const KeyType &key) -> bool {
+  Enter();
+  bool removed;
+  while (!TryRemove(key, &removed)) {
+  }
+  Exit();
+  return removed;
+}
+
+/*
+ * A node that would become too small for its size is replaced by a smaller
+ * copy, and a Node4 that would be left with one child is replaced by that
+ * child, which takes over the Node4's prefix and the byte it hung off. Both
+ * lock the parent first, then the node, then the child, top-down like every
+ * other write.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::TryRemove(const KeyType &key, bool *removed) -> bool {
+  const uint8_t *bytes = KeyBytes(key);
+  Node *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_byte = 0;
+  Node *node = root_;
+  uint64_t version;
+  if (!ReadLock(node, &version)) {
+    return false;
+  }
+  size_t depth = 0;
+  while (true) {
+    size_t prefix_length = node->prefix_length_.load(std::memory_order_relaxed);
+    if (PrefixMismatch(node, bytes, depth) < prefix_length) {
+      *removed = false;
+      return Validate(node, version);
+    }
+    depth += prefix_length;
+    uint8_t byte = bytes[depth];
+    Node *next = FindChild(node, byte);
+    size_t count = node->count_.load(std::memory_order_relaxed);
+    if (!Validate(node, version)) {
+      return false;
+    }
+    if (next == nullptr || (IsLeaf(next) && comparator_(ToLeaf(next)->key_, key) != 0)) {
+      *removed = false;
+      return true;
+    }
+
+    if (IsLeaf(next)) {
+      if (node == root_ || (node->type_ == NodeType::NODE4 ? count > 2 : !IsUnderfull(node))) {
+        if (!UpgradeToWriteLock(node, version)) {
+          return false;
+        }
+        RemoveChild(node, byte);
+        WriteUnlock(node);
+      } else {
+        if (!UpgradeToWriteLock(parent, parent_version)) {
+          return false;
+        }
+        if (!UpgradeToWriteLock(node, version)) {
+          WriteUnlock(parent);
+          return false;
+        }
+        Node *replacement;
+        if (node->type_ != NodeType::NODE4) {
+          replacement = Resize(node, false);
+          RemoveChild(replacement, byte);
+        } else {
+          std::vector<std::pair<uint8_t, Node *>> children;
+          Children(node, &children);
+          auto [other_byte, other] = children[children[0].first == byte ? 1 : 0];
+          if (!IsLeaf(other) && !MergePrefix(node, other_byte, other)) {
+            WriteUnlock(node);
+            WriteUnlock(parent);
+            return false;
+          }
+          replacement = other;
+        }
+        ChangeChild(parent, parent_byte, replacement);
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        Retire(node);
+      }
+      Retire(next);
+      *removed = true;
+      return true;
+    }
+
+    parent = node;
+    parent_version = version;
+    parent_byte = byte;
+    node = next;
+    depth++;
+    if (!ReadLock(node, &version) || !Validate(parent, parent_version)) {
+      return false;
+    }
+  }
+}
+
+/*****************************************************************************
+ * OPTIMISTIC LOCK COUPLING
+ *****************************************************************************/
+/*
+ * Wait until the node is not locked and read its version
+ * @return : false if the node was replaced and the operation must restart
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::ReadLock(Node *node, uint64_t *version) -> bool {
+  uint64_t current = node->version_.load(std::memory_order_acquire);
+  while ((current & LOCKED_BIT) != 0) {
+    std::this_thread::yield();
+    current = node->version_.load(std::memory_order_acquire);
+  }
+  *version = current;
+  return (current & OBSOLETE_BIT) == 0;
+}
+
+/*
+ * @return : whether the node is unchanged since its version was read, so
+ * that what was read from it in between is consistent
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::Validate(Node *node, uint64_t version) -> bool {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return node->version_.load(std::memory_order_relaxed) == version;
+}
+
+/*
+ * Lock the node, if it is unchanged since its version was read
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::UpgradeToWriteLock(Node *node, uint64_t version) -> bool {
+  if (!node->version_.compare_exchange_strong(version, version + LOCKED_BIT, std::memory_order_acquire)) {
+    return false;
+  }
+  // readers that see any of the following writes see the lock as well
+  std::atomic_thread_fence(std::memory_order_release);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::WriteUnlock(Node *node) {
+  node->version_.fetch_add(LOCKED_BIT, std::memory_order_release);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::WriteUnlockObsolete(Node *node) {
+  node->version_.fetch_add(LOCKED_BIT + OBSOLETE_BIT, std::memory_order_release);
+}
+
+/*****************************************************************************
+ * INNER NODES
+ *****************************************************************************/
+/*
+ * Without the node's lock the result is only meaningful once the node's
+ * version is validated, but it is always nullptr or a child the node had.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::FindChild(Node *node, uint8_t byte) -> Node * {
+  switch (node->type_) {
+    case NodeType::NODE4: {
+      auto node4 = static_cast<Node4 *>(node);
+      int count = std::min<int>(node4->count_.load(std::memory_order_relaxed), 4);
+      for (int i = 0; i < count; i++) {
+        if (node4->keys_[i].load(std::memory_order_relaxed) == byte) {
+          return node4->children_[i].load(std::memory_order_acquire);
+        }
+      }
+      return nullptr;
+    }
+    case NodeType::NODE16: {
+      auto node16 = static_cast<Node16 *>(node);
+      int count = std::min<int>(node16->count_.load(std::memory_order_relaxed), 16);
+      for (int i = 0; i < count; i++) {
+        if (node16->keys_[i].load(std::memory_order_relaxed) == byte) {
+          return node16->children_[i].load(std::memory_order_acquire);
+        }
+      }
+      return nullptr;
+    }
+    case NodeType::NODE48: {
+      auto node48 = static_cast<Node48 *>(node);
+      int index = node48->child_index_[byte].load(std::memory_order_relaxed);
+      return index == 0 ? nullptr : node48->children_[index - 1].load(std::memory_order_acquire);
+    }
+    case NodeType::NODE256:
+      return static_cast<Node256 *>(node)->children_[byte].load(std::memory_order_acquire);
+  }
+  return nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::IsFull(Node *node) -> bool {
+  size_t count = node->count_.load(std::memory_order_relaxed);
+  switch (node->type_) {
+    case NodeType::NODE4:
+      return count >= 4;
+    case NodeType::NODE16:
+      return count >= 16;
+    case NodeType::NODE48:
+      return count >= 48;
+    case NodeType::NODE256:
+      return false;
+  }
+  return false;
+}
+
+/*
+ * Whether the node fits into the next smaller size, with room to spare, once
+ * it loses a child. A Node4 is never underfull.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::IsUnderfull(Node *node) -> bool {
+  size_t count = node->count_.load(std::memory_order_relaxed);
+  switch (node->type_) {
+    case NodeType::NODE4:
+      return false;
+    case NodeType::NODE16:
+      return count <= 4;
+    case NodeType::NODE48:
+      return count <= 13;
+    case NodeType::NODE256:
+      return count <= 38;
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::SortedKeys(Node *node) -> std::atomic<uint8_t> * {
+  return node->type_ == NodeType::NODE4 ? static_cast<Node4 *>(node)->keys_ : static_cast<Node16 *>(node)->keys_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::SortedChildren(Node *node) -> std::atomic<Node *> * {
+  return node->type_ == NodeType::NODE4 ? static_cast<Node4 *>(node)->children_
+                                        : static_cast<Node16 *>(node)->children_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::AddChild(Node *node, uint8_t byte, Node *child) {
+  int count = node->count_.load(std::memory_order_relaxed);
+  std::atomic<uint8_t> *keys = nullptr;
+  std::atomic<Node *> *children = nullptr;
+  switch (node->type_) {
+    case NodeType::NODE4:
+      keys = static_cast<Node4 *>(node)->keys_;
+      children = static_cast<Node4 *>(node)->children_;
+      break;
+    case NodeType::NODE16:
+      keys = static_cast<Node16 *>(node)->keys_;
+      children = static_cast<Node16 *>(node)->children_;
+      break;
+    case NodeType::NODE48: {
+      auto node48 = static_cast<Node48 *>(node);
+      int slot = 0;
+      while (node48->children_[slot].load(std::memory_order_relaxed) != nullptr) {
+        slot++;
+      }
+      node48->children_[slot].store(child, std::memory_order_release);
+      node48->child_index_[byte].store(slot + 1, std::memory_order_relaxed);
+      break;
+    }
+    case NodeType::NODE256:
+      static_cast<Node256 *>(node)->children_[byte].store(child, std::memory_order_release);
+      break;
+  }
+  if (keys != nullptr) {
+    // keep the keys sorted
+    int position = count;
+    while (position > 0 && keys[position - 1].load(std::memory_order_relaxed) > byte) {
+      keys[position].store(keys[position - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      children[position].store(children[position - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      position--;
+    }
+    keys[position].store(byte, std::memory_order_relaxed);
+    children[position].store(child, std::memory_order_release);
+  }
+  node->count_.store(count + 1, std::memory_order_relaxed);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::ChangeChild(Node *node, uint8_t byte, Node *child) {
+  switch (node->type_) {
+    case NodeType::NODE4:
+    case NodeType::NODE16: {
+      auto keys = SortedKeys(node);
+      auto children = SortedChildren(node);
+      int count = node->count_.load(std::memory_order_relaxed);
+      for (int i = 0; i < count; i++) {
+        if (keys[i].load(std::memory_order_relaxed) == byte) {
+          children[i].store(child, std::memory_order_release);
+          return;
+        }
+      }
+      return;
+    }
+    case NodeType::NODE48: {
+      auto node48 = static_cast<Node48 *>(node);
+      node48->children_[node48->child_index_[byte].load(std::memory_order_relaxed) - 1].store(
+          child, std::memory_order_release);
+      return;
+    }
+    case NodeType::NODE256:
+      static_cast<Node256 *>(node)->children_[byte].store(child, std::memory_order_release);
+      return;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::RemoveChild(Node *node, uint8_t byte) {
+  int count = node->count_.load(std::memory_order_relaxed);
+  switch (node->type_) {
+    case NodeType::NODE4:
+    case NodeType::NODE16: {
+      auto keys = SortedKeys(node);
+      auto children = SortedChildren(node);
+      int position = 0;
+      while (keys[position].load(std::memory_order_relaxed) != byte) {
+        position++;
+      }
+      for (int i = position + 1; i < count; i++) {
+        keys[i - 1].store(keys[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        children[i - 1].store(children[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+      }
+      break;
+    }
+    case NodeType::NODE48: {
+      auto node48 = static_cast<Node48 *>(node);
+      int index = node48->child_index_[byte].load(std::memory_order_relaxed);
+      node48->child_index_[byte].store(0, std::memory_order_relaxed);
+      node48->children_[index - 1].store(nullptr, std::memory_order_relaxed);
+      break;
+    }
+    case NodeType::NODE256:
+      static_cast<Node256 *>(node)->children_[byte].store(nullptr, std::memory_order_relaxed);
+      break;
+  }
+  node->count_.store(count - 1, std::memory_order_relaxed);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::Children(Node *node, std::vector<std::pair<uint8_t, Node *>> *children) {
+  switch (node->type_) {
+    case NodeType::NODE4:
+    case NodeType::NODE16: {
+      auto keys = SortedKeys(node);
+      auto node_children = SortedChildren(node);
+      int count = node->count_.load(std::memory_order_relaxed);
+      for (int i = 0; i < count; i++) {
+        children->emplace_back(keys[i].load(std::memory_order_relaxed),
+                               node_children[i].load(std::memory_order_relaxed));
+      }
+      return;
+    }
+    case NodeType::NODE48: {
+      auto node48 = static_cast<Node48 *>(node);
+      for (int byte = 0; byte < 256; byte++) {
+        int index = node48->child_index_[byte].load(std::memory_order_relaxed);
+        if (index != 0) {
+          children->emplace_back(byte, node48->children_[index - 1].load(std::memory_order_relaxed));
+        }
+      }
+      return;
+    }
+    case NodeType::NODE256: {
+      auto node256 = static_cast<Node256 *>(node);
+      for (int byte = 0; byte < 256; byte++) {
+        Node *child = node256->children_[byte].load(std::memory_order_relaxed);
+        if (child != nullptr) {
+          children->emplace_back(byte, child);
+        }
+      }
+      return;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::Resize(Node *node, bool grow) -> Node * {
+  Node *resized = nullptr;
+  switch (node->type_) {
+    case NodeType::NODE4:
+      resized = new Node16();
+      break;
+    case NodeType::NODE16:
+      resized = grow ? static_cast<Node *>(new Node48()) : new Node4();
+      break;
+    case NodeType::NODE48:
+      resized = grow ? static_cast<Node *>(new Node256()) : new Node16();
+      break;
+    case NodeType::NODE256:
+      resized = new Node48();
+      break;
+  }
+  size_t prefix_length = node->prefix_length_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < prefix_length; i++) {
+    resized->prefix_[i].store(node->prefix_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+  resized->prefix_length_.store(prefix_length, std::memory_order_relaxed);
+  std::vector<std::pair<uint8_t, Node *>> children;
+  Children(node, &children);
+  for (auto [byte, child] : children) {
+    AddChild(resized, byte, child);
+  }
+  return resized;
+}
+
+/*
+ * Prepend the prefix of the locked node and the byte the child hangs off to
+ * the child's prefix, so that the child can take the node's place. A writer
+ * that holds the child's lock never waits for the node's, so this waits at
+ * most for that writer to finish.
+ * @return : false if the child changed in the meantime
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::MergePrefix(Node *node, uint8_t byte, Node *child) -> bool {
+  uint64_t version;
+  if (!ReadLock(child, &version) || !UpgradeToWriteLock(child, version)) {
+    return false;
+  }
+  size_t node_length = node->prefix_length_.load(std::memory_order_relaxed);
+  size_t child_length = child->prefix_length_.load(std::memory_order_relaxed);
+  for (size_t i = child_length; i-- > 0;) {
+    child->prefix_[node_length + 1 + i].store(child->prefix_[i].load(std::memory_order_relaxed),
+                                              std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < node_length; i++) {
+    child->prefix_[i].store(node->prefix_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+  child->prefix_[node_length].store(byte, std::memory_order_relaxed);
+  child->prefix_length_.store(node_length + 1 + child_length, std::memory_order_relaxed);
+  WriteUnlock(child);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::PrefixMismatch(Node *node, const uint8_t *key, size_t depth) -> size_t {
+  // a length read while the node changes may be out of range, the caller's validation catches that
+  size_t prefix_length = std::min<size_t>(node->prefix_length_.load(std::memory_order_relaxed),
+                                          sizeof(KeyType) - 1 - std::min(depth, sizeof(KeyType) - 1));
+  for (size_t i = 0; i < prefix_length; i++) {
+    if (node->prefix_[i].load(std::memory_order_relaxed) != key[depth + i]) {
+      return i;
+    }
+  }
+  return prefix_length;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::KeyBytes(const KeyType &key) -> const uint8_t * {
+  return reinterpret_cast<const uint8_t *>(&key);
+}
+
+/*****************************************************************************
+ * LEAVES AND MEMORY
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::IsLeaf(const Node *child) -> bool {
+  return (reinterpret_cast<uintptr_t>(child) & LEAF_TAG) != 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::ToLeaf(Node *child) -> Leaf * {
+  return reinterpret_cast<Leaf *>(reinterpret_cast<uintptr_t>(child) & ~LEAF_TAG);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_TYPE::FromLeaf(Leaf *leaf) -> Node * {
+  return reinterpret_cast<Node *>(reinterpret_cast<uintptr_t>(leaf) | LEAF_TAG);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::Free(Node *child) {
+  if (IsLeaf(child)) {
+    delete ToLeaf(child);
+    return;
+  }
+  switch (child->type_) {
+    case NodeType::NODE4:
+      delete static_cast<Node4 *>(child);
+      return;
+    case NodeType::NODE16:
+      delete static_cast<Node16 *>(child);
+      return;
+    case NodeType::NODE48:
+      delete static_cast<Node48 *>(child);
+      return;
+    case NodeType::NODE256:
+      delete static_cast<Node256 *>(child);
+      return;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::FreeSubtree(Node *child) {
+  if (!IsLeaf(child)) {
+    std::vector<std::pair<uint8_t, Node *>> children;
+    Children(child, &children);
+    for (auto [byte, grandchild] : children) {
+      FreeSubtree(grandchild);
+    }
+  }
+  Free(child);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::Enter() { epoch_.fetch_add(1); }
+
+/*
+ * The last operation to leave, if there are retired nodes, starts a new
+ * epoch. At that moment no operation runs, so nothing retired in an earlier
+ * epoch can still be read: operations that started later never saw it in the
+ * tree. Under constant load retired nodes wait for the next such moment.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::Exit() {
+  uint64_t state = epoch_.fetch_sub(1) - 1;
+  if ((state & ACTIVE_MASK) != 0 || retired_size_.load() == 0) {
+    return;
+  }
+  if (!epoch_.compare_exchange_strong(state, state + EPOCH_ONE)) {
+    return;
+  }
+  uint64_t epoch = state / EPOCH_ONE;
+  std::vector<std::pair<Node *, uint64_t>> freed;
+  {
+    std::scoped_lock latch(retired_latch_);
+    auto kept = std::partition(retired_.begin(), retired_.end(),
+                               [epoch](const std::pair<Node *, uint64_t> &retired) { return retired.second > epoch; });
+    freed.assign(kept, retired_.end());
+    retired_.erase(kept, retired_.end());
+    retired_size_.store(retired_.size());
+  }
+  for (auto &[child, retired_epoch] : freed) {
+    Free(child);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_TYPE::Retire(Node *child) {
+  std::scoped_lock latch(retired_latch_);
+  retired_.emplace_back(child, epoch_.load() / EPOCH_ONE);
+  retired_size_.store(retired_.size());
+}
+
+template class AdaptiveRadixTree<GenericKey<4>, RID, GenericComparator<4>>;
+template class AdaptiveRadixTree<GenericKey<8>, RID, GenericComparator<8>>;
+template class AdaptiveRadixTree<GenericKey<16>, RID, GenericComparator<16>>;
+template class AdaptiveRadixTree<GenericKey<32>, RID, GenericComparator<32>>;
+template class AdaptiveRadixTree<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
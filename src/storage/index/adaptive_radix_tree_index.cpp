@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree_index.cpp
+//
+// Identification: src/storage/index/adaptive_radix_tree_index.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/adaptive_radix_tree_index.h"
+
+namespace bustub {
+/*
+ * Constructor
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ADAPTIVE_RADIX_TREE_INDEX_TYPE::AdaptiveRadixTreeIndex(std::unique_ptr<IndexMetadata> &&metadata,
+                                                       BufferPoolManager *buffer_pool_manager)
+    : Index(std::move(metadata)),
+      comparator_(GetMetadata()->GetKeySchema()),
+      container_(comparator_),
+      posting_list_(buffer_pool_manager) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  // construct insert index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
+
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Insert(PostingEntry(index_key), rid);
+    return;
+  }
+  container_.Insert(index_key, rid);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  // construct delete index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
+
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Remove(PostingEntry(index_key), rid);
+    return;
+  }
+  container_.Remove(index_key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void ADAPTIVE_RADIX_TREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  // construct scan index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
+
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Scan(PostingEntry(index_key), result);
+    return;
+  }
+  container_.GetValue(index_key, result);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto ADAPTIVE_RADIX_TREE_INDEX_TYPE::PostingEntry(const KeyType &index_key) -> PostingList::Entry {
+  return {[this, &index_key](RID *value) {
+            std::vector<RID> values;
+            if (!container_.GetValue(index_key, &values)) {
+              return false;
+            }
+            *value = values[0];
+            return true;
+          },
+          [this, &index_key](const RID &value) { container_.Insert(index_key, value); },
+          [this, &index_key](const RID &) { container_.Remove(index_key); }};
+}
+
+template class AdaptiveRadixTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
+template class AdaptiveRadixTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
+template class AdaptiveRadixTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
+template class AdaptiveRadixTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
+template class AdaptiveRadixTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
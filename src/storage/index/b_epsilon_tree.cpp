@@ -0,0 +1,344 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/index/b_epsilon_tree.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "storage/index/b_epsilon_tree.h"
+#include "storage/page/header_page.h"
+
+namespace bustub {
+INDEX_TEMPLATE_ARGUMENTS
+B_EPSILON_TREE_TYPE::BEpsilonTree(std::string name, BufferPoolManager *buffer_pool_manager,
+                                  const KeyComparator &comparator, int leaf_max_size, int internal_max_size,
+                                  int buffer_max_size)
+    : index_name_(std::move(name)),
+      root_page_id_(INVALID_PAGE_ID),
+      buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      leaf_max_size_(leaf_max_size),
+      internal_max_size_(internal_max_size),
+      buffer_max_size_(buffer_max_size > 0 ? buffer_max_size : B_EPSILON_TREE_BUFFER_SIZE(internal_max_size)) {
+  BUSTUB_ASSERT(leaf_max_size_ >= 2 && leaf_max_size_ <= B_EPSILON_TREE_LEAF_PAGE_SIZE, "leaf max size out of range");
+  BUSTUB_ASSERT(internal_max_size_ >= 3 && buffer_max_size_ >= 1 &&
+                    buffer_max_size_ <= B_EPSILON_TREE_BUFFER_SIZE(internal_max_size_),
+                "internal page sizes out of range");
+}
+
+/*
+ * Helper function to decide whether current tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key. A message found on
+ * the way down is newer than anything below it, the leaf is only read if
+ * there is none.
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction)
+    -> bool {
+  latch_.RLock();
+  bool found = false;
+  ValueType value;
+  page_id_t page_id = root_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto node = reinterpret_cast<BPlusTreePage *>(FetchTreePage(page_id)->GetData());
+    page_id_t child_page_id = INVALID_PAGE_ID;
+    if (node->IsLeafPage()) {
+      found = reinterpret_cast<LeafPage *>(node)->Lookup(key, &value, comparator_);
+    } else {
+      auto internal = reinterpret_cast<InternalPage *>(node);
+      const Message *message = internal->FindMessage(key, comparator_);
+      if (message != nullptr) {
+        found = message->type_ == BEpsilonTreeMessageType::UPSERT;
+        value = message->value_;
+      } else {
+        child_page_id = internal->ValueAt(internal->ChildIndex(key, comparator_));
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = child_page_id;
+  }
+  latch_.RUnlock();
+
+  if (found) {
+    result->push_back(value);
+  }
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION AND DELETION
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  Put({key, value, BEpsilonTreeMessageType::UPSERT});
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  Put({key, ValueType(), BEpsilonTreeMessageType::DELETE});
+}
+
+/*
+ * Add a message to the root. A root that is still a leaf applies it right
+ * away. A full root buffer is flushed first, and a root that ends up full
+ * of children is split, whose new root then takes the message.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::Put(const Message &message) {
+  latch_.WLock();
+  if (IsEmpty()) {
+    if (message.type_ == BEpsilonTreeMessageType::DELETE) {
+      latch_.WUnlock();
+      return;
+    }
+    Page *page = NewTreePage(&root_page_id_);
+    reinterpret_cast<LeafPage *>(page->GetData())->Init(root_page_id_, leaf_max_size_);
+    UpdateRootPageId(1);
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  }
+
+  auto root = reinterpret_cast<BPlusTreePage *>(FetchTreePage(root_page_id_)->GetData());
+  if (root->IsLeafPage()) {
+    auto leaf = reinterpret_cast<LeafPage *>(root);
+    ValueType value;
+    if (message.type_ == BEpsilonTreeMessageType::DELETE) {
+      leaf->Delete(message.key_, comparator_);
+    } else if (leaf->GetSize() < leaf->GetMaxSize() || leaf->Lookup(message.key_, &value, comparator_)) {
+      leaf->Upsert(message.key_, message.value_, comparator_);
+    } else {
+      root = SplitRoot(root);
+    }
+  }
+  if (!root->IsLeafPage()) {
+    auto node = reinterpret_cast<InternalPage *>(root);
+    if (!node->PutMessage(message, comparator_)) {
+      FlushBuffer(node);
+      if (node->GetSize() == node->GetMaxSize()) {
+        node = SplitRoot(node);
+      }
+      bool put = node->PutMessage(message, comparator_);
+      BUSTUB_ASSERT(put, "a flushed buffer has room");
+      root = node;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
+  latch_.WUnlock();
+}
+
+/*
+ * Flush the messages for the child that has the most of them until the
+ * buffer is no longer full, or the node has max size children and must be
+ * split before any child can split again
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::FlushBuffer(InternalPage *node) {
+  while (node->IsBufferFull() && node->GetSize() < node->GetMaxSize()) {
+    int heaviest = 0;
+    int most = -1;
+    for (int i = 0; i < node->GetSize(); i++) {
+      int begin;
+      int end;
+      node->ChildMessages(i, comparator_, &begin, &end);
+      if (end - begin > most) {
+        heaviest = i;
+        most = end - begin;
+      }
+    }
+
+    auto child = reinterpret_cast<BPlusTreePage *>(FetchTreePage(node->ValueAt(heaviest))->GetData());
+    if (child->IsLeafPage()) {
+      FlushToLeaf(node, heaviest, reinterpret_cast<LeafPage *>(child));
+    } else {
+      FlushToInternal(node, heaviest, reinterpret_cast<InternalPage *>(child));
+    }
+  }
+}
+
+/*
+ * Move as many of the messages for the child as its buffer takes, after
+ * making room in it if it is full. A child that has max size children
+ * afterwards is split instead. Unpins the child.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::FlushToInternal(InternalPage *node, int index, InternalPage *child) {
+  if (child->IsBufferFull()) {
+    FlushBuffer(child);
+  }
+  if (child->GetSize() < child->GetMaxSize()) {
+    int begin;
+    int end;
+    node->ChildMessages(index, comparator_, &begin, &end);
+    int moved = begin;
+    while (moved < end && child->PutMessage(node->MessageAt(moved), comparator_)) {
+      moved++;
+    }
+    node->RemoveMessages(begin, moved);
+  } else {
+    KeyType middle_key;
+    Page *sibling = Split(child, &middle_key);
+    node->InsertChildAfter(index, middle_key, sibling->GetPageId());
+    buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(child->GetPageId(), true);
+}
+
+/*
+ * Apply the messages for the child to the leaf in key order. A full leaf
+ * that gets a new key is split, and each message goes to the leaf its key
+ * belongs to by then. Stops short if the node has no room for another leaf.
+ * Unpins the leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::FlushToLeaf(InternalPage *node, int index, LeafPage *leaf) {
+  int begin;
+  int end;
+  node->ChildMessages(index, comparator_, &begin, &end);
+  int applied = begin;
+  for (; applied < end; applied++) {
+    const Message &message = node->MessageAt(applied);
+    int child_index = node->ChildIndex(message.key_, comparator_);
+    if (child_index != index) {
+      buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+      leaf = reinterpret_cast<LeafPage *>(FetchTreePage(node->ValueAt(child_index))->GetData());
+      index = child_index;
+    }
+    if (message.type_ == BEpsilonTreeMessageType::DELETE) {
+      leaf->Delete(message.key_, comparator_);
+      continue;
+    }
+    ValueType value;
+    if (leaf->GetSize() == leaf->GetMaxSize() && !leaf->Lookup(message.key_, &value, comparator_)) {
+      if (node->GetSize() == node->GetMaxSize()) {
+        break;
+      }
+      KeyType middle_key;
+      Page *sibling = Split(leaf, &middle_key);
+      node->InsertChildAfter(index, middle_key, sibling->GetPageId());
+      if (comparator_(message.key_, middle_key) >= 0) {
+        buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+        leaf = reinterpret_cast<LeafPage *>(sibling->GetData());
+        index++;
+      } else {
+        buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+      }
+    }
+    leaf->Upsert(message.key_, message.value_, comparator_);
+  }
+  node->RemoveMessages(begin, applied);
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+}
+
+/*
+ * Move the upper half of a full page to a new sibling, which is returned
+ * pinned, and set middle_key to the key between them
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_TYPE::Split(BPlusTreePage *node, KeyType *middle_key) -> Page * {
+  page_id_t sibling_page_id;
+  Page *sibling = NewTreePage(&sibling_page_id);
+  if (node->IsLeafPage()) {
+    auto sibling_leaf = reinterpret_cast<LeafPage *>(sibling->GetData());
+    sibling_leaf->Init(sibling_page_id, leaf_max_size_);
+    reinterpret_cast<LeafPage *>(node)->MoveHalfTo(sibling_leaf);
+    *middle_key = sibling_leaf->KeyAt(0);
+  } else {
+    auto sibling_internal = reinterpret_cast<InternalPage *>(sibling->GetData());
+    sibling_internal->Init(sibling_page_id, internal_max_size_, buffer_max_size_);
+    *middle_key = reinterpret_cast<InternalPage *>(node)->MoveHalfTo(sibling_internal, comparator_);
+  }
+  return sibling;
+}
+
+/*
+ * Split the root under a new root with an empty buffer, which is returned
+ * pinned in place of the old one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_TYPE::SplitRoot(BPlusTreePage *root) -> InternalPage * {
+  KeyType middle_key;
+  Page *sibling = Split(root, &middle_key);
+  page_id_t new_root_page_id;
+  auto new_root = reinterpret_cast<InternalPage *>(NewTreePage(&new_root_page_id)->GetData());
+  new_root->Init(new_root_page_id, internal_max_size_, buffer_max_size_);
+  new_root->PopulateNewRoot(root->GetPageId(), middle_key, sibling->GetPageId());
+  buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
+  root_page_id_ = new_root_page_id;
+  UpdateRootPageId();
+  return new_root;
+}
+
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+/*
+ * Fetch a page of this tree, throwing an "out of memory" exception if the
+ * buffer pool has no frame left for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_TYPE::FetchTreePage(page_id_t page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a b epsilon tree page");
+  }
+  return page;
+}
+
+/*
+ * Allocate a page for this tree, throwing an "out of memory" exception if the
+ * buffer pool has no frame left for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_TYPE::NewTreePage(page_id_t *page_id) -> Page * {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a b epsilon tree page");
+  }
+  return page;
+}
+
+/*
+ * Update/Insert root page id in header page(where page_id = 0, header_page is
+ * defined under include/page/header_page.h)
+ * Call this method everytime root page id is changed.
+ * @parameter: insert_record      defualt value is false. When set to true,
+ * insert a record <index_name, root_page_id> into header page instead of
+ * updating it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_TYPE::UpdateRootPageId(int insert_record) {
+  auto header_page = static_cast<HeaderPage *>(FetchTreePage(HEADER_PAGE_ID));
+  header_page->WLatch();
+  if (insert_record != 0) {
+    header_page->InsertRecord(index_name_, root_page_id_);
+  } else {
+    header_page->UpdateRecord(index_name_, root_page_id_);
+  }
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+template class BEpsilonTree<GenericKey<4>, RID, GenericComparator<4>>;
+template class BEpsilonTree<GenericKey<8>, RID, GenericComparator<8>>;
+template class BEpsilonTree<GenericKey<16>, RID, GenericComparator<16>>;
+template class BEpsilonTree<GenericKey<32>, RID, GenericComparator<32>>;
+template class BEpsilonTree<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
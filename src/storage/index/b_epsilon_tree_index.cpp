@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/index/b_epsilon_tree_index.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/b_epsilon_tree_index.h"
+
+namespace bustub {
+/*
+ * Constructor
+ */
+INDEX_TEMPLATE_ARGUMENTS
+B_EPSILON_TREE_INDEX_TYPE::BEpsilonTreeIndex(std::unique_ptr<IndexMetadata> &&metadata,
+                                             BufferPoolManager *buffer_pool_manager)
+    : Index(std::move(metadata)),
+      comparator_(GetMetadata()->GetKeySchema()),
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_),
+      posting_list_(buffer_pool_manager) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  // construct insert index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
+
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Insert(PostingEntry(index_key, transaction), rid);
+    return;
+  }
+  container_.Insert(index_key, rid, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  // construct delete index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
+
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Remove(PostingEntry(index_key, transaction), rid);
+    return;
+  }
+  container_.Remove(index_key, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  // construct scan index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
+
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Scan(PostingEntry(index_key, transaction), result);
+    return;
+  }
+  container_.GetValue(index_key, result, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INDEX_TYPE::PostingEntry(const KeyType &index_key, Transaction *transaction)
+    -> PostingList::Entry {
+  return {[this, &index_key, transaction](RID *value) {
+            std::vector<RID> values;
+            container_.GetValue(index_key, &values, transaction);
+            if (values.empty()) {
+              return false;
+            }
+            *value = values[0];
+            return true;
+          },
+          [this, &index_key, transaction](const RID &value) { container_.Insert(index_key, value, transaction); },
+          [this, &index_key, transaction](const RID &) { container_.Remove(index_key, transaction); }};
+}
+
+template class BEpsilonTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
+template class BEpsilonTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
+template class BEpsilonTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
+template class BEpsilonTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
+template class BEpsilonTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
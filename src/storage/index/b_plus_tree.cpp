@@ -9,30 +9,38 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/rid.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/external_sort.h"
 #include "storage/page/header_page.h"
 
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, BPlusTreeMode mode)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      b_link_(mode == BPlusTreeMode::B_LINK) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -43,7 +51,19 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  return false;
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return false;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType value;
+  bool found = leaf->Lookup(key, &value, comparator_);
+  if (found) {
+    result->push_back(value);
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
 }
 
 /*****************************************************************************
@@ -58,7 +78,40 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  if (b_link_) {
+    return InsertBLink(key, value);
+  }
+  // optimistic pass: settle the insert inside the leaf if it cannot split
+  Page *page = FindLeafPageOptimistic(key, BPlusTreeOperation::INSERT);
+  if (page != nullptr) {
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    ValueType existing;
+    bool duplicate = leaf->Lookup(key, &existing, comparator_);
+    bool settled = duplicate || IsSafe(leaf, BPlusTreeOperation::INSERT, key);
+    if (settled && !duplicate) {
+      leaf->Insert(key, value, comparator_);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), settled && !duplicate);
+    if (settled) {
+      return !duplicate;
+    }
+  }
+
+  // pessimistic pass: the leaf splits (or the tree is empty), so hold every unsafe node on the path
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  page = FindLeafPagePessimistic(key, BPlusTreeOperation::INSERT, transaction);
+  bool inserted = true;
+  if (page == nullptr) {
+    StartNewTree(key, value);
+  } else {
+    inserted = InsertIntoLeaf(key, value, transaction);
+  }
+  ReleaseLatchedPages(transaction, inserted);
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -67,19 +120,53 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  Page *page = NewTreePage(&page_id);
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  leaf->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
  * User needs to first find the right leaf page as insertion target, then look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
+ * The target leaf is the last page latched by FindLeafPagePessimistic().
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  auto leaf = reinterpret_cast<LeafPage *>(transaction->GetPageSet()->back()->GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, &existing, comparator_)) {
+    return false;
+  }
+  LeafPage *new_leaf = nullptr;
+  if (leaf->HasRoomFor(key)) {
+    leaf->Insert(key, value, comparator_);
+    if (leaf->GetSize() >= leaf->GetMaxSize()) {
+      new_leaf = Split(leaf);
+    }
+  } else {
+    // the key shares too little with the others to fit, but either half of the leaf has room for it
+    new_leaf = Split(leaf);
+    (comparator_(key, new_leaf->KeyAt(0)) < 0 ? leaf : new_leaf)->Insert(key, value, comparator_);
+  }
+  if (new_leaf != nullptr) {
+    new_leaf->SetNextPageId(leaf->GetNextPageId());
+    new_leaf->SetPrevPageId(leaf->GetPageId());
+    leaf->SetNextPageId(new_leaf->GetPageId());
+    LinkBack(new_leaf->GetNextPageId(), new_leaf->GetPageId());
+    InsertIntoParent(leaf, Separator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0)), new_leaf, transaction);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  }
+  return true;
 }
 
 /*
@@ -88,11 +175,25 @@ auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page stays pinned; it is unreachable until the parent, which the
+ * caller holds write latched, points at it. In B-link mode it is unreachable
+ * until the caller links the split page to it, and the moved children keep
+ * their stale parent ids.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::Split(N *node) -> N * {
-  return nullptr;
+  page_id_t page_id;
+  Page *page = NewTreePage(&page_id);
+  auto new_node = reinterpret_cast<N *>(page->GetData());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    new_node->Init(page_id, node->GetParentPageId(), leaf_max_size_);
+    node->MoveHalfTo(new_node);
+  } else {
+    new_node->Init(page_id, node->GetParentPageId(), internal_max_size_);
+    node->MoveHalfTo(new_node, b_link_ ? nullptr : buffer_pool_manager_);
+  }
+  return new_node;
 }
 
 /*
@@ -106,7 +207,44 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    page_id_t root_page_id;
+    Page *page = NewTreePage(&root_page_id);
+    auto root = reinterpret_cast<InternalPage *>(page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId(0);
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  // the parent is unsafe for this insert, so it is already write latched by us
+  page_id_t parent_page_id = old_node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(FetchTreePage(parent_page_id)->GetData());
+  new_node->SetParentPageId(parent_page_id);
+  InternalPage *new_internal = nullptr;
+  if (parent->HasRoomFor(key)) {
+    parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+    if (parent->GetSize() > parent->GetMaxSize()) {
+      new_internal = Split(parent);
+    }
+  } else {
+    // the key shares too little with the others to fit, but either half of the parent has room for it
+    new_internal = Split(parent);
+    InternalPage *target = parent->ValueIndex(old_node->GetPageId()) == -1 ? new_internal : parent;
+    target->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+    new_node->SetParentPageId(target->GetPageId());
+  }
+  if (new_internal != nullptr) {
+    InsertIntoParent(parent, new_internal->KeyAt(0), new_internal, transaction);
+    buffer_pool_manager_->UnpinPage(new_internal->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -119,11 +257,51 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (b_link_) {
+    RemoveBLink(key);
+    return;
+  }
+  // optimistic pass: settle the delete inside the leaf if it cannot underflow
+  Page *page = FindLeafPageOptimistic(key, BPlusTreeOperation::REMOVE);
+  if (page == nullptr) {
+    return;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  bool present = leaf->Lookup(key, &existing, comparator_);
+  bool settled = !present || IsSafe(leaf, BPlusTreeOperation::REMOVE, key);
+  if (settled && present) {
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), settled && present);
+  if (settled) {
+    return;
+  }
+
+  // pessimistic pass: the leaf underflows, so hold every unsafe node on the path
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
+  page = FindLeafPagePessimistic(key, BPlusTreeOperation::REMOVE, transaction);
+  bool removed = false;
+  if (page != nullptr) {
+    leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    int size = leaf->GetSize();
+    removed = leaf->RemoveAndDeleteRecord(key, comparator_) < size;
+    if (removed) {
+      CoalesceOrRedistribute(leaf, transaction);
+    }
+  }
+  ReleaseLatchedPages(transaction, removed);
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
+ * page's size > page's max size, or their keys together do not fit into one
+ * page, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
@@ -131,7 +309,44 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool {
-  return false;
+  if (node->IsRootPage()) {
+    bool root_deleted = AdjustRoot(node);
+    if (root_deleted) {
+      transaction->AddIntoDeletedPageSet(node->GetPageId());
+    }
+    return root_deleted;
+  }
+  if (node->GetSize() >= node->GetMinSize()) {
+    return false;
+  }
+
+  // the parent is unsafe for this delete, so it is already write latched by us; the sibling is not
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(FetchTreePage(parent_page_id)->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  Page *sibling_page = FetchTreePage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  sibling_page->WLatch();
+  auto sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // a leaf splits as soon as it is full, so two leaves only merge if the result stays below max size
+  int capacity = node->IsLeafPage() ? node->GetMaxSize() - 1 : node->GetMaxSize();
+  bool fits;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    fits = sibling->HasRoomForAll(node);
+  } else {
+    fits = sibling->HasRoomForAll(node, parent->KeyAt(index == 0 ? 1 : index));
+  }
+  bool node_deleted = false;
+  if (sibling->GetSize() + node->GetSize() <= capacity && fits) {
+    node_deleted = index != 0;
+    Coalesce(&sibling, &node, &parent, index, transaction);
+  } else {
+    Redistribute(sibling, node, index, transaction);
+  }
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+  return node_deleted;
 }
 
 /*
@@ -140,6 +355,8 @@ auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -
  * take info of deletion into account. Remember to deal with coalesce or
  * redistribute recursively if necessary.
  * Using template N to represent either internal page or leaf page.
+ * The right page of the pair is always the one merged away, so pages are only
+ * ever deleted while their left neighbour is write latched.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
@@ -151,7 +368,19 @@ template <typename N>
 auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
                               Transaction *transaction) -> bool {
-  return false;
+  if (index == 0) {
+    std::swap(*neighbor_node, *node);
+  }
+  int node_index = (*parent)->ValueIndex((*node)->GetPageId());
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    (*node)->MoveAllTo(*neighbor_node);
+    LinkBack((*neighbor_node)->GetNextPageId(), (*neighbor_node)->GetPageId());
+  } else {
+    (*node)->MoveAllTo(*neighbor_node, (*parent)->KeyAt(node_index), buffer_pool_manager_);
+  }
+  transaction->AddIntoDeletedPageSet((*node)->GetPageId());
+  (*parent)->Remove(node_index);
+  return CoalesceOrRedistribute(*parent, transaction);
 }
 
 /*
@@ -165,7 +394,52 @@ auto BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index, Transaction *transaction) {
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(FetchTreePage(parent_page_id)->GetData());
+  if (index == 0) {
+    int separator = parent->ValueIndex(neighbor_node->GetPageId());
+    KeyType key;
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveFirstToEndOf(node);
+      key = Separator(node->KeyAt(node->GetSize() - 1), neighbor_node->KeyAt(0));
+    } else {
+      neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(separator), buffer_pool_manager_);
+      key = neighbor_node->KeyAt(0);
+    }
+    ReplaceSeparator(parent, separator, node, neighbor_node, key, transaction);
+  } else {
+    int separator = parent->ValueIndex(node->GetPageId());
+    KeyType key;
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveLastToFrontOf(node);
+      key = Separator(neighbor_node->KeyAt(neighbor_node->GetSize() - 1), node->KeyAt(0));
+    } else {
+      neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(separator), buffer_pool_manager_);
+      key = node->KeyAt(0);
+    }
+    ReplaceSeparator(parent, separator, neighbor_node, node, key, transaction);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
+
+/*
+ * Replace the separator at index of parent, which sits between the left and
+ * right page. The new key may share less with the other separators than the
+ * old one and not fit, in which case it is re-inserted and the parent splits.
+ * The parent is unsafe for this delete if that can happen, so everything up
+ * to the first page with room for another key is still write latched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReplaceSeparator(InternalPage *parent, int index, BPlusTreePage *left, BPlusTreePage *right,
+                                      const KeyType &key, Transaction *transaction) {
+  if (parent->HasRoomFor(key)) {
+    parent->SetKeyAt(index, key);
+    return;
+  }
+  parent->Remove(index);
+  InsertIntoParent(left, key, right, transaction);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -177,7 +451,492 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return false; }
+auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool {
+  if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
+    page_id_t child_page_id = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+    auto child = reinterpret_cast<BPlusTreePage *>(FetchTreePage(child_page_id)->GetData());
+    child->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(child_page_id, true);
+    root_page_id_ = child_page_id;
+    UpdateRootPageId(0);
+    return true;
+  }
+  if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId(0);
+    return true;
+  }
+  return false;
+}
+
+/*****************************************************************************
+ * B-LINK MODE
+ *****************************************************************************/
+/*
+ * Insert in B-link mode. The leaf is found without holding any latch above it,
+ * and a split is pushed up one level at a time by InsertIntoParentBLink().
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertBLink(const KeyType &key, const ValueType &value) -> bool {
+  std::vector<page_id_t> path;
+  Page *page = FindLeafPageBLink(key, false, true, &path);
+  if (page == nullptr) {
+    root_latch_.WLock();
+    if (root_page_id_ == INVALID_PAGE_ID) {
+      StartNewTree(key, value);
+      root_latch_.WUnlock();
+      return true;
+    }
+    // another insert started the tree first; a B-link tree never empties out again
+    root_latch_.WUnlock();
+    page = FindLeafPageBLink(key, false, true, &path);
+  }
+
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  bool duplicate = leaf->Lookup(key, &existing, comparator_);
+  if (duplicate || IsSafe(leaf, BPlusTreeOperation::INSERT, key)) {
+    if (!duplicate) {
+      leaf->Insert(key, value, comparator_);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), !duplicate);
+    return !duplicate;
+  }
+  LeafPage *new_leaf;
+  if (leaf->HasRoomFor(key)) {
+    leaf->Insert(key, value, comparator_);
+    new_leaf = Split(leaf);
+  } else {
+    new_leaf = Split(leaf);
+    (comparator_(key, new_leaf->KeyAt(0)) < 0 ? leaf : new_leaf)->Insert(key, value, comparator_);
+  }
+  KeyType separator = Separator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0));
+  LinkRight(leaf, new_leaf, separator);
+  page_id_t new_page_id = new_leaf->GetPageId();
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  InsertIntoParentBLink(page, separator, new_page_id, &path);
+  return true;
+}
+
+/*
+ * Link the page split off from the write latched page into the level above,
+ * splitting further up as needed, in B-link mode. The split page is released
+ * before its parent is latched. The parent is the top of path, or a page right
+ * of it if it split in the meantime. A root split takes the root latch while
+ * the old root is still held, so every page other than the root has a level
+ * above it by the time anyone can reach it; if the path ran out because the
+ * descent started below a root raised since, the tree is descended again.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParentBLink(Page *page, const KeyType &key, page_id_t new_page_id,
+                                           std::vector<page_id_t> *path) {
+  KeyType separator = key;
+  size_t level = 0;
+  while (true) {
+    page_id_t page_id = page->GetPageId();
+    if (path->empty()) {
+      root_latch_.WLock();
+      if (root_page_id_ == page_id) {
+        page_id_t root_page_id;
+        Page *root_page = NewTreePage(&root_page_id);
+        auto root = reinterpret_cast<InternalPage *>(root_page->GetData());
+        root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+        root->PopulateNewRoot(page_id, separator, new_page_id);
+        root_page_id_ = root_page_id;
+        UpdateRootPageId(0);
+        buffer_pool_manager_->UnpinPage(root_page_id, true);
+        root_latch_.WUnlock();
+        page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, true);
+        return;
+      }
+      root_latch_.WUnlock();
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    if (path->empty()) {
+      Page *leaf_page = FindLeafPageBLink(separator, false, false, path);
+      leaf_page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+      BUSTUB_ASSERT(path->size() > level, "every page below the root has a level above it");
+      path->resize(path->size() - level);
+    }
+
+    page = FetchTreePage(path->back());
+    path->pop_back();
+    page->WLatch();
+    page = MoveRight(page, separator, true);
+    level++;
+    auto parent = reinterpret_cast<InternalPage *>(page->GetData());
+    InternalPage *new_internal = nullptr;
+    if (parent->HasRoomFor(separator)) {
+      parent->InsertNode(separator, new_page_id);
+      if (parent->GetSize() > parent->GetMaxSize()) {
+        new_internal = Split(parent);
+      }
+    } else {
+      new_internal = Split(parent);
+      (comparator_(separator, new_internal->KeyAt(0)) < 0 ? parent : new_internal)->InsertNode(separator, new_page_id);
+    }
+    if (new_internal == nullptr) {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+      return;
+    }
+    separator = new_internal->KeyAt(0);
+    LinkRight(parent, new_internal, separator);
+    new_page_id = new_internal->GetPageId();
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+  }
+}
+
+/*
+ * Remove in B-link mode. The key is only taken out of its leaf, which may end
+ * up below min size or even empty but stays linked, so no page is ever freed
+ * while another operation may be about to move onto it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveBLink(const KeyType &key) {
+  Page *page = FindLeafPageBLink(key, false, true, nullptr);
+  if (page == nullptr) {
+    return;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int size = leaf->GetSize();
+  bool removed = leaf->RemoveAndDeleteRecord(key, comparator_) < size;
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+}
+
+/*
+ * Make the page split off from node its right sibling in B-link mode: the new
+ * page takes over node's right link and high key, and node now ends at
+ * high_key. A leaf after the new page is linked back to it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N>
+void BPLUSTREE_TYPE::LinkRight(N *node, N *right_node, const KeyType &high_key) {
+  right_node->SetNextPageId(node->GetNextPageId());
+  right_node->SetHighKey(node->GetHighKey());
+  node->SetNextPageId(right_node->GetPageId());
+  node->SetHighKey(high_key);
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    right_node->SetPrevPageId(node->GetPageId());
+    LinkBack(right_node->GetNextPageId(), right_node->GetPageId());
+  }
+}
+
+/*
+ * Point the previous page id of a leaf at prev_page_id, after the leaf left
+ * of it changed. The leaf is not latched: it may belong to another parent,
+ * whose writers can hold it while waiting for the left sibling of their
+ * parent, which a delete under the caller may hold, so latching it here,
+ * even left to right, could deadlock.
+ * Writing it unlatched is still safe:
+ * 1. The previous page id is a std::atomic, so a reverse iterator reading it
+ *    under its read latch while it is stored here does not race, it sees
+ *    either the old or the new id.
+ * 2. Writers of the field are serialized by the write latch of the leaf left
+ *    of it, which the caller holds, so stores to it do not interleave.
+ * 3. Nothing else in the leaf depends on it. A reverse iterator only takes it
+ *    as a hint: after latching the leaf it points to, it checks that the
+ *    leaf's next page id leads back, and descends from the root otherwise
+ *    (IndexIterator::SkipExhaustedLeavesBackward()). A stale id costs a
+ *    descent, never a wrong or missed key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::LinkBack(page_id_t page_id, page_id_t prev_page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  Page *page = FetchTreePage(page_id);
+  reinterpret_cast<LeafPage *>(page->GetData())->SetPrevPageId(prev_page_id);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Build the tree bottom-up from key & value pairs produced in ascending key
+ * order, which is much cheaper than inserting them one by one: every page is
+ * written once, left to right, and nothing ever splits.
+ * Leaves are filled to fill_factor of their capacity and internal pages to
+ * fill_factor of their fanout, but never below min size. Duplicate keys are
+ * skipped. The root latch is held for the whole load.
+ * Input out of key order throws, after deleting every page built so far, so
+ * that the tree is left empty instead of holding a prefix of the input.
+ * @return: false if the tree is not empty, in which case nothing is consumed
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(KeyType *, ValueType *)> &next_entry, double fill_factor)
+    -> bool {
+  BUSTUB_ASSERT(fill_factor > 0 && fill_factor <= 1, "fill factor must be in (0, 1]");
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    return false;
+  }
+
+  BulkLoadContext context;
+  // a leaf splits as soon as it reaches max size, so it holds at most max size - 1 pairs
+  context.leaf_fill_ = std::clamp(static_cast<int>(std::lround(fill_factor * (leaf_max_size_ - 1))),
+                                  std::max(1, leaf_max_size_ / 2), leaf_max_size_ - 1);
+  context.internal_fill_ = std::clamp(static_cast<int>(std::lround(fill_factor * internal_max_size_)),
+                                      (internal_max_size_ + 1) / 2, internal_max_size_);
+  KeyType key;
+  KeyType last_key;
+  ValueType value;
+  bool empty = true;
+  bool in_order = true;
+  while (next_entry(&key, &value)) {
+    if (!empty) {
+      int cmp = comparator_(last_key, key);
+      if (cmp == 0) {
+        continue;
+      }
+      if (cmp > 0) {
+        in_order = false;
+        break;
+      }
+    }
+    BulkLoadLeaf(&context, key, value);
+    last_key = key;
+    empty = false;
+  }
+  BulkLoadFinish(&context);
+  if (!in_order) {
+    // the tree was never published, so nobody else can have reached its pages
+    if (root_page_id_ != INVALID_PAGE_ID) {
+      DeleteSubtree(root_page_id_);
+      root_page_id_ = INVALID_PAGE_ID;
+    }
+    root_latch_.WUnlock();
+    throw Exception(ExceptionType::INVALID, "bulk load input is not in ascending key order");
+  }
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    UpdateRootPageId(1);
+  }
+  root_latch_.WUnlock();
+  return true;
+}
+
+/*
+ * Insert key & value pairs produced in any order. If the tree is empty they
+ * are sorted with an external sort and bulk loaded, otherwise they are
+ * inserted in key order one by one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkInsert(const std::function<bool(KeyType *, ValueType *)> &next_entry, double fill_factor,
+                                Transaction *transaction) {
+  ExternalSort<KeyType, ValueType, KeyComparator> sorter(buffer_pool_manager_, comparator_);
+  KeyType key;
+  ValueType value;
+  while (next_entry(&key, &value)) {
+    sorter.Add(key, value);
+  }
+  sorter.Sort();
+  auto next_sorted = [&sorter](KeyType *sorted_key, ValueType *sorted_value) {
+    return sorter.Next(sorted_key, sorted_value);
+  };
+  if (!BulkLoad(next_sorted, fill_factor)) {
+    while (sorter.Next(&key, &value)) {
+      Insert(key, value, transaction);
+    }
+  }
+}
+
+/*
+ * Append a pair to the rightmost leaf, starting a new leaf once it is filled.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadLeaf(BulkLoadContext *context, const KeyType &key, const ValueType &value) {
+  if (context->levels_.empty()) {
+    context->levels_.emplace_back();
+  }
+  Page *current_page = context->levels_[0].current_;
+  auto current = current_page == nullptr ? nullptr : reinterpret_cast<LeafPage *>(current_page->GetData());
+  if (current == nullptr || current->GetSize() >= context->leaf_fill_ || !current->HasRoomFor(key)) {
+    page_id_t page_id;
+    Page *page = NewTreePage(&page_id);
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+    if (current == nullptr) {
+      context->levels_[0].current_ = page;
+    } else {
+      current->SetNextPageId(page_id);
+      leaf->SetPrevPageId(current->GetPageId());
+      BulkLoadShift(context, 0, page);
+    }
+    current = leaf;
+  }
+  current->Insert(key, value, comparator_);
+}
+
+/*
+ * Append a child to the rightmost internal page of a level, starting a new
+ * page once it is filled. The key is the smallest key under the child.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadInternal(BulkLoadContext *context, size_t level, const KeyType &key,
+                                      page_id_t child_page_id) {
+  if (context->levels_.size() == level) {
+    context->levels_.emplace_back();
+  }
+  Page *current_page = context->levels_[level].current_;
+  auto current = current_page == nullptr ? nullptr : reinterpret_cast<InternalPage *>(current_page->GetData());
+  if (current == nullptr || current->GetSize() >= context->internal_fill_ || !current->HasRoomFor(key)) {
+    page_id_t page_id;
+    Page *page = NewTreePage(&page_id);
+    auto internal = reinterpret_cast<InternalPage *>(page->GetData());
+    internal->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+    if (current == nullptr) {
+      context->levels_[level].current_ = page;
+    } else {
+      BulkLoadShift(context, level, page);
+    }
+    current = internal;
+  }
+  current->AppendChild(key, child_page_id, buffer_pool_manager_);
+}
+
+/*
+ * Make a freshly started page the rightmost one of its level. The previous
+ * pending page can no longer be rebalanced and is linked into the parent.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadShift(BulkLoadContext *context, size_t level, Page *page) {
+  Page *pending = context->levels_[level].pending_;
+  if (pending != nullptr) {
+    // may grow levels_, so no reference into it is held across the call
+    BulkLoadPushUp(context, level, pending, context->levels_[level].current_);
+  }
+  context->levels_[level].pending_ = context->levels_[level].current_;
+  context->levels_[level].current_ = page;
+}
+
+/*
+ * Link a finished page into the level above and unpin it. Pages are linked
+ * left to right, so a leaf is separated from the one linked before it. Its
+ * boundary to the page right of it, if any, is final by now, so in B-link mode
+ * this is also where the page gets its right link and high key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadPushUp(BulkLoadContext *context, size_t level, Page *page, Page *right_page) {
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  KeyType separator;
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<LeafPage *>(node);
+    separator = context->linked_leaf_ ? Separator(context->last_leaf_key_, leaf->KeyAt(0)) : leaf->KeyAt(0);
+    context->last_leaf_key_ = leaf->KeyAt(leaf->GetSize() - 1);
+    context->linked_leaf_ = true;
+    if (b_link_ && right_page != nullptr) {
+      // leaves are already linked
+      auto right_leaf = reinterpret_cast<LeafPage *>(right_page->GetData());
+      leaf->SetHighKey(Separator(context->last_leaf_key_, right_leaf->KeyAt(0)));
+    }
+  } else {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    separator = internal->KeyAt(0);
+    if (b_link_ && right_page != nullptr) {
+      internal->SetNextPageId(right_page->GetPageId());
+      internal->SetHighKey(reinterpret_cast<InternalPage *>(right_page->GetData())->KeyAt(0));
+    }
+  }
+  BulkLoadInternal(context, level + 1, separator, page->GetPageId());
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+}
+
+/*
+ * Bring the last page of a level up to min size, either by merging it into
+ * its left neighbour or by shifting entries over from it.
+ * @return: true if current was merged away and should be deleted
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoadRebalance(Page *pending_page, Page *current_page) -> bool {
+  auto current_node = reinterpret_cast<BPlusTreePage *>(current_page->GetData());
+  if (current_node->GetSize() >= current_node->GetMinSize()) {
+    return false;
+  }
+  if (current_node->IsLeafPage()) {
+    auto pending = reinterpret_cast<LeafPage *>(pending_page->GetData());
+    auto current = reinterpret_cast<LeafPage *>(current_node);
+    if (pending->GetSize() + current->GetSize() < current->GetMaxSize() && pending->HasRoomForAll(current)) {
+      current->MoveAllTo(pending);
+      return true;
+    }
+    while (current->GetSize() < current->GetMinSize()) {
+      pending->MoveLastToFrontOf(current);
+    }
+    return false;
+  }
+  auto pending = reinterpret_cast<InternalPage *>(pending_page->GetData());
+  auto current = reinterpret_cast<InternalPage *>(current_node);
+  if (pending->GetSize() + current->GetSize() <= current->GetMaxSize() &&
+      pending->HasRoomForAll(current, current->KeyAt(0))) {
+    current->MoveAllTo(pending, current->KeyAt(0), buffer_pool_manager_);
+    return true;
+  }
+  while (current->GetSize() < current->GetMinSize()) {
+    pending->MoveLastToFrontOf(current, current->KeyAt(0), buffer_pool_manager_);
+  }
+  return false;
+}
+
+/*
+ * Close the levels bottom-up once the input is exhausted: rebalance the two
+ * rightmost pages and link them into the level above, until a level is left
+ * with a single page, which becomes the root.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadFinish(BulkLoadContext *context) {
+  for (size_t level = 0; level < context->levels_.size(); level++) {
+    Page *pending = context->levels_[level].pending_;
+    Page *current = context->levels_[level].current_;
+    if (pending == nullptr) {
+      BUSTUB_ASSERT(level + 1 == context->levels_.size(), "only the top level has a single page");
+      auto root = reinterpret_cast<BPlusTreePage *>(current->GetData());
+      // a merge right below the top can leave the root with a single child, which then takes its place
+      while (!root->IsLeafPage() && root->GetSize() == 1) {
+        page_id_t child_page_id = reinterpret_cast<InternalPage *>(root)->ValueAt(0);
+        buffer_pool_manager_->UnpinPage(current->GetPageId(), false);
+        buffer_pool_manager_->DeletePage(current->GetPageId());
+        current = FetchTreePage(child_page_id);
+        root = reinterpret_cast<BPlusTreePage *>(current->GetData());
+        root->SetParentPageId(INVALID_PAGE_ID);
+      }
+      root_page_id_ = current->GetPageId();
+      buffer_pool_manager_->UnpinPage(root_page_id_, true);
+      return;
+    }
+    bool merged = BulkLoadRebalance(pending, current);
+    BulkLoadPushUp(context, level, pending, merged ? nullptr : current);
+    if (merged) {
+      buffer_pool_manager_->UnpinPage(current->GetPageId(), false);
+      buffer_pool_manager_->DeletePage(current->GetPageId());
+    } else {
+      BulkLoadPushUp(context, level, current, nullptr);
+    }
+  }
+}
+
+/*
+ * Delete a page and every page below it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeleteSubtree(page_id_t page_id) {
+  Page *page = FetchTreePage(page_id);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (!node->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      DeleteSubtree(internal->ValueAt(i));
+    }
+  }
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  buffer_pool_manager_->DeletePage(page_id);
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -188,7 +947,13 @@ auto BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) -> bool { return f
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  Page *page = FindLeafPage(KeyType(), true);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  return MakeIterator(page, 0, nullptr, false);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -196,7 +961,14 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  return MakeIterator(page, leaf->KeyIndex(key, comparator_), nullptr, false);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -206,16 +978,514 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return IN
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
 
+/*
+ * Input parameters are the low and the high key of a range, either of which
+ * may be missing, construct an index iterator over the keys from the low key
+ * up to but excluding the high key
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Begin(const KeyType *low, const KeyType *high) -> INDEXITERATOR_TYPE {
+  Page *page = low == nullptr ? FindLeafPage(KeyType(), true) : FindLeafPage(*low);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  int index = low == nullptr ? 0 : reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(*low, comparator_);
+  return MakeIterator(page, index, high, false);
+}
+
+/*
+ * The subtrees on one level of the tree hold about the same number of keys,
+ * so the keys between them split a range evenly. Starting at the root, the
+ * levels are read one after the other until one has enough keys inside the
+ * range, or the leaves are reached; every count-th of its keys is taken.
+ * The tree may change meanwhile, the keys then only split the range less
+ * evenly.
+ * @return : the keys between the sub-ranges in ascending order, at most
+ * count - 1 of them; sub-range i is [key i - 1, key i), from low to high
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::PartitionRange(const KeyType *low, const KeyType *high, int count) -> std::vector<KeyType> {
+  std::vector<KeyType> separators;
+  for (int depth = 0; static_cast<int>(separators.size()) < count - 1; depth++) {
+    root_latch_.RLock();
+    if (root_page_id_ == INVALID_PAGE_ID) {
+      root_latch_.RUnlock();
+      break;
+    }
+    Page *page = FetchTreePage(root_page_id_);
+    page->RLatch();
+    root_latch_.RUnlock();
+    std::vector<KeyType> level;
+    bool internal = CollectSeparators(page, depth, low, high, &level);
+    if (level.size() > separators.size()) {
+      separators = std::move(level);
+    }
+    if (!internal) {
+      break;
+    }
+  }
+
+  auto size = static_cast<int>(separators.size());
+  if (size < count) {
+    return separators;
+  }
+  std::vector<KeyType> keys;
+  for (int i = 1; i < count; i++) {
+    keys.push_back(separators[i * (size + 1) / count - 1]);
+  }
+  return keys;
+}
+
+/*
+ * Append the keys that the internal pages depth levels below page have
+ * inside (low, high) to separators, descending only into children whose keys
+ * overlap the range. The path down from page stays read latched, like a
+ * lookup holds it for a moment, and page is released here.
+ * @return : whether there are internal pages depth levels below page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CollectSeparators(Page *page, int depth, const KeyType *low, const KeyType *high,
+                                       std::vector<KeyType> *separators) -> bool {
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  bool internal = false;
+  if (!node->IsLeafPage()) {
+    auto internal_node = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < internal_node->GetSize(); i++) {
+      // child i holds the keys from key i up to key i + 1
+      if (i + 1 < internal_node->GetSize() && low != nullptr &&
+          comparator_(internal_node->KeyAt(i + 1), *low) <= 0) {
+        continue;
+      }
+      if (i > 0 && high != nullptr && comparator_(internal_node->KeyAt(i), *high) >= 0) {
+        break;
+      }
+      if (depth == 0) {
+        internal = true;
+        if (i > 0 && (low == nullptr || comparator_(internal_node->KeyAt(i), *low) > 0)) {
+          separators->push_back(internal_node->KeyAt(i));
+        }
+        continue;
+      }
+      Page *child = FetchTreePage(internal_node->ValueAt(i));
+      child->RLatch();
+      internal = CollectSeparators(child, depth - 1, low, high, separators) || internal;
+    }
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return internal;
+}
+
+/*
+ * Each worker thread finds the start of its sub-range itself, so that no
+ * thread holds the latch of one sub-range while descending to another
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ParallelScan(const KeyType *low, const KeyType *high, int count,
+                                  const std::function<void(int, INDEXITERATOR_TYPE *)> &worker) {
+  std::vector<KeyType> keys = PartitionRange(low, high, count);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i <= keys.size(); i++) {
+    threads.emplace_back([this, &keys, &worker, low, high, i] {
+      INDEXITERATOR_TYPE iterator = Begin(i == 0 ? low : &keys[i - 1], i == keys.size() ? high : &keys[i]);
+      worker(static_cast<int>(i), &iterator);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * a reverse index iterator at its last pair
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin() -> INDEXITERATOR_TYPE {
+  Page *page = FindRightmostLeafPage();
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  return MakeIterator(page, leaf->GetSize() - 1, nullptr, true);
+}
+
+/*
+ * Input parameter is high key, find the leaf page that contains the input key
+ * first, then construct a reverse index iterator at the key, or at the
+ * greatest key below it if there is no such key
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int index = leaf->KeyIndex(key, comparator_);
+  if (index == leaf->GetSize() || comparator_(leaf->KeyAt(index), key) != 0) {
+    index--;
+  }
+  return MakeIterator(page, index, &key, true);
+}
+
+/*
+ * Input parameter is void, construct an index iterator representing the end
+ * of a reverse scan, which is the same as the end of a forward one
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::REnd() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+
+/*
+ * The iterator descends again through the tree after each batch, and a
+ * reverse one also whenever the leaves it moves left along changed under it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::MakeIterator(Page *page, int index, const KeyType *bound, bool reverse) -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(
+      buffer_pool_manager_, page, index, bound, comparator_,
+      [this](const KeyType *key) { return key == nullptr ? FindRightmostLeafPage() : FindLeafPage(*key); }, reverse);
+}
+
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * Descends with read latch crabbing and returns the leaf pinned and read
+ * latched, or nullptr if the tree is empty.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  if (b_link_) {
+    return FindLeafPageBLink(key, leftMost, false, nullptr);
+  }
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchTreePage(root_page_id_);
+  page->RLatch();
+  root_latch_.RUnlock();
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    Page *child = FetchTreePage(leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_));
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
+
+/*
+ * Find the rightmost leaf page, descending like FindLeafPage() but through the
+ * last child of every internal page. In B-link mode the descent holds one
+ * latch at a time and follows the right links of every page it reaches, as
+ * pages may have been split off to its right in the meantime.
+ * @return : the leaf pinned and read latched, or nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindRightmostLeafPage() -> Page * {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchTreePage(root_page_id_);
+  if (!b_link_) {
+    page->RLatch();
+  }
+  root_latch_.RUnlock();
+  if (b_link_) {
+    page->RLatch();
+  }
+  while (true) {
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    page_id_t next_page_id = node->IsLeafPage() ? reinterpret_cast<LeafPage *>(node)->GetNextPageId()
+                                                : reinterpret_cast<InternalPage *>(node)->GetNextPageId();
+    if (b_link_ && next_page_id != INVALID_PAGE_ID) {
+      Page *next_page = FetchTreePage(next_page_id);
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      next_page->RLatch();
+      page = next_page;
+      continue;
+    }
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    Page *child = FetchTreePage(internal->ValueAt(internal->GetSize() - 1));
+    if (!b_link_) {
+      child->RLatch();
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (b_link_) {
+      child->RLatch();
+    }
+    page = child;
+  }
+}
+
+/*
+ * Optimistic descent for a write: read latch crabbing through the internal
+ * pages and a write latch on the leaf only. Nothing above the leaf can change
+ * under the caller, which must check IsSafe() on the leaf before modifying it
+ * and otherwise retry with FindLeafPagePessimistic().
+ * @return : the leaf pinned and write latched, or nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, BPlusTreeOperation op) -> Page * {
+  BUSTUB_ASSERT(op != BPlusTreeOperation::FIND, "lookups descend through FindLeafPage");
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = FetchTreePage(root_page_id_);
+  // a page's type never changes while its parent (or the root latch) is held, so it can be read before latching
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  node->IsLeafPage() ? page->WLatch() : page->RLatch();
+  root_latch_.RUnlock();
+  while (!node->IsLeafPage()) {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    Page *child = FetchTreePage(internal->Lookup(key, comparator_));
+    auto child_node = reinterpret_cast<BPlusTreePage *>(child->GetData());
+    child_node->IsLeafPage() ? child->WLatch() : child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = child_node;
+  }
+  return page;
+}
+
+/*
+ * Pessimistic descent for a write: write latch crabbing from the root. The
+ * root latch and every latched page are recorded in the transaction's page set
+ * and all ancestors are released as soon as a node is safe for the operation.
+ * The caller finishes with ReleaseLatchedPages().
+ * @return : the leaf (also the back of the page set), or nullptr if the tree
+ * is empty, in which case the root latch is still held
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPagePessimistic(const KeyType &key, BPlusTreeOperation op, Transaction *transaction)
+    -> Page * {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = FetchTreePage(page_id);
+    page->WLatch();
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op, key)) {
+      ReleaseLatchedPages(transaction, false);
+    }
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, comparator_);
+  }
+}
+
+/*
+ * Descent in B-link mode, holding one latch at a time: a child is pinned
+ * before its parent is released but only latched afterwards, and every page
+ * that split after the pointer to it was read is left to the right. Internal
+ * pages are read latched, the leaf is write latched if exclusive. The
+ * internal pages the descent settles on are pushed onto path, if given.
+ * @return : the leaf pinned and latched, or nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageBLink(const KeyType &key, bool leftMost, bool exclusive,
+                                       std::vector<page_id_t> *path) -> Page * {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  // the root may be raised before it is latched, which is fine: every key is reachable from the old one
+  Page *page = FetchTreePage(root_page_id_);
+  root_latch_.RUnlock();
+  while (true) {
+    // pages never change their type in B-link mode, so it can be read before latching
+    bool write = exclusive && reinterpret_cast<BPlusTreePage *>(page->GetData())->IsLeafPage();
+    write ? page->WLatch() : page->RLatch();
+    if (!leftMost) {
+      // the leftmost page of a level never has anything split off to its left
+      page = MoveRight(page, key, write);
+    }
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    if (path != nullptr) {
+      path->push_back(page->GetPageId());
+    }
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    Page *child = FetchTreePage(leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_));
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+  }
+}
+
+/*
+ * Follow right links from the latched page until the key belongs to it, in
+ * B-link mode. Like the descent, this pins the next page before releasing the
+ * current one and latches it afterwards.
+ * @return : the page the key belongs to, latched in the same mode
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::MoveRight(Page *page, const KeyType &key, bool exclusive) -> Page * {
+  page_id_t next_page_id;
+  while ((next_page_id = RightSiblingFor(reinterpret_cast<BPlusTreePage *>(page->GetData()), key)) !=
+         INVALID_PAGE_ID) {
+    Page *next_page = FetchTreePage(next_page_id);
+    exclusive ? page->WUnlatch() : page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    exclusive ? next_page->WLatch() : next_page->RLatch();
+    page = next_page;
+  }
+  return page;
+}
+
+/*
+ * In B-link mode, the right sibling to move on to if key is not below the high
+ * key of node, or INVALID_PAGE_ID if key belongs to node.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RightSiblingFor(BPlusTreePage *node, const KeyType &key) const -> page_id_t {
+  page_id_t next_page_id;
+  bool beyond;
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<LeafPage *>(node);
+    next_page_id = leaf->GetNextPageId();
+    beyond = next_page_id != INVALID_PAGE_ID && comparator_(key, leaf->GetHighKey()) >= 0;
+  } else {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    next_page_id = internal->GetNextPageId();
+    beyond = next_page_id != INVALID_PAGE_ID && comparator_(key, internal->GetHighKey()) >= 0;
+  }
+  return beyond ? next_page_id : INVALID_PAGE_ID;
+}
+
+/*
+ * A node is safe if the operation cannot propagate past it: an insert will not
+ * split it and a delete will not make it underflow (or collapse the root).
+ * Pages also split when a key does not fit. The leaf knows the key it gets,
+ * but an internal page may get any separator from a split child, and during a
+ * delete a redistribution below may replace one of its separators.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, BPlusTreeOperation op, const KeyType &key) const -> bool {
+  if (op == BPlusTreeOperation::FIND) {
+    return true;
+  }
+  if (node->IsLeafPage()) {
+    if (op == BPlusTreeOperation::INSERT) {
+      // leaves split once they reach max size
+      return node->GetSize() + 1 < node->GetMaxSize() && reinterpret_cast<LeafPage *>(node)->HasRoomFor(key);
+    }
+  } else if (node->GetSize() >= node->GetMaxSize() || !reinterpret_cast<InternalPage *>(node)->HasRoomForAnyKey()) {
+    // internal pages split once they exceed max size
+    return false;
+  } else if (op == BPlusTreeOperation::INSERT) {
+    return true;
+  }
+  if (node->IsRootPage()) {
+    return node->IsLeafPage() ? node->GetSize() > 1 : node->GetSize() > 2;
+  }
+  return node->GetSize() > node->GetMinSize();
+}
+
+/*
+ * Shortest separator between two neighbouring leaves: the first key of the
+ * right leaf with as many trailing bytes zeroed as keeps it above the last key
+ * of the left one. The zeroed bytes are shared with other short separators,
+ * so internal pages compress better and get a higher fanout.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Separator(const KeyType &left, const KeyType &right) const -> KeyType {
+  auto right_data = reinterpret_cast<const char *>(&right);
+  for (size_t length = 1; length < sizeof(KeyType); length++) {
+    // a zero byte gives the same candidate as one byte less
+    if (right_data[length - 1] == 0) {
+      continue;
+    }
+    KeyType separator;
+    memset(reinterpret_cast<char *>(&separator), 0, sizeof(KeyType));
+    memcpy(reinterpret_cast<char *>(&separator), right_data, length);
+    if (comparator_(left, separator) < 0 && comparator_(separator, right) <= 0) {
+      return separator;
+    }
+  }
+  return right;
+}
+
+/*
+ * Unlatch and unpin everything the pessimistic descent recorded in the
+ * transaction's page set, oldest first, then delete the pages that were merged
+ * away. A nullptr entry stands for the root latch.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseLatchedPages(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  while (!page_set->empty()) {
+    Page *page = page_set->front();
+    page_set->pop_front();
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  for (page_id_t page_id : *deleted_page_set) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  deleted_page_set->clear();
+}
+
+/*
+ * Fetch a page of this tree, throwing an "out of memory" exception if the
+ * buffer pool has no frame left for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchTreePage(page_id_t page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a b+ tree page");
+  }
+  return page;
+}
+
+/*
+ * Allocate a page for this tree, throwing an "out of memory" exception if the
+ * buffer pool has no frame left for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewTreePage(page_id_t *page_id) -> Page * {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a b+ tree page");
+  }
+  return page;
 }
 
 /*
@@ -229,32 +1499,35 @@ auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) -> Page * {
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
-    // update root_page_id in header_page
+  header_page->WLatch();
+  // create a new record<index_name + root_page_id> in header_page
+  bool inserted = insert_record != 0 && header_page->InsertRecord(index_name_, root_page_id_);
+  if (!inserted) {
+    // update root_page_id in header_page, also when a tree that emptied out starts over
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
+  header_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
  * This method is used for test only
- * Read data from file and insert one by one
+ * Read data from file and insert them, bulk loading if the tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertFromFile(const std::string &file_name, Transaction *transaction) {
-  int64_t key;
   std::ifstream input(file_name);
-  while (input) {
-    input >> key;
-
-    KeyType index_key;
-    index_key.SetFromInteger(key);
-    RID rid(key);
-    Insert(index_key, rid, transaction);
-  }
+  BulkInsert(
+      [&input](KeyType *index_key, ValueType *value) {
+        int64_t key;
+        if (!(input >> key)) {
+          return false;
+        }
+        index_key->SetFromInteger(key);
+        *value = RID(key);
+        return true;
+      },
+      1.0, transaction);
 }
 /*
  * This method is used for test only
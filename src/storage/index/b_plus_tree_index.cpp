@@ -11,6 +11,11 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+
 namespace bustub {
 /*
  * Constructor
@@ -19,35 +24,167 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_),
+      posting_list_(buffer_pool_manager) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  if (GetMetadata()->IsCovering()) {
+    InsertCovered(key, rid, transaction);
+    return;
+  }
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
 
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Insert(PostingEntry(index_key, transaction), rid);
+    return;
+  }
   container_.Insert(index_key, rid, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::InsertEntries(const std::function<bool(Tuple *, RID *)> &next_entry,
+                                         Transaction *transaction) {
+  // bulk loading takes one value per key, so the posting lists of a non-unique index are built entry by entry, and it
+  // only skips whole duplicate keys, so a unique covering index, whose keys include more columns, is built that way too
+  if (!GetMetadata()->IsUnique() || GetMetadata()->IsCovering()) {
+    Index::InsertEntries(next_entry, transaction);
+    return;
+  }
+  // sort the keys externally and bulk load them into an empty tree
+  Schema *key_schema = GetMetadata()->GetKeySchema();
+  container_.BulkInsert(
+      [&next_entry, key_schema](KeyType *index_key, ValueType *rid) {
+        Tuple key;
+        if (!next_entry(&key, rid)) {
+          return false;
+        }
+        index_key->SetFromKey(key, key_schema);
+        return true;
+      },
+      1.0, transaction);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  if (GetMetadata()->IsCovering()) {
+    DeleteCovered(key, rid, transaction);
+    return;
+  }
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
 
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Remove(PostingEntry(index_key, transaction), rid);
+    return;
+  }
   container_.Remove(index_key, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  if (GetMetadata()->IsCovering()) {
+    std::vector<MappingType> entries;
+    CoveredEntries(key, &entries);
+    for (const auto &entry : entries) {
+      ExpandValue(entry.second, result);
+    }
+    return;
+  }
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
 
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Scan(PostingEntry(index_key, transaction), result);
+    return;
+  }
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ExpandValue(const ValueType &value, std::vector<RID> *result) {
+  if (GetMetadata()->IsUnique()) {
+    result->push_back(value);
+  } else {
+    posting_list_.Expand(value, result);
+  }
+}
+
+/*
+ * A covering index keys its entries by the key columns followed by the
+ * included ones, which puts the included columns into the leaves. Entries are
+ * looked up by their key alone: the encoded key columns are a prefix of the
+ * entry key, and the key zero padded sorts before every entry starting with it.
+ * A key already in a unique index is not inserted again, like for any other
+ * unique index; the check and the insert run under covering_latch_.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::InsertCovered(const Tuple &key, RID rid, Transaction *transaction) {
+  KeyType entry_key;
+  if (entry_key.SetFromKey(key, GetMetadata()->GetEntrySchema()) > sizeof(KeyType)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "index key and included columns do not fit the key size");
+  }
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Insert(PostingEntry(entry_key, transaction), rid);
+    return;
+  }
+  std::vector<MappingType> entries;
+  covering_latch_.WLock();
+  CoveredEntries(key, &entries);
+  if (entries.empty()) {
+    container_.Insert(entry_key, rid, transaction);
+  }
+  covering_latch_.WUnlock();
+}
+
+/*
+ * The entries of the key are found by the key alone, so the included columns
+ * of the caller's tuple need not match the stored ones
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::DeleteCovered(const Tuple &key, RID rid, Transaction *transaction) {
+  std::vector<MappingType> entries;
+  CoveredEntries(key, &entries);
+  for (const auto &entry : entries) {
+    if (!GetMetadata()->IsUnique()) {
+      posting_list_.Remove(PostingEntry(entry.first, transaction), rid);
+    } else if (entry.second == rid) {
+      container_.Remove(entry.first, transaction);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::CoveredEntries(const Tuple &key, std::vector<MappingType> *entries) {
+  KeyType prefix;
+  size_t length = std::min(prefix.SetFromKey(key, GetMetadata()->GetKeySchema()), sizeof(KeyType));
+  for (auto iterator = container_.Begin(prefix); !iterator.IsEnd(); ++iterator) {
+    if (memcmp((*iterator).first.data_, prefix.data_, length) != 0) {
+      break;
+    }
+    entries->push_back(*iterator);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::PostingEntry(const KeyType &index_key, Transaction *transaction) -> PostingList::Entry {
+  return {[this, &index_key, transaction](RID *value) {
+            std::vector<RID> values;
+            container_.GetValue(index_key, &values, transaction);
+            if (values.empty()) {
+              return false;
+            }
+            *value = values[0];
+            return true;
+          },
+          [this, &index_key, transaction](const RID &value) { container_.Insert(index_key, value, transaction); },
+          [this, &index_key, transaction](const RID &) { container_.Remove(index_key, transaction); }};
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
@@ -57,6 +194,17 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_.End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator() -> INDEXITERATOR_TYPE { return container_.RBegin(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return container_.RBegin(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseEndIterator() -> INDEXITERATOR_TYPE { return container_.REnd(); }
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
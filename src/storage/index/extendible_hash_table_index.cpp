@@ -9,17 +9,22 @@ namespace bustub {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_INDEX_TYPE::ExtendibleHashTableIndex(std::unique_ptr<IndexMetadata> &&metadata,
                                                 BufferPoolManager *buffer_pool_manager,
-                                                const HashFunction<KeyType> &hash_fn)
+                                                const HashFunction<KeyType> &hash_fn, bool open_existing)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, hash_fn) {}
+      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_, hash_fn, true, open_existing),
+      posting_list_(buffer_pool_manager) {}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
 
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Insert(PostingEntry(index_key, transaction), rid);
+    return;
+  }
   container_.Insert(transaction, index_key, rid);
 }
 
@@ -28,8 +33,12 @@ void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *
   // construct delete index key
   // std::cout << "deleting\n" << std::endl;
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
 
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Remove(PostingEntry(index_key, transaction), rid);
+    return;
+  }
   container_.Remove(transaction, index_key, rid);
 }
 
@@ -37,10 +46,33 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetMetadata()->GetKeySchema());
 
+  if (!GetMetadata()->IsUnique()) {
+    posting_list_.Scan(PostingEntry(index_key, transaction), result);
+    return;
+  }
   container_.GetValue(transaction, index_key, result);
 }
+
+/*
+ * A non-unique index keeps one value per key, so the bucket never holds more
+ * than one pair of a key
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_INDEX_TYPE::PostingEntry(const KeyType &index_key, Transaction *transaction) -> PostingList::Entry {
+  return {[this, &index_key, transaction](RID *value) {
+            std::vector<RID> values;
+            container_.GetValue(transaction, index_key, &values);
+            if (values.empty()) {
+              return false;
+            }
+            *value = values[0];
+            return true;
+          },
+          [this, &index_key, transaction](const RID &value) { container_.Insert(transaction, index_key, value); },
+          [this, &index_key, transaction](const RID &value) { container_.Remove(transaction, index_key, value); }};
+}
 template class ExtendibleHashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class ExtendibleHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
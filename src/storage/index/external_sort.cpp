@@ -0,0 +1,281 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.cpp
+//
+// Identification: src/storage/index/external_sort.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "storage/index/external_sort.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_SORT_TYPE::ExternalSort(BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
+                                 size_t run_size, size_t fan_in)
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), run_size_(run_size), fan_in_(fan_in) {
+  BUSTUB_ASSERT(run_size_ > 0, "a run holds at least one pair");
+  BUSTUB_ASSERT(fan_in_ >= 2, "a merge needs at least two runs");
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_SORT_TYPE::~ExternalSort() {
+  CloseReaders();
+  for (page_id_t run : runs_) {
+    DeleteRun(run);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::Add(const KeyType &key, const ValueType &value) {
+  BUSTUB_ASSERT(!sorted_, "cannot add pairs after sorting");
+  buffer_.emplace_back(key, value);
+  if (buffer_.size() >= run_size_) {
+    SpillRun();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::Sort() {
+  BUSTUB_ASSERT(!sorted_, "pairs are already sorted");
+  sorted_ = true;
+  if (runs_.empty()) {
+    std::sort(buffer_.begin(), buffer_.end(), [this](const auto &a, const auto &b) { return Less(a, b); });
+    return;
+  }
+  if (!buffer_.empty()) {
+    SpillRun();
+  }
+  std::vector<MappingType>().swap(buffer_);
+
+  // intermediate passes until the final merge fits into the fan-in
+  while (runs_.size() > fan_in_) {
+    std::vector<page_id_t> merged;
+    for (size_t i = 0; i < runs_.size(); i += fan_in_) {
+      std::vector<page_id_t> group(runs_.begin() + i, runs_.begin() + std::min(i + fan_in_, runs_.size()));
+      merged.push_back(group.size() == 1 ? group[0] : MergeRuns(group));
+    }
+    runs_ = std::move(merged);
+  }
+  OpenReaders(runs_);
+  runs_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::Next(KeyType *key, ValueType *value) -> bool {
+  BUSTUB_ASSERT(sorted_, "Sort() must be called before reading the output");
+  if (spilled_runs_ == 0) {
+    if (buffer_pos_ == buffer_.size()) {
+      return false;
+    }
+    *key = buffer_[buffer_pos_].first;
+    *value = buffer_[buffer_pos_].second;
+    buffer_pos_++;
+    return true;
+  }
+  MappingType item;
+  if (!PopMin(&item)) {
+    return false;
+  }
+  *key = item.first;
+  *value = item.second;
+  return true;
+}
+
+/*
+ * Sort the buffered pairs and write them out as a new run.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::SpillRun() {
+  std::sort(buffer_.begin(), buffer_.end(), [this](const auto &a, const auto &b) { return Less(a, b); });
+  RunWriter writer(this);
+  for (const auto &item : buffer_) {
+    writer.Append(item);
+  }
+  runs_.push_back(writer.Finish());
+  buffer_.clear();
+  spilled_runs_++;
+}
+
+/*
+ * Merge the given runs into a single new run. The input runs are freed while they are read.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::MergeRuns(const std::vector<page_id_t> &runs) -> page_id_t {
+  OpenReaders(runs);
+  RunWriter writer(this);
+  MappingType item;
+  while (PopMin(&item)) {
+    writer.Append(item);
+  }
+  CloseReaders();
+  return writer.Finish();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::OpenReaders(const std::vector<page_id_t> &runs) {
+  for (page_id_t run : runs) {
+    Page *page = buffer_pool_manager_->FetchPage(run);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a page of a sorted run");
+    }
+    heap_.push_back(readers_.size());
+    readers_.push_back(RunReader{run, page, 0});
+  }
+  std::make_heap(heap_.begin(), heap_.end(), [this](size_t a, size_t b) { return ReaderGreater(a, b); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::PopMin(MappingType *item) -> bool {
+  if (heap_.empty()) {
+    return false;
+  }
+  auto greater = [this](size_t a, size_t b) { return ReaderGreater(a, b); };
+  std::pop_heap(heap_.begin(), heap_.end(), greater);
+  RunReader *reader = &readers_[heap_.back()];
+  *item = GetItems(reader->page_)[reader->index_];
+  AdvanceReader(reader);
+  if (reader->page_ == nullptr) {
+    heap_.pop_back();
+  } else {
+    std::push_heap(heap_.begin(), heap_.end(), greater);
+  }
+  return true;
+}
+
+/*
+ * Heap order of a merge: a reader ranks lower if its current pair is greater, ties are broken by run order.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::ReaderGreater(size_t a, size_t b) const -> bool {
+  const auto &item_a = GetItems(readers_[a].page_)[readers_[a].index_];
+  const auto &item_b = GetItems(readers_[b].page_)[readers_[b].index_];
+  return Less(item_b, item_a) || (!Less(item_a, item_b) && a > b);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::AdvanceReader(RunReader *reader) {
+  if (++reader->index_ < GetCount(reader->page_)) {
+    return;
+  }
+  page_id_t next_page_id = GetNextPageId(reader->page_);
+  buffer_pool_manager_->UnpinPage(reader->page_id_, false);
+  buffer_pool_manager_->DeletePage(reader->page_id_);
+  reader->page_id_ = next_page_id;
+  reader->page_ = nullptr;
+  reader->index_ = 0;
+  if (next_page_id != INVALID_PAGE_ID) {
+    reader->page_ = buffer_pool_manager_->FetchPage(next_page_id);
+    if (reader->page_ == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a page of a sorted run");
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::CloseReaders() {
+  for (auto &reader : readers_) {
+    if (reader.page_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(reader.page_id_, false);
+      DeleteRun(reader.page_id_);
+    }
+  }
+  readers_.clear();
+  heap_.clear();
+}
+
+/*
+ * Free every page of a run starting at page_id.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::DeleteRun(page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      return;
+    }
+    page_id_t next_page_id = GetNextPageId(page);
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::RunWriter::Append(const MappingType &item) {
+  if (page_ == nullptr || GetCount(page_) == RUN_PAGE_CAPACITY) {
+    page_id_t page_id;
+    Page *page = sorter_->buffer_pool_manager_->NewPage(&page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a page for a sorted run");
+    }
+    SetNextPageId(page, INVALID_PAGE_ID);
+    SetCount(page, 0);
+    if (page_ == nullptr) {
+      first_page_id_ = page_id;
+    } else {
+      SetNextPageId(page_, page_id);
+      sorter_->buffer_pool_manager_->UnpinPage(page_->GetPageId(), true);
+    }
+    page_ = page;
+  }
+  int count = GetCount(page_);
+  GetItems(page_)[count] = item;
+  SetCount(page_, count + 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::RunWriter::Finish() -> page_id_t {
+  if (page_ != nullptr) {
+    sorter_->buffer_pool_manager_->UnpinPage(page_->GetPageId(), true);
+    page_ = nullptr;
+  }
+  return first_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::GetNextPageId(Page *page) -> page_id_t {
+  page_id_t next_page_id;
+  memcpy(&next_page_id, page->GetData(), sizeof(page_id_t));
+  return next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::SetNextPageId(Page *page, page_id_t next_page_id) {
+  memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::GetCount(Page *page) -> int {
+  int32_t count;
+  memcpy(&count, page->GetData() + sizeof(page_id_t), sizeof(int32_t));
+  return count;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORT_TYPE::SetCount(Page *page, int count) {
+  auto stored = static_cast<int32_t>(count);
+  memcpy(page->GetData() + sizeof(page_id_t), &stored, sizeof(int32_t));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORT_TYPE::GetItems(Page *page) -> MappingType * {
+  return reinterpret_cast<MappingType *>(page->GetData() + RUN_PAGE_HEADER_SIZE);
+}
+
+template class ExternalSort<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExternalSort<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExternalSort<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExternalSort<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExternalSort<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -1,30 +1,333 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
+#include <chrono>  // NOLINT
 
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator() = default;
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, const KeyType *bound,
+                                  const KeyComparator &comparator, std::function<Page *(const KeyType *)> find_leaf,
+                                  bool reverse)
+    : buffer_pool_manager_(buffer_pool_manager),
+      page_(page),
+      leaf_(reinterpret_cast<LeafPage *>(page->GetData())),
+      index_(index),
+      reverse_(reverse),
+      comparator_(&comparator),
+      find_leaf_(std::move(find_leaf)) {
+  if (bound != nullptr) {
+    bound_ = *bound;
+    bounded_ = true;
+  }
+  if (reverse_) {
+    SkipExhaustedLeavesBackward();
+  } else {
+    SkipExhaustedLeaves();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&that) noexcept
+    : buffer_pool_manager_(that.buffer_pool_manager_),
+      page_(that.page_),
+      leaf_(that.leaf_),
+      index_(that.index_),
+      leaves_ahead_(that.leaves_ahead_),
+      read_ahead_(std::move(that.read_ahead_)),
+      reverse_(that.reverse_),
+      comparator_(that.comparator_),
+      find_leaf_(std::move(that.find_leaf_)),
+      bound_(that.bound_),
+      bounded_(that.bounded_),
+      parked_(that.parked_),
+      last_key_(that.last_key_) {
+  that.page_ = nullptr;
+  that.leaf_ = nullptr;
+  that.index_ = 0;
+  that.parked_ = false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator=(IndexIterator &&that) noexcept -> INDEXITERATOR_TYPE & {
+  if (this != &that) {
+    Release();
+    buffer_pool_manager_ = that.buffer_pool_manager_;
+    page_ = that.page_;
+    leaf_ = that.leaf_;
+    index_ = that.index_;
+    leaves_ahead_ = that.leaves_ahead_;
+    // waits for our own read ahead, which is safe now that our latch is gone
+    read_ahead_ = std::move(that.read_ahead_);
+    reverse_ = that.reverse_;
+    comparator_ = that.comparator_;
+    find_leaf_ = std::move(that.find_leaf_);
+    bound_ = that.bound_;
+    bounded_ = that.bounded_;
+    parked_ = that.parked_;
+    last_key_ = that.last_key_;
+    that.page_ = nullptr;
+    that.leaf_ = nullptr;
+    that.index_ = 0;
+    that.parked_ = false;
+  }
+  return *this;
+}
+
 /*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
+ * The read ahead future waits for its walk when it is destroyed, which only
+ * happens after Release()
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() = default;
+INDEXITERATOR_TYPE::~IndexIterator() { Release(); }  // NOLINT
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::IsEnd() -> bool {
+  Resume();
+  return page_ == nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  Resume();
+  assert(!IsEnd());
+  item_ = leaf_->GetItem(index_);
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  Resume();
+  assert(!IsEnd());
+  if (reverse_) {
+    bound_ = leaf_->KeyAt(index_);
+    bounded_ = true;
+    index_--;
+    SkipExhaustedLeavesBackward();
+    return *this;
+  }
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::NextBatch(MappingType *items, int max_count) -> int {
+  if (reverse_) {
+    int count = 0;
+    for (; count < max_count && !IsEnd(); count++, ++*this) {
+      items[count] = **this;
+    }
+    if (count > 0) {
+      Park();
+    }
+    return count;
+  }
+  return bounded_ ? CopyBatch(items, max_count, &bound_, comparator_) : CopyBatch(items, max_count, nullptr, nullptr);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
+auto INDEXITERATOR_TYPE::NextBatch(MappingType *items, int max_count, const KeyType &end_key,
+                                   const KeyComparator &comparator) -> int {
+  assert(!reverse_);
+  if (bounded_ && comparator(bound_, end_key) < 0) {
+    return CopyBatch(items, max_count, &bound_, comparator_);
+  }
+  return CopyBatch(items, max_count, &end_key, &comparator);
+}
 
+/*
+ * Copy the rest of the current leaf below the end key in one go, and only go
+ * on to the next leaf if the whole leaf was taken. The read ahead is started
+ * before the last leaf is released, as it walks from a pin on that leaf.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::CopyBatch(MappingType *items, int max_count, const KeyType *end_key,
+                                   const KeyComparator *comparator) -> int {
+  Resume();
+  int count = 0;
+  while (count < max_count && page_ != nullptr) {
+    int size = leaf_->GetSize();
+    int end = end_key == nullptr ? size : leaf_->KeyIndex(*end_key, *comparator);
+    int slice = std::max(0, std::min(end - index_, max_count - count));
+    leaf_->GetItems(index_, slice, items + count);
+    count += slice;
+    index_ += slice;
+    if (index_ < size) {
+      if (index_ >= end) {
+        Release();
+        index_ = 0;
+      }
+      break;
+    }
+    SkipExhaustedLeaves();
+  }
+  if (page_ != nullptr && leaf_->GetSize() - index_ <= max_count) {
+    ReadAhead();
+  }
+  if (count > 0) {
+    last_key_ = items[count - 1].first;
+    Park();
+  }
+  return count;
+}
+
+/*
+ * The walk starts from an extra pin on the current leaf, which is resident
+ * since we hold a pin on it as well, and then goes right hand-over-hand like
+ * SkipExhaustedLeaves, holding one read latch at a time. Fetching a leaf is
+ * what reads it in; the walk leaves them unpinned. We never wait for a walk
+ * while holding our latch, as a writer queued on a leaf could block it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::ReadAhead() {
+  if (leaves_ahead_ > 0 || leaf_->GetNextPageId() == INVALID_PAGE_ID) {
+    return;
+  }
+  if (read_ahead_.valid() && read_ahead_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(page_->GetPageId());
+  if (page == nullptr) {
+    return;
+  }
+  leaves_ahead_ = READ_AHEAD_LEAVES;
+  read_ahead_ = std::async(std::launch::async, [buffer_pool_manager = buffer_pool_manager_, page]() mutable {
+    for (int i = 0; i < READ_AHEAD_LEAVES && page != nullptr; i++) {
+      page->RLatch();
+      page_id_t next_page_id = reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId();
+      Page *next_page = next_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager->FetchPage(next_page_id);
+      page->RUnlatch();
+      buffer_pool_manager->UnpinPage(page->GetPageId(), false);
+      page = next_page;
+    }
+    if (page != nullptr) {
+      buffer_pool_manager->UnpinPage(page->GetPageId(), false);
+    }
+  });
+}
+
+/*
+ * Hand-over-hand to the right: the next leaf is pinned before the current one is released so that it cannot be
+ * evicted in between, but its latch is only taken after ours is dropped. Writers that merge or redistribute latch
+ * siblings right-to-left, so holding both latches here could deadlock against them. A leaf that was emptied by a
+ * merge in the meantime keeps its next pointer and is simply skipped. A bounded iterator ends once it reaches its end
+ * key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (page_ != nullptr && index_ >= leaf_->GetSize()) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    Page *next_page = next_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager_->FetchPage(next_page_id);
+    Release();
+    index_ = 0;
+    if (next_page == nullptr) {
+      return;
+    }
+    next_page->RLatch();
+    leaves_ahead_ = std::max(0, leaves_ahead_ - 1);
+    page_ = next_page;
+    leaf_ = reinterpret_cast<LeafPage *>(next_page->GetData());
+  }
+  if (bounded_ && page_ != nullptr && (*comparator_)(leaf_->KeyAt(index_), bound_) >= 0) {
+    Release();
+    index_ = 0;
+  }
+}
+
+/*
+ * Hand-over-hand to the left, with the same order of pinning and latching as
+ * above. The previous page id is only a hint: the leaf left of ours may have
+ * split or been merged away before we latch it. It is still the right one if
+ * it links to the leaf we came from, and then holds every key below our
+ * bound that is left of that leaf. Otherwise the leaf the bound belongs to is
+ * found from the root again. A leaf without keys below the bound, such as one
+ * emptied by a merge, is skipped. As with the forward scan, keys that a
+ * redistribution moves into the leaf we came from after we left it are missed.
+ */
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::SkipExhaustedLeavesBackward() {
+  while (page_ != nullptr && index_ < 0) {
+    page_id_t from_page_id = page_->GetPageId();
+    page_id_t prev_page_id = leaf_->GetPrevPageId();
+    Page *prev_page = prev_page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager_->FetchPage(prev_page_id);
+    Release();
+    index_ = 0;
+    if (prev_page == nullptr) {
+      return;
+    }
+    prev_page->RLatch();
+    // the previous page id is written without latching the leaf, see BPlusTree::LinkBack(), so it is only trusted
+    // if the leaf it leads to still links forward to the one we came from
+    if (reinterpret_cast<LeafPage *>(prev_page->GetData())->GetNextPageId() != from_page_id) {
+      prev_page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(prev_page_id, false);
+      prev_page = find_leaf_(bounded_ ? &bound_ : nullptr);
+      if (prev_page == nullptr) {
+        return;
+      }
+    }
+    page_ = prev_page;
+    leaf_ = reinterpret_cast<LeafPage *>(prev_page->GetData());
+    index_ = (bounded_ ? leaf_->KeyIndex(bound_, *comparator_) : leaf_->GetSize()) - 1;
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Release() {
+  if (page_ != nullptr) {
+    page_->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+    leaf_ = nullptr;
+  }
+}
+
+/*
+ * A batch's consumer may write to the tree, e.g. a DELETE over an index scan
+ * of the same tree, and would block on our read latch if we kept it. Keys
+ * are unique, so the pairs left are exactly the keys beyond the last one
+ * returned, wherever merges and splits have moved them in the meantime.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Park() {
+  if (page_ != nullptr) {
+    Release();
+    parked_ = true;
+  }
+  index_ = 0;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::Resume() {
+  if (!parked_) {
+    return;
+  }
+  parked_ = false;
+  const KeyType *key = reverse_ ? (bounded_ ? &bound_ : nullptr) : &last_key_;
+  page_ = find_leaf_(key);
+  if (page_ == nullptr) {
+    return;
+  }
+  leaf_ = reinterpret_cast<LeafPage *>(page_->GetData());
+  if (reverse_) {
+    index_ = (key == nullptr ? leaf_->GetSize() : leaf_->KeyIndex(*key, *comparator_)) - 1;
+    SkipExhaustedLeavesBackward();
+    return;
+  }
+  index_ = leaf_->KeyIndex(*key, *comparator_);
+  if (index_ < leaf_->GetSize() && (*comparator_)(leaf_->KeyAt(index_), *key) == 0) {
+    index_++;
+  }
+  SkipExhaustedLeaves();
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -0,0 +1,158 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer.cpp
+//
+// Identification: src/storage/index/key_normalizer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/key_normalizer.h"
+
+#include <cstring>
+#include <string>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr uint64_t SIGN_BIT = uint64_t{1} << 63;
+
+void PutByte(char byte, char *data, size_t size, size_t *offset) {
+  if (*offset < size) {
+    data[*offset] = byte;
+  }
+  (*offset)++;
+}
+
+auto GetByte(const char *data, size_t size, size_t *offset) -> char {
+  char byte = *offset < size ? data[*offset] : 0;
+  (*offset)++;
+  return byte;
+}
+
+// write the low width bytes of bits, most significant first
+void PutBigEndian(uint64_t bits, size_t width, char *data, size_t size, size_t *offset) {
+  for (size_t i = width; i > 0; i--) {
+    PutByte(static_cast<char>(bits >> (8 * (i - 1))), data, size, offset);
+  }
+}
+
+auto GetBigEndian(size_t width, const char *data, size_t size, size_t *offset) -> uint64_t {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < width; i++) {
+    bits = (bits << 8) | static_cast<uint8_t>(GetByte(data, size, offset));
+  }
+  return bits;
+}
+
+// flipping the sign bit of a two's complement integer orders it like an unsigned one
+template <typename T>
+void PutSigned(T value, char *data, size_t size, size_t *offset) {
+  uint64_t sign_bit = uint64_t{1} << (8 * sizeof(T) - 1);
+  PutBigEndian((static_cast<uint64_t>(value) & (sign_bit | (sign_bit - 1))) ^ sign_bit, sizeof(T), data, size, offset);
+}
+
+template <typename T>
+auto GetSigned(const char *data, size_t size, size_t *offset) -> T {
+  uint64_t sign_bit = uint64_t{1} << (8 * sizeof(T) - 1);
+  return static_cast<T>(GetBigEndian(sizeof(T), data, size, offset) ^ sign_bit);
+}
+
+}  // namespace
+
+void KeyNormalizer::Encode(const Value &value, char *data, size_t size, size_t *offset) {
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      PutSigned(value.GetAs<int8_t>(), data, size, offset);
+      break;
+    case TypeId::SMALLINT:
+      PutSigned(value.GetAs<int16_t>(), data, size, offset);
+      break;
+    case TypeId::INTEGER:
+      PutSigned(value.GetAs<int32_t>(), data, size, offset);
+      break;
+    case TypeId::BIGINT:
+      PutSigned(value.GetAs<int64_t>(), data, size, offset);
+      break;
+    case TypeId::DECIMAL: {
+      // -0.0 equals 0.0, so both get the same bytes
+      double decimal = value.GetAs<double>() == 0 ? 0 : value.GetAs<double>();
+      uint64_t bits;
+      memcpy(&bits, &decimal, sizeof(bits));
+      PutBigEndian((bits & SIGN_BIT) != 0 ? ~bits : bits ^ SIGN_BIT, sizeof(bits), data, size, offset);
+      break;
+    }
+    case TypeId::TIMESTAMP:
+      PutBigEndian(value.GetAs<uint64_t>(), sizeof(uint64_t), data, size, offset);
+      break;
+    case TypeId::VARCHAR: {
+      if (value.IsNull()) {
+        PutByte(0, data, size, offset);
+        break;
+      }
+      PutByte(1, data, size, offset);
+      // the stored length counts the terminating null character
+      const char *chars = value.GetData();
+      uint32_t length = value.GetLength() == 0 ? 0 : value.GetLength() - 1;
+      for (uint32_t i = 0; i < length && *offset < size; i++) {
+        PutByte(chars[i], data, size, offset);
+        if (chars[i] == 0) {
+          PutByte(static_cast<char>(0xFF), data, size, offset);
+        }
+      }
+      PutByte(0, data, size, offset);
+      PutByte(0, data, size, offset);
+      break;
+    }
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "Cannot normalize a value of this type");
+  }
+}
+
+auto KeyNormalizer::Decode(TypeId type_id, const char *data, size_t size, size_t *offset) -> Value {
+  switch (type_id) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return {type_id, GetSigned<int8_t>(data, size, offset)};
+    case TypeId::SMALLINT:
+      return {type_id, GetSigned<int16_t>(data, size, offset)};
+    case TypeId::INTEGER:
+      return {type_id, GetSigned<int32_t>(data, size, offset)};
+    case TypeId::BIGINT:
+      return {type_id, GetSigned<int64_t>(data, size, offset)};
+    case TypeId::DECIMAL: {
+      uint64_t bits = GetBigEndian(sizeof(uint64_t), data, size, offset);
+      bits = (bits & SIGN_BIT) != 0 ? bits ^ SIGN_BIT : ~bits;
+      double decimal;
+      memcpy(&decimal, &bits, sizeof(decimal));
+      return {type_id, decimal};
+    }
+    case TypeId::TIMESTAMP:
+      return {type_id, GetBigEndian(sizeof(uint64_t), data, size, offset)};
+    case TypeId::VARCHAR: {
+      if (GetByte(data, size, offset) == 0) {
+        return {type_id, nullptr, 0, false};
+      }
+      std::string chars;
+      while (*offset < size) {
+        char byte = GetByte(data, size, offset);
+        if (byte == 0 && GetByte(data, size, offset) == 0) {
+          break;
+        }
+        chars.push_back(byte);
+      }
+      return {type_id, chars};
+    }
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "Cannot decode a value of this type");
+  }
+}
+
+}  // namespace bustub
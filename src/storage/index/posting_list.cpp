@@ -0,0 +1,290 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list.cpp
+//
+// Identification: src/storage/index/posting_list.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/posting_list.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+auto RidLess(const RID &lhs, const RID &rhs) -> bool {
+  return static_cast<uint64_t>(lhs.Get()) < static_cast<uint64_t>(rhs.Get());
+}
+
+auto AsListPage(Page *page) -> PostingListPage * { return reinterpret_cast<PostingListPage *>(page->GetData()); }
+
+}  // namespace
+
+PostingList::PostingList(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+/*****************************************************************************
+ * INDEX OPERATIONS
+ *****************************************************************************/
+/*
+ * The common case of a key that has a posting list already only needs the
+ * shared latch; everything else looks the key up again under the exclusive
+ * one, since the value may have changed in between
+ */
+void PostingList::Insert(const Entry &entry, const RID &rid) {
+  RID value;
+  latch_.RLock();
+  if (entry.get_(&value) && IsPostingList(value)) {
+    InsertInto(value.GetPageId(), rid);
+    latch_.RUnlock();
+    return;
+  }
+  latch_.RUnlock();
+
+  latch_.WLock();
+  if (!entry.get_(&value)) {
+    entry.put_(rid);
+  } else if (IsPostingList(value)) {
+    InsertInto(value.GetPageId(), rid);
+  } else if (!(value == rid)) {
+    std::vector<RID> rids = {value, rid};
+    std::sort(rids.begin(), rids.end(), RidLess);
+    page_id_t head_page_id = Create(rids);
+    entry.erase_(value);
+    entry.put_(RID(head_page_id, POSTING_LIST_SLOT));
+  }
+  latch_.WUnlock();
+}
+
+void PostingList::Remove(const Entry &entry, const RID &rid) {
+  RID value;
+  latch_.RLock();
+  if (entry.get_(&value) && IsPostingList(value)) {
+    RemoveFrom(value.GetPageId(), rid);
+    if (!IsEmpty(value.GetPageId())) {
+      latch_.RUnlock();
+      return;
+    }
+  }
+  latch_.RUnlock();
+
+  latch_.WLock();
+  if (entry.get_(&value)) {
+    if (!IsPostingList(value)) {
+      if (value == rid) {
+        entry.erase_(value);
+      }
+    } else {
+      RemoveFrom(value.GetPageId(), rid);
+      if (IsEmpty(value.GetPageId())) {
+        entry.erase_(value);
+        Drop(value.GetPageId());
+      }
+    }
+  }
+  latch_.WUnlock();
+}
+
+void PostingList::Scan(const Entry &entry, std::vector<RID> *result) {
+  RID value;
+  latch_.RLock();
+  if (entry.get_(&value)) {
+    Expand(value, result);
+  }
+  latch_.RUnlock();
+}
+
+void PostingList::Expand(const RID &value, std::vector<RID> *result) {
+  if (IsPostingList(value)) {
+    ScanList(value.GetPageId(), result);
+  } else {
+    result->push_back(value);
+  }
+}
+
+/*****************************************************************************
+ * LIST OPERATIONS
+ *****************************************************************************/
+/*
+ * Start a list in a single page, the RIDs come from one key that had only
+ * one so far
+ */
+auto PostingList::Create(const std::vector<RID> &rids) -> page_id_t {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a posting list page");
+  }
+  AsListPage(page)->Init();
+  AsListPage(page)->SetRids(rids.data(), static_cast<int>(rids.size()));
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  return page_id;
+}
+
+/*
+ * Find the first page whose last RID is not less than rid, or the last page,
+ * and insert there. A full page moves the RIDs that do not fit to a new page
+ * after it: all but the new RID if that went to the very end of the list, as
+ * RIDs mostly grow, and half of them otherwise.
+ */
+void PostingList::InsertInto(page_id_t head_page_id, const RID &rid) {
+  Page *head = FetchListPage(head_page_id);
+  head->WLatch();
+  Page *page = head;
+  while (AsListPage(page)->GetNextPageId() != INVALID_PAGE_ID && AsListPage(page)->GetSize() > 0 &&
+         RidLess(AsListPage(page)->GetLastRid(), rid)) {
+    Page *next = FetchListPage(AsListPage(page)->GetNextPageId());
+    if (page != head) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    page = next;
+  }
+
+  auto list_page = AsListPage(page);
+  bool at_end = list_page->GetNextPageId() == INVALID_PAGE_ID &&
+                (list_page->GetSize() == 0 || RidLess(list_page->GetLastRid(), rid));
+  std::vector<RID> rids;
+  bool dirty = true;
+  if (!at_end || !list_page->Append(rid)) {
+    list_page->GetRids(&rids);
+    auto position = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+    dirty = position == rids.end() || !(*position == rid);
+  }
+  if (dirty && !rids.empty()) {
+    rids.insert(std::lower_bound(rids.begin(), rids.end(), rid, RidLess), rid);
+    int count = static_cast<int>(rids.size());
+    int stored = list_page->SetRids(rids.data(), count);
+    if (stored < count) {
+      if (!at_end) {
+        stored = list_page->SetRids(rids.data(), count / 2);
+      }
+      page_id_t new_page_id;
+      Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);
+      if (new_page == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate a posting list page");
+      }
+      AsListPage(new_page)->Init();
+      AsListPage(new_page)->SetRids(rids.data() + stored, count - stored);
+      AsListPage(new_page)->SetNextPageId(list_page->GetNextPageId());
+      list_page->SetNextPageId(new_page_id);
+      buffer_pool_manager_->UnpinPage(new_page_id, true);
+    }
+  }
+
+  if (page != head) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  }
+  head->WUnlatch();
+  buffer_pool_manager_->UnpinPage(head_page_id, dirty && page == head);
+}
+
+/*
+ * A page that becomes empty is unlinked and deleted, except for the head,
+ * which takes over the RIDs of the page after it instead. Only an empty list
+ * has an empty page.
+ */
+void PostingList::RemoveFrom(page_id_t head_page_id, const RID &rid) {
+  Page *head = FetchListPage(head_page_id);
+  head->WLatch();
+  Page *previous = nullptr;
+  Page *page = head;
+  while (AsListPage(page)->GetNextPageId() != INVALID_PAGE_ID && RidLess(AsListPage(page)->GetLastRid(), rid)) {
+    Page *next = FetchListPage(AsListPage(page)->GetNextPageId());
+    if (previous != nullptr && previous != head) {
+      buffer_pool_manager_->UnpinPage(previous->GetPageId(), false);
+    }
+    previous = page;
+    page = next;
+  }
+
+  auto list_page = AsListPage(page);
+  std::vector<RID> rids;
+  list_page->GetRids(&rids);
+  auto position = std::lower_bound(rids.begin(), rids.end(), rid, RidLess);
+  bool dirty = position != rids.end() && *position == rid;
+  bool previous_dirty = false;
+  page_id_t deleted_page_id = INVALID_PAGE_ID;
+  if (dirty) {
+    rids.erase(position);
+    list_page->SetRids(rids.data(), static_cast<int>(rids.size()));
+    if (rids.empty() && page != head) {
+      AsListPage(previous)->SetNextPageId(list_page->GetNextPageId());
+      previous_dirty = true;
+      deleted_page_id = page->GetPageId();
+    } else if (rids.empty() && list_page->GetNextPageId() != INVALID_PAGE_ID) {
+      Page *next = FetchListPage(list_page->GetNextPageId());
+      AsListPage(next)->GetRids(&rids);
+      list_page->SetRids(rids.data(), static_cast<int>(rids.size()));
+      list_page->SetNextPageId(AsListPage(next)->GetNextPageId());
+      deleted_page_id = next->GetPageId();
+      buffer_pool_manager_->UnpinPage(deleted_page_id, false);
+    }
+  }
+
+  if (previous != nullptr && previous != head) {
+    buffer_pool_manager_->UnpinPage(previous->GetPageId(), previous_dirty);
+  }
+  if (page != head) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+  }
+  head->WUnlatch();
+  buffer_pool_manager_->UnpinPage(head_page_id, (dirty && page == head) || (previous_dirty && previous == head));
+  if (deleted_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->DeletePage(deleted_page_id);
+  }
+}
+
+void PostingList::ScanList(page_id_t head_page_id, std::vector<RID> *result) {
+  Page *head = FetchListPage(head_page_id);
+  head->RLatch();
+  Page *page = head;
+  while (true) {
+    AsListPage(page)->GetRids(result);
+    page_id_t next_page_id = AsListPage(page)->GetSize() == 0 ? INVALID_PAGE_ID : AsListPage(page)->GetNextPageId();
+    if (page != head) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page = FetchListPage(next_page_id);
+  }
+  head->RUnlatch();
+  buffer_pool_manager_->UnpinPage(head_page_id, false);
+}
+
+auto PostingList::IsEmpty(page_id_t head_page_id) -> bool {
+  Page *head = FetchListPage(head_page_id);
+  head->RLatch();
+  bool empty = AsListPage(head)->GetSize() == 0;
+  head->RUnlatch();
+  buffer_pool_manager_->UnpinPage(head_page_id, false);
+  return empty;
+}
+
+/*
+ * The emptied head is written back before it is deleted: a scan that read
+ * the reference before the key was removed may still fetch it, and then
+ * finds it empty, whether it is still in the pool or read from disk
+ */
+void PostingList::Drop(page_id_t head_page_id) {
+  buffer_pool_manager_->FlushPage(head_page_id);
+  buffer_pool_manager_->DeletePage(head_page_id);
+}
+
+auto PostingList::FetchListPage(page_id_t page_id) -> Page * {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot fetch a posting list page");
+  }
+  return page;
+}
+
+}  // namespace bustub
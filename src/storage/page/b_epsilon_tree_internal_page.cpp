@@ -0,0 +1,191 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_epsilon_tree_internal_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+
+#include "common/rid.h"
+#include "storage/page/b_epsilon_tree_internal_page.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, int max_size, int buffer_max_size) {
+  assert(B_EPSILON_TREE_INTERNAL_PAGE_HEADER_SIZE + max_size * B_EPSILON_TREE_PIVOT_SIZE +
+             buffer_max_size * B_EPSILON_TREE_MESSAGE_SIZE <=
+         PAGE_SIZE);
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetMinSize(0);
+  buffer_size_ = 0;
+  buffer_max_size_ = buffer_max_size;
+}
+
+/*****************************************************************************
+ * CHILDREN
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType { return Pivots()[index].first; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> page_id_t { return Pivots()[index].second; }
+
+/*
+ * The last child whose key is not greater than key, the first key is ignored
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::ChildIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
+  auto pivots = Pivots();
+  auto position = std::upper_bound(pivots + 1, pivots + GetSize(), key,
+                                   [&comparator](const KeyType &key, const std::pair<KeyType, page_id_t> &pivot) {
+                                     return comparator(key, pivot.first) < 0;
+                                   });
+  return static_cast<int>(position - pivots) - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(page_id_t old_value, const KeyType &new_key,
+                                                        page_id_t new_value) {
+  Pivots()[0].second = old_value;
+  Pivots()[1] = std::make_pair(new_key, new_value);
+  SetSize(2);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::InsertChildAfter(int index, const KeyType &new_key, page_id_t new_value) {
+  assert(GetSize() < GetMaxSize());
+  auto pivots = Pivots();
+  std::move_backward(pivots + index + 1, pivots + GetSize(), pivots + GetSize() + 1);
+  pivots[index + 1] = std::make_pair(new_key, new_value);
+  IncreaseSize(1);
+}
+
+/*****************************************************************************
+ * BUFFER
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::GetBufferSize() const -> int { return buffer_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::GetBufferMaxSize() const -> int { return buffer_max_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::IsBufferFull() const -> bool { return buffer_size_ >= buffer_max_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::MessageAt(int index) const -> const Message & { return Messages()[index]; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::FindMessage(const KeyType &key, const KeyComparator &comparator) const
+    -> const Message * {
+  int index = MessageIndex(key, comparator);
+  if (index == buffer_size_ || comparator(Messages()[index].key_, key) != 0) {
+    return nullptr;
+  }
+  return Messages() + index;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::PutMessage(const Message &message, const KeyComparator &comparator) -> bool {
+  auto messages = Messages();
+  int index = MessageIndex(message.key_, comparator);
+  if (index < buffer_size_ && comparator(messages[index].key_, message.key_) == 0) {
+    messages[index] = message;
+    return true;
+  }
+  if (IsBufferFull()) {
+    return false;
+  }
+  std::move_backward(messages + index, messages + buffer_size_, messages + buffer_size_ + 1);
+  messages[index] = message;
+  buffer_size_++;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::ChildMessages(int index, const KeyComparator &comparator, int *begin,
+                                                      int *end) const {
+  *begin = index == 0 ? 0 : MessageIndex(KeyAt(index), comparator);
+  *end = index == GetSize() - 1 ? buffer_size_ : MessageIndex(KeyAt(index + 1), comparator);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_INTERNAL_PAGE_TYPE::RemoveMessages(int begin, int end) {
+  auto messages = Messages();
+  std::move(messages + end, messages + buffer_size_, messages + begin);
+  buffer_size_ -= end - begin;
+}
+
+/*
+ * Find the first index i so that Messages()[i].key_ >= key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::MessageIndex(const KeyType &key, const KeyComparator &comparator) const
+    -> int {
+  auto messages = Messages();
+  auto position = std::lower_bound(
+      messages, messages + buffer_size_, key,
+      [&comparator](const Message &message, const KeyType &key) { return comparator(message.key_, key) < 0; });
+  return static_cast<int>(position - messages);
+}
+
+/*****************************************************************************
+ * SPLIT
+ *****************************************************************************/
+/*
+ * The recipient is empty and has the same sizes. Its first key, which is
+ * ignored, is the key between the halves.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BEpsilonTreeInternalPage *recipient,
+                                                   const KeyComparator &comparator) -> KeyType {
+  int half = GetSize() / 2;
+  KeyType middle_key = KeyAt(half);
+  std::copy(Pivots() + half, Pivots() + GetSize(), recipient->Pivots());
+  recipient->SetSize(GetSize() - half);
+  SetSize(half);
+
+  int begin = MessageIndex(middle_key, comparator);
+  std::copy(Messages() + begin, Messages() + buffer_size_, recipient->Messages());
+  recipient->buffer_size_ = buffer_size_ - begin;
+  buffer_size_ = begin;
+  return middle_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::Pivots() -> std::pair<KeyType, page_id_t> * {
+  return reinterpret_cast<std::pair<KeyType, page_id_t> *>(data_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::Pivots() const -> const std::pair<KeyType, page_id_t> * {
+  return reinterpret_cast<const std::pair<KeyType, page_id_t> *>(data_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::Messages() -> Message * {
+  return reinterpret_cast<Message *>(data_ + GetMaxSize() * B_EPSILON_TREE_PIVOT_SIZE);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_INTERNAL_PAGE_TYPE::Messages() const -> const Message * {
+  return reinterpret_cast<const Message *>(data_ + GetMaxSize() * B_EPSILON_TREE_PIVOT_SIZE);
+}
+
+template class BEpsilonTreeInternalPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class BEpsilonTreeInternalPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class BEpsilonTreeInternalPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class BEpsilonTreeInternalPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class BEpsilonTreeInternalPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
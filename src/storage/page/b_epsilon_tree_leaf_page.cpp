@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_epsilon_tree_leaf_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+
+#include "common/rid.h"
+#include "storage/page/b_epsilon_tree_leaf_page.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, int max_size) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetMinSize(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType { return array_[index].first; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_LEAF_PAGE_TYPE::GetItem(int index) const -> const MappingType & { return array_[index]; }
+
+/*
+ * Find the first index i so that array_[i].first >= key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
+  auto position = std::lower_bound(array_, array_ + GetSize(), key, [&comparator](const MappingType &item,
+                                                                                    const KeyType &key) {
+    return comparator(item.first, key) < 0;
+  });
+  return static_cast<int>(position - array_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_EPSILON_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const
+    -> bool {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(array_[index].first, key) != 0) {
+    return false;
+  }
+  *value = array_[index].second;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_LEAF_PAGE_TYPE::Upsert(const KeyType &key, const ValueType &value,
+                                           const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(array_[index].first, key) == 0) {
+    array_[index].second = value;
+    return;
+  }
+  assert(GetSize() < GetMaxSize());
+  std::move_backward(array_ + index, array_ + GetSize(), array_ + GetSize() + 1);
+  array_[index] = MappingType(key, value);
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_LEAF_PAGE_TYPE::Delete(const KeyType &key, const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(array_[index].first, key) != 0) {
+    return;
+  }
+  std::move(array_ + index + 1, array_ + GetSize(), array_ + index);
+  IncreaseSize(-1);
+}
+
+/*
+ * Remove the upper half of key & value pairs from this page to the empty
+ * recipient page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_EPSILON_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BEpsilonTreeLeafPage *recipient) {
+  int half = GetSize() / 2;
+  std::copy(array_ + half, array_ + GetSize(), recipient->array_);
+  recipient->SetSize(GetSize() - half);
+  SetSize(half);
+}
+
+template class BEpsilonTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class BEpsilonTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class BEpsilonTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class BEpsilonTreeLeafPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class BEpsilonTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -23,36 +24,95 @@ namespace bustub {
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
  * max page size
+ * Min size is half of max size, but never more than half of the children that
+ * fit uncompressed: a page that splits because a key does not fit is only
+ * known to hold that many.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  SetMinSize((std::min(max_size, static_cast<int>(INTERNAL_PAGE_SLOT_COUNT) - 1) + 1) / 2);
+  array_.Init(INTERNAL_PAGE_SLOT_SPACE);
+}
+/*
+ * Helper methods to get/set the right sibling and the high key, which are only
+ * maintained in B-link mode. The high key is only meaningful while there is a
+ * right sibling.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const -> const KeyType & { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &high_key) { high_key_ = high_key; }
+
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key{};
-  return key;
-}
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType { return array_.KeyAt(index); }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  BUSTUB_ASSERT(GetSize() * array_.SlotSize(key, GetSize()) <= INTERNAL_PAGE_SLOT_SPACE,
+                "internal page has no room for the key");
+  array_.SetKeyAt(index, key, GetSize());
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
  * equals to input "value"
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int { return 0; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int {
+  for (int i = 0; i < GetSize(); i++) {
+    if (array_.ValueAt(i) == value) {
+      return i;
+    }
+  }
+  return -1;
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return 0; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return array_.ValueAt(index); }
+
+/*
+ * Helper methods to check whether the compressed slots have room for one more
+ * entry with the given key, for one more entry with any key, or for all
+ * entries of another page whose first key is replaced by middle_key. None of
+ * them looks at max size.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const -> bool {
+  return (GetSize() + 1) * array_.SlotSize(key, GetSize()) <= INTERNAL_PAGE_SLOT_SPACE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomForAnyKey() const -> bool {
+  return (GetSize() + 1) * FULL_SLOT_SIZE <= INTERNAL_PAGE_SLOT_SPACE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomForAll(const BPlusTreeInternalPage *other, const KeyType &middle_key) const
+    -> bool {
+  return (GetSize() + other->GetSize()) * array_.SlotSize(other->array_, other->GetSize(), middle_key, GetSize()) <=
+         INTERNAL_PAGE_SLOT_SPACE;
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -64,7 +124,9 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { ret
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType {
-  return INVALID_PAGE_ID;
+  // find the first key strictly greater than the search key; its left neighbour owns the subtree. Keys are
+  // normalized and order like their bytes, which lets the slot array search them without the comparator
+  return array_.ValueAt(array_.UpperBound(key, 1, GetSize()) - 1);
 }
 
 /*****************************************************************************
@@ -78,16 +140,51 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCompara
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
-                                                     const ValueType &new_value) {}
+                                                     const ValueType &new_value) {
+  // the first key is never looked at, so it simply repeats the only real one
+  array_.Insert(0, new_key, old_value, 0);
+  array_.Insert(1, new_key, new_value, 1);
+  SetSize(2);
+}
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
  * old_value
+ * The caller makes sure the page HasRoomFor() the key.
  * @return:  new size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                                                      const ValueType &new_value) -> int {
-  return 0;
+  BUSTUB_ASSERT(HasRoomFor(new_key), "internal page has no room for the key");
+  int index = ValueIndex(old_value) + 1;
+  array_.Insert(index, new_key, new_value, GetSize());
+  IncreaseSize(1);
+  return GetSize();
+}
+
+/*
+ * Insert new_key & new_value pair at the position its key belongs to. In
+ * B-link mode the child split off from may itself still wait to be linked into
+ * this page, so the position cannot be found by the old child's page id.
+ * The caller makes sure the page HasRoomFor() the key.
+ * @return:  new size after insertion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNode(const KeyType &new_key, const ValueType &new_value) -> int {
+  BUSTUB_ASSERT(HasRoomFor(new_key), "internal page has no room for the key");
+  array_.Insert(array_.UpperBound(new_key, 1, GetSize()), new_key, new_value, GetSize());
+  IncreaseSize(1);
+  return GetSize();
+}
+
+/*
+ * Append new_key & new_value pair at the end and adopt the child. This is only
+ * used while bulk loading, where pages are filled left to right in key order.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AppendChild(const KeyType &key, const ValueType &value,
+                                                 BufferPoolManager *buffer_pool_manager) {
+  CopyLastFrom(MappingType(key, value), buffer_pool_manager);
 }
 
 /*****************************************************************************
@@ -98,14 +195,24 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
-                                                BufferPoolManager *buffer_pool_manager) {}
+                                                BufferPoolManager *buffer_pool_manager) {
+  int keep = GetSize() / 2;
+  recipient->CopyNFrom(this, keep, GetSize() - keep, buffer_pool_manager);
+  SetSize(keep);
+  array_.Compact(keep);
+}
 
-/* Copy entries into me, starting from {items} and copy {size} entries.
+/* Copy entries into me, {size} entries of donor starting from index {from}.
  * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(const BPlusTreeInternalPage *donor, int from, int size,
+                                               BufferPoolManager *buffer_pool_manager) {
+  for (int i = from; i < from + size; i++) {
+    CopyLastFrom(MappingType(donor->KeyAt(i), donor->ValueAt(i)), buffer_pool_manager);
+  }
+}
 
 /*****************************************************************************
  * REMOVE
@@ -116,14 +223,21 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  array_.Remove(index, GetSize());
+  IncreaseSize(-1);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType { return INVALID_PAGE_ID; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType {
+  ValueType only_child = ValueAt(0);
+  SetSize(0);
+  return only_child;
+}
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
@@ -133,10 +247,16 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType { r
  * to make sure the middle key is added to the recipient to maintain the invariant.
  * You also need to use BufferPoolManager to persist changes to the parent page id for those
  * pages that are moved to the recipient
+ * The caller makes sure the recipient HasRoomForAll() of them. My first key is
+ * replaced on the way, as storing the middle key here might not fit.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                               BufferPoolManager *buffer_pool_manager) {}
+                                               BufferPoolManager *buffer_pool_manager) {
+  recipient->CopyLastFrom(MappingType(middle_key, ValueAt(0)), buffer_pool_manager);
+  recipient->CopyNFrom(this, 1, GetSize() - 1, buffer_pool_manager);
+  SetSize(0);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -151,14 +271,21 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                      BufferPoolManager *buffer_pool_manager) {}
+                                                      BufferPoolManager *buffer_pool_manager) {
+  recipient->CopyLastFrom(MappingType(middle_key, ValueAt(0)), buffer_pool_manager);
+  Remove(0);
+}
 
 /* Append an entry at the end.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  array_.Insert(GetSize(), pair.first, pair.second, GetSize());
+  Adopt(pair.second, buffer_pool_manager);
+  IncreaseSize(1);
+}
 
 /*
  * Remove the last key & value pair from this page to head of "recipient" page.
@@ -169,14 +296,39 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                       BufferPoolManager *buffer_pool_manager) {}
+                                                       BufferPoolManager *buffer_pool_manager) {
+  recipient->SetKeyAt(0, middle_key);
+  IncreaseSize(-1);
+  recipient->CopyFirstFrom(MappingType(KeyAt(GetSize()), ValueAt(GetSize())), buffer_pool_manager);
+}
 
 /* Append an entry at the beginning.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  array_.Insert(0, pair.first, pair.second, GetSize());
+  Adopt(pair.second, buffer_pool_manager);
+  IncreaseSize(1);
+}
+
+/*
+ * Point the child page's parent id at me. The child is only reachable through a page the caller holds write
+ * latched, so no latch on the child itself is needed.
+ * B-link trees find parents without parent ids and pass no buffer pool manager, as their children may be latched
+ * by others while this page splits.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Adopt(const ValueType &child_page_id, BufferPoolManager *buffer_pool_manager) {
+  if (buffer_pool_manager == nullptr) {
+    return;
+  }
+  Page *page = buffer_pool_manager->FetchPage(child_page_id);
+  BUSTUB_ASSERT(page != nullptr, "child page must be fetchable");
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_page_id, true);
+}
 
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
@@ -0,0 +1,462 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/b_plus_tree_slot_array.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_slot_array.h"
+
+namespace bustub {
+
+#define SLOT_ARRAY_TYPE BPlusTreeSlotArray<KeyType, ValueType>
+
+namespace {
+
+// searches narrow down to a window this many middles wide before counting the ones below the search key
+constexpr int SEARCH_WINDOW = 16;
+
+// the 8 bytes at data as a big-endian integer, of which mask keeps the middle
+inline auto LoadMiddle(const char *data, uint64_t mask) -> uint64_t {
+  uint64_t bits;
+  memcpy(&bits, data, sizeof(bits));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  bits = __builtin_bswap64(bits);
+#endif
+  return bits & mask;
+}
+
+auto CountLess(const char *middles, size_t middle_size, uint64_t mask, int begin, int end, uint64_t target) -> int {
+  int count = 0;
+  for (int i = begin; i < end; i++) {
+    count += static_cast<int>(LoadMiddle(middles + i * middle_size, mask) < target);
+  }
+  return count;
+}
+
+#if defined(__x86_64__)
+/*
+ * Counts with AVX2 compares for middles as wide as a vector lane: byte swap
+ * the lanes to big-endian and flip their sign bits, so that the signed
+ * compares order them like the unsigned keys. Other widths and the tail of
+ * the window are counted one by one.
+ */
+__attribute__((target("avx2"))) auto CountLessAvx2(const char *middles, size_t middle_size, uint64_t mask, int begin,
+                                                   int end, uint64_t target) -> int {
+  int count = 0;
+  int i = begin;
+  switch (middle_size) {
+    case 8: {
+      const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2,
+                                               1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+      const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+      const __m256i key = _mm256_set1_epi64x(static_cast<int64_t>(target ^ static_cast<uint64_t>(INT64_MIN)));
+      for (; i + 4 <= end; i += 4) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(middles + i * middle_size));
+        lanes = _mm256_xor_si256(_mm256_shuffle_epi8(lanes, reverse), sign);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(key, lanes))));
+      }
+      break;
+    }
+    case 4: {
+      const __m256i reverse = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+                                               5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+      const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+      const __m256i key = _mm256_set1_epi32(static_cast<int32_t>((target >> 32) ^ static_cast<uint32_t>(INT32_MIN)));
+      for (; i + 8 <= end; i += 8) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(middles + i * middle_size));
+        lanes = _mm256_xor_si256(_mm256_shuffle_epi8(lanes, reverse), sign);
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(key, lanes))));
+      }
+      break;
+    }
+    case 2: {
+      const __m256i reverse = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4,
+                                               7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+      const __m256i sign = _mm256_set1_epi16(INT16_MIN);
+      const __m256i key = _mm256_set1_epi16(static_cast<int16_t>((target >> 48) ^ 0x8000));
+      for (; i + 16 <= end; i += 16) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(middles + i * middle_size));
+        lanes = _mm256_xor_si256(_mm256_shuffle_epi8(lanes, reverse), sign);
+        // every 16-bit lane sets two bits of the byte mask
+        count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi16(key, lanes))) / 2;
+      }
+      break;
+    }
+    case 1: {
+      const __m256i sign = _mm256_set1_epi8(INT8_MIN);
+      const __m256i key = _mm256_set1_epi8(static_cast<int8_t>((target >> 56) ^ 0x80));
+      for (; i + 32 <= end; i += 32) {
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(middles + i * middle_size));
+        lanes = _mm256_xor_si256(lanes, sign);
+        count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi8(key, lanes)));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return count + CountLess(middles, middle_size, mask, i, end, target);
+}
+
+const bool HAS_AVX2 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+}();
+#endif
+
+}  // namespace
+
+/*****************************************************************************
+ * SLOT ACCESS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::Init(size_t space) {
+  prefix_size_ = 0;
+  suffix_size_ = 0;
+  space_ = static_cast<uint16_t>(space);
+}
+
+/*
+ * Reassemble the key at index from the pattern and the middle bytes stored in
+ * its slot
+ */
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::KeyAt(int index) const -> KeyType {
+  KeyType key = pattern_;
+  memcpy(reinterpret_cast<char *>(&key) + prefix_size_, MiddleData(index), MiddleSize());
+  return key;
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::ValueAt(int index) const -> ValueType {
+  ValueType value;
+  memcpy(reinterpret_cast<char *>(&value), ValueData(index), sizeof(ValueType));
+  return value;
+}
+
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::SetKeyAt(int index, const KeyType &key, int size) {
+  Widen(key, size);
+  memcpy(MiddleData(index), reinterpret_cast<const char *>(&key) + prefix_size_, MiddleSize());
+}
+
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::SetValueAt(int index, const ValueType &value) {
+  memcpy(ValueData(index), reinterpret_cast<const char *>(&value), sizeof(ValueType));
+}
+
+/*
+ * Same as KeyAt and ValueAt for a run of pairs, but the middle size is only
+ * worked out once and the middles are read front to back
+ */
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::CopyOut(int from, int count, std::pair<KeyType, ValueType> *items) const {
+  size_t middle_size = MiddleSize();
+  const char *middle = MiddleData(from);
+  for (int i = 0; i < count; i++, middle += middle_size) {
+    items[i].first = pattern_;
+    memcpy(reinterpret_cast<char *>(&items[i].first) + prefix_size_, middle, middle_size);
+    memcpy(reinterpret_cast<char *>(&items[i].second), ValueData(from + i), sizeof(ValueType));
+  }
+}
+
+/*****************************************************************************
+ * INSERTION AND REMOVAL
+ *****************************************************************************/
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::Insert(int index, const KeyType &key, const ValueType &value, int size) {
+  Widen(key, size);
+  memmove(MiddleData(index + 1), MiddleData(index), (size - index) * MiddleSize());
+  memcpy(MiddleData(index), reinterpret_cast<const char *>(&key) + prefix_size_, MiddleSize());
+  // values are stored back to front, so the ones behind index move towards the middles
+  memmove(ValueData(size), ValueData(size - 1), (size - index) * sizeof(ValueType));
+  SetValueAt(index, value);
+}
+
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::Remove(int index, int size) {
+  memmove(MiddleData(index), MiddleData(index + 1), (size - index - 1) * MiddleSize());
+  memmove(ValueData(size - 2), ValueData(size - 1), (size - index - 1) * sizeof(ValueType));
+}
+
+/*
+ * Recompute the shared prefix and suffix from the keys left in the array,
+ * e.g. after half of them moved to a new page
+ */
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::Compact(int size) {
+  if (size == 0) {
+    return;
+  }
+  KeyType pattern = KeyAt(0);
+  size_t prefix_size = sizeof(KeyType);
+  size_t suffix_size = sizeof(KeyType);
+  for (int i = 1; i < size; i++) {
+    KeyType key = KeyAt(i);
+    prefix_size = CommonPrefix(pattern, key, prefix_size);
+    suffix_size = CommonSuffix(pattern, key, suffix_size);
+  }
+  if (MiddleSize(prefix_size, suffix_size) < MiddleSize()) {
+    Reencode(pattern, prefix_size, suffix_size, size);
+  }
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::LowerBound(const KeyType &key, int from, int size) const -> int {
+  return Bound(key, from, size, false);
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::UpperBound(const KeyType &key, int from, int size) const -> int {
+  return Bound(key, from, size, true);
+}
+
+/*
+ * All keys share the prefix and suffix of the pattern, so a search key that
+ * differs in the prefix goes before or after all of them, and otherwise only
+ * the middles need to be compared. Equal middles mean equal keys, unless the
+ * search key has another suffix.
+ *
+ * Middles of up to 8 bytes are compared as integers: a branch-free binary
+ * search narrows down to a small window, in which the middles below the key
+ * are counted, with AVX2 if the CPU supports it. Loading a middle reads 8
+ * bytes, which stays within the space: it holds size * (w + sizeof(ValueType))
+ * bytes and every value takes at least 4 of them.
+ */
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::Bound(const KeyType &key, int from, int size, bool upper) const -> int {
+  if (from >= size) {
+    return size;
+  }
+  auto probe = reinterpret_cast<const char *>(&key);
+  auto pattern = reinterpret_cast<const char *>(&pattern_);
+  size_t middle_size = MiddleSize();
+  int cmp = memcmp(probe, pattern, middle_size == 0 ? sizeof(KeyType) : prefix_size_);
+  if (cmp != 0 || middle_size == 0) {
+    return cmp < 0 || (cmp == 0 && !upper) ? from : size;
+  }
+
+  const char *middle = probe + prefix_size_;
+  int index;
+  if (middle_size <= sizeof(uint64_t)) {
+    uint64_t mask = ~uint64_t{0} << (8 * (sizeof(uint64_t) - middle_size));
+    uint64_t target = 0;
+    memcpy(&target, middle, middle_size);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    target = __builtin_bswap64(target);
+#endif
+    int base = from;
+    int count = size - from;
+    int window = std::max(SEARCH_WINDOW, static_cast<int>(32 / middle_size));
+    while (count > window) {
+      int half = count / 2;
+      base = LoadMiddle(MiddleData(base + half), mask) < target ? base + half : base;
+      count -= half;
+    }
+#if defined(__x86_64__)
+    if (HAS_AVX2) {
+      index = base + CountLessAvx2(slots_, middle_size, mask, base, base + count, target);
+    } else {
+      index = base + CountLess(slots_, middle_size, mask, base, base + count, target);
+    }
+#else
+    index = base + CountLess(slots_, middle_size, mask, base, base + count, target);
+#endif
+  } else {
+    int left = from;
+    int right = size;
+    while (left < right) {
+      int mid = left + (right - left) / 2;
+      if (memcmp(MiddleData(mid), middle, middle_size) < 0) {
+        left = mid + 1;
+      } else {
+        right = mid;
+      }
+    }
+    index = left;
+  }
+
+  if (index < size && memcmp(MiddleData(index), middle, middle_size) == 0) {
+    size_t suffix_offset = sizeof(KeyType) - suffix_size_;
+    int suffix_cmp = memcmp(probe + suffix_offset, pattern + suffix_offset, suffix_size_);
+    if (suffix_cmp > 0 || (suffix_cmp == 0 && upper)) {
+      index++;
+    }
+  }
+  return index;
+}
+
+/*****************************************************************************
+ * SPACE ACCOUNTING
+ *****************************************************************************/
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::SlotSize(const KeyType &key, int size) const -> size_t {
+  if (size == 0) {
+    return sizeof(ValueType);
+  }
+  return sizeof(ValueType) +
+         MiddleSize(CommonPrefix(pattern_, key, prefix_size_), CommonSuffix(pattern_, key, suffix_size_));
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::SlotSize(const BPlusTreeSlotArray &other, int other_size, int size) const -> size_t {
+  if (other_size == 0) {
+    return size == 0 ? sizeof(ValueType) : sizeof(ValueType) + MiddleSize();
+  }
+  if (size == 0) {
+    return sizeof(ValueType) + other.MiddleSize();
+  }
+  size_t prefix_size = CommonPrefix(pattern_, other.pattern_, std::min(prefix_size_, other.prefix_size_));
+  size_t suffix_size = CommonSuffix(pattern_, other.pattern_, std::min(suffix_size_, other.suffix_size_));
+  return sizeof(ValueType) + MiddleSize(prefix_size, suffix_size);
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::SlotSize(const BPlusTreeSlotArray &other, int other_size, const KeyType &key, int size) const
+    -> size_t {
+  if (size == 0) {
+    return other.SlotSize(key, other_size);
+  }
+  size_t prefix_size = CommonPrefix(pattern_, key, prefix_size_);
+  size_t suffix_size = CommonSuffix(pattern_, key, suffix_size_);
+  if (other_size > 0) {
+    prefix_size = CommonPrefix(pattern_, other.pattern_, std::min<size_t>(prefix_size, other.prefix_size_));
+    suffix_size = CommonSuffix(pattern_, other.pattern_, std::min<size_t>(suffix_size, other.suffix_size_));
+  }
+  return sizeof(ValueType) + MiddleSize(prefix_size, suffix_size);
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::MiddleSize() const -> size_t {
+  return MiddleSize(prefix_size_, suffix_size_);
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::MiddleData(int index) -> char * {
+  return slots_ + index * MiddleSize();
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::MiddleData(int index) const -> const char * {
+  return slots_ + index * MiddleSize();
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::ValueData(int index) -> char * {
+  return slots_ + space_ - (index + 1) * sizeof(ValueType);
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::ValueData(int index) const -> const char * {
+  return slots_ + space_ - (index + 1) * sizeof(ValueType);
+}
+
+/*
+ * The first key stored in an empty array becomes the pattern as a whole;
+ * later keys can only shorten the shared prefix and suffix
+ */
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::Widen(const KeyType &key, int size) {
+  if (size == 0) {
+    pattern_ = key;
+    prefix_size_ = sizeof(KeyType);
+    suffix_size_ = sizeof(KeyType);
+    return;
+  }
+  size_t prefix_size = CommonPrefix(pattern_, key, prefix_size_);
+  size_t suffix_size = CommonSuffix(pattern_, key, suffix_size_);
+  if (prefix_size != prefix_size_ || suffix_size != suffix_size_) {
+    Reencode(pattern_, prefix_size, suffix_size, size);
+  }
+}
+
+/*
+ * Middles only ever change size as a whole, so growing middles are rewritten
+ * back to front and shrinking ones front to back, each middle only
+ * overlapping middles that were already rewritten. Values stay where they are.
+ */
+template <typename KeyType, typename ValueType>
+void SLOT_ARRAY_TYPE::Reencode(const KeyType &pattern, size_t prefix_size, size_t suffix_size, int size) {
+  size_t old_middle_size = MiddleSize();
+  size_t new_middle_size = MiddleSize(prefix_size, suffix_size);
+  auto rewrite = [&](int index) {
+    KeyType key = KeyAt(index);
+    memcpy(slots_ + index * new_middle_size, reinterpret_cast<const char *>(&key) + prefix_size, new_middle_size);
+  };
+  if (new_middle_size >= old_middle_size) {
+    for (int i = size - 1; i >= 0; i--) {
+      rewrite(i);
+    }
+  } else {
+    for (int i = 0; i < size; i++) {
+      rewrite(i);
+    }
+  }
+  pattern_ = pattern;
+  prefix_size_ = static_cast<uint16_t>(prefix_size);
+  suffix_size_ = static_cast<uint16_t>(suffix_size);
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::CommonPrefix(const KeyType &a, const KeyType &b, size_t limit) -> size_t {
+  auto lhs = reinterpret_cast<const char *>(&a);
+  auto rhs = reinterpret_cast<const char *>(&b);
+  size_t length = 0;
+  while (length < limit && lhs[length] == rhs[length]) {
+    length++;
+  }
+  return length;
+}
+
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::CommonSuffix(const KeyType &a, const KeyType &b, size_t limit) -> size_t {
+  auto lhs = reinterpret_cast<const char *>(&a) + sizeof(KeyType);
+  auto rhs = reinterpret_cast<const char *>(&b) + sizeof(KeyType);
+  size_t length = 0;
+  while (length < limit && lhs[-1 - static_cast<ptrdiff_t>(length)] == rhs[-1 - static_cast<ptrdiff_t>(length)]) {
+    length++;
+  }
+  return length;
+}
+
+/*
+ * Prefix and suffix overlap once every key is equal to the pattern
+ */
+template <typename KeyType, typename ValueType>
+auto SLOT_ARRAY_TYPE::MiddleSize(size_t prefix_size, size_t suffix_size) -> size_t {
+  return prefix_size + suffix_size >= sizeof(KeyType) ? 0 : sizeof(KeyType) - prefix_size - suffix_size;
+}
+
+template class BPlusTreeSlotArray<GenericKey<4>, RID>;
+template class BPlusTreeSlotArray<GenericKey<8>, RID>;
+template class BPlusTreeSlotArray<GenericKey<16>, RID>;
+template class BPlusTreeSlotArray<GenericKey<32>, RID>;
+template class BPlusTreeSlotArray<GenericKey<64>, RID>;
+template class BPlusTreeSlotArray<GenericKey<4>, page_id_t>;
+template class BPlusTreeSlotArray<GenericKey<8>, page_id_t>;
+template class BPlusTreeSlotArray<GenericKey<16>, page_id_t>;
+template class BPlusTreeSlotArray<GenericKey<32>, page_id_t>;
+template class BPlusTreeSlotArray<GenericKey<64>, page_id_t>;
+
+}  // namespace bustub
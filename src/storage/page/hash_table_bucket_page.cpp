@@ -10,6 +10,13 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include "storage/page/hash_table_bucket_page.h"
 #include "common/logger.h"
 #include "common/util/hash_util.h"
@@ -19,43 +26,164 @@
 
 namespace bustub {
 
+namespace {
+
+// bit i is set if the fingerprint of slot i of the group matches
+inline auto MatchFingerprints(const uint8_t *fingerprints, uint8_t fingerprint) -> uint32_t {
+  uint32_t matches = 0;
+  for (uint32_t i = 0; i < 32; i++) {
+    matches |= static_cast<uint32_t>(fingerprints[i] == fingerprint) << i;
+  }
+  return matches;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) auto MatchFingerprintsAvx2(const uint8_t *fingerprints, uint8_t fingerprint)
+    -> uint32_t {
+  __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints));
+  __m256i matches = _mm256_cmpeq_epi8(lanes, _mm256_set1_epi8(static_cast<char>(fingerprint)));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+}
+
+const bool HAS_AVX2 = [] {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+}();
+#endif
+
+}  // namespace
+
+/*
+ * Mixes the key a word at a time and keeps the top byte, which the low bits
+ * the directory indexes by do not decide.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::Fingerprint(const KeyType &key) -> uint8_t {
+  auto bytes = reinterpret_cast<const char *>(&key);
+  uint64_t hash = sizeof(KeyType);
+  for (size_t offset = 0; offset < sizeof(KeyType); offset += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, bytes + offset, std::min(sizeof(uint64_t), sizeof(KeyType) - offset));
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15;
+  }
+  return static_cast<uint8_t>(hash >> 56);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::ReadableInGroup(uint32_t group) const -> uint32_t {
+  uint32_t bits;
+  memcpy(&bits, readable_ + group * GROUP_SIZE / 8, sizeof(bits));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  bits = __builtin_bswap32(bits);
+#endif
+  return bits;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::MatchInGroup(uint32_t group, uint8_t fingerprint) const -> uint32_t {
+  uint32_t readable = ReadableInGroup(group);
+  if (readable == 0) {
+    return 0;
+  }
+#if defined(__x86_64__)
+  if (HAS_AVX2) {
+    return MatchFingerprintsAvx2(fingerprints_ + group * GROUP_SIZE, fingerprint) & readable;
+  }
+#endif
+  return MatchFingerprints(fingerprints_ + group * GROUP_SIZE, fingerprint) & readable;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::Init() {
+  overflow_page_id_ = INVALID_PAGE_ID;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::GetOverflowPageId() const -> page_id_t {
+  return overflow_page_id_;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::SetOverflowPageId(page_id_t overflow_page_id) {
+  overflow_page_id_ = overflow_page_id;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool {
   bool flag = false;
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (IsReadable(i) && cmp(key, KeyAt(i)) == 0) {
-      result->push_back(ValueAt(i));
-      flag = true;
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t group = 0; group < NUM_GROUPS; ++group) {
+    for (uint32_t matches = MatchInGroup(group, fingerprint); matches != 0; matches &= matches - 1) {
+      uint32_t i = group * GROUP_SIZE + __builtin_ctz(matches);
+      if (cmp(key, KeyAt(i)) == 0) {
+        result->push_back(ValueAt(i));
+        flag = true;
+      }
     }
   }
   return flag;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool {
-  // for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-  //   if (IsReadable(i) && cmp(key, KeyAt(i)) && value == ValueAt(i)) {
-  //     return false;
-  //   }
-  // }
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    // wtf i dont konw why need occupied array, maybe occupy is not needed.
-    if (!IsReadable(i)) {
-      SetOccupied(i, true);
-      SetReadable(i, true);
-      array_[i] = std::make_pair(key, value);
-      return true;
+void HASH_TABLE_BUCKET_TYPE::GetValues(const KeyType *keys, size_t num_keys, KeyComparator cmp,
+                                       std::vector<ValueType> *const *results) {
+  // the key and the slot of each fingerprint match
+  std::vector<std::pair<size_t, uint32_t>> candidates;
+  for (size_t k = 0; k < num_keys; k++) {
+    uint8_t fingerprint = Fingerprint(keys[k]);
+    for (uint32_t group = 0; group < NUM_GROUPS; ++group) {
+      for (uint32_t matches = MatchInGroup(group, fingerprint); matches != 0; matches &= matches - 1) {
+        uint32_t i = group * GROUP_SIZE + __builtin_ctz(matches);
+        __builtin_prefetch(&array_[i]);
+        candidates.emplace_back(k, i);
+      }
     }
   }
-  return false;
+  for (const auto &[k, i] : candidates) {
+    if (cmp(keys[k], KeyAt(i)) == 0) {
+      results[k]->push_back(ValueAt(i));
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::Prefetch() const {
+  // the flags and the fingerprints are adjacent, and the readable count shares the first line
+  const auto *begin = reinterpret_cast<const char *>(this);
+  const auto *end = reinterpret_cast<const char *>(&fingerprints_[NUM_GROUPS * GROUP_SIZE]);
+  for (const char *line = begin; line < end; line += 64) {
+    __builtin_prefetch(line);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool {
+  if (IsFull()) {
+    return false;
+  }
+  // the first slot that is not readable
+  uint32_t group = 0;
+  while (ReadableInGroup(group) == UINT32_MAX) {
+    group++;
+  }
+  uint32_t i = group * GROUP_SIZE + __builtin_ctz(~ReadableInGroup(group));
+  SetOccupied(i, true);
+  SetReadable(i, true);
+  fingerprints_[i] = Fingerprint(key);
+  array_[i] = std::make_pair(key, value);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool {
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (IsReadable(i) && cmp(key, KeyAt(i)) == 0 && value == ValueAt(i)) {
-      SetReadable(i, false);
-      return true;
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t group = 0; group < NUM_GROUPS; ++group) {
+    for (uint32_t matches = MatchInGroup(group, fingerprint); matches != 0; matches &= matches - 1) {
+      uint32_t i = group * GROUP_SIZE + __builtin_ctz(matches);
+      if (cmp(key, KeyAt(i)) == 0 && value == ValueAt(i)) {
+        SetReadable(i, false);
+        return true;
+      }
     }
   }
   return false;
@@ -73,7 +201,7 @@ auto HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const -> ValueType {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
-  // pass
+  SetReadable(bucket_idx, false);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -102,8 +230,17 @@ auto HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const -> bool {
   return ((byte >> n) & 1) != 0;
 }
 
+// also keeps the count of readable slots
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx, bool flag) {
+  if (IsReadable(bucket_idx) == flag) {
+    return;
+  }
+  if (flag) {
+    num_readable_++;
+  } else {
+    num_readable_--;
+  }
   uint32_t byte_idx = bucket_idx / 8;
   unsigned char byte = readable_[byte_idx];
   uint32_t n = bucket_idx % 8;
@@ -112,53 +249,28 @@ void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx, bool flag) {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsFull() -> bool {
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (!IsReadable(i)) {
-      return false;
-    }
-  }
-  return true;
+  return num_readable_ == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::NumReadable() -> uint32_t {
-  uint32_t count = 0;
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (IsReadable(i)) {
-      count += 1;
-    }
-  }
-  return count;
+  return num_readable_;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsEmpty() -> bool {
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (IsReadable(i)) {
-      return false;
-    }
-  }
-  return true;
+  return num_readable_ == 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::PrintBucket() {
   uint32_t size = 0;
   uint32_t taken = 0;
-  uint32_t free = 0;
-  for (size_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++) {
-    if (!IsOccupied(bucket_idx)) {
-      break;
-    }
-
-    size++;
-
-    if (IsReadable(bucket_idx)) {
-      taken++;
-    } else {
-      free++;
-    }
+  for (uint32_t byte_idx = 0; byte_idx < NUM_GROUPS * GROUP_SIZE / 8; byte_idx++) {
+    size += __builtin_popcount(occupied_[byte_idx]);
+    taken += __builtin_popcount(readable_[byte_idx]);
   }
+  uint32_t free = size - taken;
 
   LOG_INFO("Bucket Capacity: %lu, Size: %u, Taken: %u, Free: %u", BUCKET_ARRAY_SIZE, size, taken, free);
 }
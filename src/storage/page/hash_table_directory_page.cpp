@@ -53,6 +53,12 @@ void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t buck
   bucket_page_ids_[bucket_idx] = bucket_page_id;
 }
 
+auto HashTableDirectoryPage::GetTablePageId(uint32_t table_idx) -> page_id_t { return table_page_ids_[table_idx]; }
+
+void HashTableDirectoryPage::SetTablePageId(uint32_t table_idx, page_id_t table_page_id) {
+  table_page_ids_[table_idx] = table_page_id;
+}
+
 auto HashTableDirectoryPage::Size() -> uint32_t {
   // wtf check out what size means
   return 0;
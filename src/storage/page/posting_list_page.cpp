@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/page/posting_list_page.cpp
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/posting_list_page.h"
+
+#include <cstring>
+
+namespace bustub {
+
+void PostingListPage::Init() {
+  last_rid_ = 0;
+  next_page_id_ = INVALID_PAGE_ID;
+  size_ = 0;
+  bytes_ = 0;
+}
+
+auto PostingListPage::GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+void PostingListPage::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+auto PostingListPage::GetSize() const -> int { return size_; }
+
+auto PostingListPage::GetLastRid() const -> RID { return RID(last_rid_); }
+
+void PostingListPage::GetRids(std::vector<RID> *rids) const {
+  const auto *data = reinterpret_cast<const uint8_t *>(data_);
+  uint64_t rid = 0;
+  for (int i = 0; i < size_; i++) {
+    uint64_t delta = 0;
+    for (int shift = 0;; shift += 7) {
+      delta |= static_cast<uint64_t>(*data & 0x7F) << shift;
+      if ((*data++ & 0x80) == 0) {
+        break;
+      }
+    }
+    rid += delta;
+    rids->emplace_back(static_cast<int64_t>(rid));
+  }
+}
+
+auto PostingListPage::SetRids(const RID *rids, int count) -> int {
+  uint64_t previous = 0;
+  size_ = 0;
+  bytes_ = 0;
+  for (; size_ < count; size_++) {
+    auto rid = static_cast<uint64_t>(rids[size_].Get());
+    if (!PutDelta(rid, previous)) {
+      break;
+    }
+    previous = rid;
+  }
+  last_rid_ = static_cast<int64_t>(previous);
+  return size_;
+}
+
+auto PostingListPage::Append(const RID &rid) -> bool {
+  if (!PutDelta(static_cast<uint64_t>(rid.Get()), size_ == 0 ? 0 : static_cast<uint64_t>(last_rid_))) {
+    return false;
+  }
+  size_++;
+  last_rid_ = rid.Get();
+  return true;
+}
+
+/*
+ * A delta takes at most 10 bytes, it is assembled aside so that one that
+ * would run past the page is not written at all
+ */
+auto PostingListPage::PutDelta(uint64_t rid, uint64_t previous) -> bool {
+  uint64_t delta = rid - previous;
+  uint8_t bytes[10];
+  uint32_t length = 0;
+  do {
+    bytes[length++] = static_cast<uint8_t>((delta & 0x7F) | (delta >= 0x80 ? 0x80 : 0));
+    delta >>= 7;
+  } while (delta != 0);
+  if (POSTING_LIST_PAGE_HEADER_SIZE + bytes_ + length > PAGE_SIZE) {
+    return false;
+  }
+  memcpy(data_ + bytes_, bytes, length);
+  bytes_ += length;
+  return true;
+}
+
+}  // namespace bustub
@@ -172,8 +172,16 @@ auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
     } else if (!txn->IsExclusiveLocked(rid) && !lock_manager->LockExclusive(txn, rid)) {
       return false;
     }
-    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple, new_tuple);
-    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    lsn_t lsn;
+    if (old_tuple->size_ == new_tuple.size_) {
+      // Same-sized updates (e.g. fixed-width columns) only log the bytes they change.
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), rid, *old_tuple, new_tuple);
+      lsn = log_manager->AppendLogRecord(&log_record);
+    } else {
+      LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::UPDATE, rid, *old_tuple,
+                           new_tuple);
+      lsn = log_manager->AppendLogRecord(&log_record);
+    }
     SetLSN(lsn);
     txn->SetPrevLSN(lsn);
   }
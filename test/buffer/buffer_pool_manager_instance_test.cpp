@@ -14,6 +14,8 @@
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +143,99 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto is_resident = [&](page_id_t page_id) {
+    Page *pages = bpm->GetPages();
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      if (pages[i].GetPageId() == page_id) {
+        return pages[i].GetPinCount() == 0;
+      }
+    }
+    return false;
+  };
+
+  // Scenario: Pages {0, ..., 9} are written out when pages {10, ..., 19} take over the buffer pool.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_FALSE(is_resident(0));
+
+  // Scenario: Prefetched pages are read in, but left unpinned.
+  bpm->PrefetchPages({0, 1, 2, 15});
+  EXPECT_TRUE(is_resident(0));
+  EXPECT_TRUE(is_resident(1));
+  EXPECT_TRUE(is_resident(2));
+  EXPECT_TRUE(is_resident(15));
+  auto *page0 = bpm->FetchPage(0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "page 0"));
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  // Scenario: Prefetching never takes a frame that is pinned.
+  for (page_id_t page_id = 10; page_id < 19; ++page_id) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+  }
+  bpm->PrefetchPages({5});
+  EXPECT_FALSE(is_resident(5));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// pages are read without the buffer pool latch, a fetch of a page that is still being read waits for it
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentPrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 20;
+  const int num_pages = 100;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::thread prefetcher([&] {
+    for (int round = 0; round < 5; round++) {
+      std::vector<page_id_t> page_ids;
+      for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+        page_ids.push_back(page_id);
+      }
+      bpm->PrefetchPages(page_ids);
+    }
+  });
+  std::mt19937 rng(15445);
+  for (int i = 0; i < 2000; ++i) {
+    page_id_t page_id = static_cast<page_id_t>(rng() % num_pages);
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::string("page ") + std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, i % 3 == 0));
+  }
+  prefetcher.join();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
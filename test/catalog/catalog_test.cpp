@@ -148,7 +148,8 @@ TEST(CatalogTest, DISABLED_CreateTableTest) {
 
   // Basic empty table attributes
   {
-    EXPECT_EQ(table_metadata->table_->GetFirstPageId(), 0);
+    // page 0 is the header page
+    EXPECT_EQ(table_metadata->table_->GetFirstPageId(), 1);
     EXPECT_EQ(table_metadata->name_, table_name);
     EXPECT_EQ(table_metadata->schema_.GetColumnCount(), columns.size());
     for (std::size_t i = 0; i < columns.size(); ++i) {
@@ -688,4 +689,116 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// A B-epsilon tree index picks up the tuples already in the table and keeps up with later changes
+TEST(CatalogTest, BEpsilonTreeIndexTest) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  const std::string table_name{"foobar"};
+  const std::string index_name{"index1"};
+
+  std::vector<Column> columns{{"A", TypeId::BIGINT}, {"B", TypeId::INTEGER}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(txn.get(), table_name, table_schema);
+  EXPECT_NE(Catalog::NULL_TABLE_INFO, table_info);
+
+  // Fill the table before the index exists
+  std::vector<RID> rids;
+  for (int64_t i = 0; i < 100; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(i), ValueFactory::GetIntegerValue(0)}, &table_schema};
+    RID rid{};
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+    rids.push_back(rid);
+  }
+
+  std::vector<Column> key_columns{{"A", TypeId::BIGINT}};
+  std::vector<uint32_t> key_attrs{0};
+  Schema key_schema{key_columns};
+  auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, BIGINT_SIZE, BigintHashFunctionType{},
+      true, {}, IndexType::B_EPSILON_TREE);
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  auto *index = index_info->index_.get();
+  EXPECT_NE(nullptr, (dynamic_cast<BEpsilonTreeIndex<BigintKeyType, BigintValueType, BigintComparatorType> *>(index)));
+
+  auto key_of = [&](int64_t a) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(a), ValueFactory::GetIntegerValue(0)}, &table_schema};
+    return tuple.KeyFromTuple(table_schema, *index->GetKeySchema(), index->GetKeyAttrs());
+  };
+
+  // Every tuple of the table is found through the index
+  std::vector<RID> results{};
+  for (int64_t i = 0; i < 100; i++) {
+    results.clear();
+    index->ScanKey(key_of(i), &results, txn.get());
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ(rids[i], results[0]);
+  }
+
+  // Entries inserted and deleted through the index
+  RID rid{1000, 0};
+  index->InsertEntry(key_of(1000), rid, txn.get());
+  index->DeleteEntry(key_of(0), rids[0], txn.get());
+  results.clear();
+  index->ScanKey(key_of(1000), &results, txn.get());
+  ASSERT_EQ(1, results.size());
+  EXPECT_EQ(rid, results[0]);
+  results.clear();
+  index->ScanKey(key_of(0), &results, txn.get());
+  EXPECT_TRUE(results.empty());
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
+// A catalog on a database that is opened again keeps its header page, and the indexes recorded there can be opened
+TEST(CatalogTest, ReopenTest) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  std::vector<Column> columns{{"A", TypeId::BIGINT}, {"B", TypeId::INTEGER}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(txn.get(), "foobar", table_schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, table_info);
+  std::vector<Column> key_columns{{"A", TypeId::BIGINT}};
+  Schema key_schema{key_columns};
+  auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+      txn.get(), "index1", "foobar", table_schema, key_schema, {0}, BIGINT_SIZE, BigintHashFunctionType{});
+  ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  auto key_of = [&](int64_t a) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(a), ValueFactory::GetIntegerValue(0)}, &table_schema};
+    return tuple.KeyFromTuple(table_schema, key_schema, {0});
+  };
+  for (int64_t i = 0; i < 1000; i++) {
+    index_info->index_->InsertEntry(key_of(i), RID{static_cast<page_id_t>(i), 0}, txn.get());
+  }
+  bpm->FlushAllPages();
+  catalog.reset();
+  bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+
+  page_id_t directory_page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  EXPECT_TRUE(header_page->GetRootId("index1", &directory_page_id));
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+
+  ExtendibleHashTableIndex<BigintKeyType, BigintValueType, BigintComparatorType> index(
+      std::make_unique<IndexMetadata>("index1", "foobar", &table_schema, std::vector<uint32_t>{0}), bpm.get(),
+      BigintHashFunctionType{}, true);
+  std::vector<RID> results{};
+  for (int64_t i = 0; i < 1000; i++) {
+    results.clear();
+    index.ScanKey(key_of(i), &results, txn.get());
+    ASSERT_EQ(1, results.size());
+    EXPECT_EQ(RID(static_cast<page_id_t>(i), 0), results[0]);
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
 }  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_util_test.cpp
+//
+// Identification: test/common/hash_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// every length reads a different set of bytes, so changing any one byte has to change the hash
+TEST(HashUtilTest, HashBytesTest) {
+  std::string bytes(100, 'a');
+  std::unordered_set<hash_t> hashes;
+  for (size_t length = 0; length <= bytes.size(); length++) {
+    hash_t hash = HashUtil::HashBytes(bytes.data(), length);
+    EXPECT_EQ(hash, HashUtil::HashBytes(bytes.data(), length));
+    EXPECT_TRUE(hashes.insert(hash).second) << length;
+    for (size_t i = 0; i < length; i++) {
+      bytes[i] = 'b';
+      EXPECT_NE(hash, HashUtil::HashBytes(bytes.data(), length)) << length << " " << i;
+      bytes[i] = 'a';
+    }
+  }
+
+  for (uint64_t word : {0ULL, 1ULL, 0x123456789abcdefULL, ~0ULL}) {
+    EXPECT_EQ(HashUtil::HashBytes(reinterpret_cast<const char *>(&word), sizeof(word)), HashUtil::HashWord(word));
+  }
+  EXPECT_NE(HashUtil::CombineHashes(1, 2), HashUtil::CombineHashes(2, 1));
+}
+
+// a column hashes the same as its values one by one, including columns that are not all of one type
+TEST(HashUtilTest, HashValuesTest) {
+  std::vector<std::vector<Value>> columns(4);
+  for (int i = 0; i < 200; i++) {
+    columns[0].push_back(ValueFactory::GetIntegerValue(i * 7919 - 1000));
+    columns[1].push_back(ValueFactory::GetDecimalValue(i * 0.5));
+    columns[2].push_back(ValueFactory::GetVarcharValue(std::to_string(i)));
+    columns[3].push_back(i % 3 == 0 ? ValueFactory::GetBigIntValue(i) : ValueFactory::GetBooleanValue(i % 2 == 0));
+  }
+  for (const auto &column : columns) {
+    std::vector<hash_t> hashes(column.size());
+    HashUtil::HashValues(column.data(), column.size(), hashes.data());
+    std::unordered_set<hash_t> distinct;
+    for (size_t i = 0; i < column.size(); i++) {
+      EXPECT_EQ(HashUtil::HashValue(&column[i]), hashes[i]) << i;
+      distinct.insert(hashes[i]);
+    }
+    EXPECT_GT(distinct.size(), 2);
+  }
+
+  // integers that compare equal hash alike whatever their width
+  Value tiny = ValueFactory::GetTinyIntValue(-5);
+  Value small = ValueFactory::GetSmallIntValue(-5);
+  Value integer = ValueFactory::GetIntegerValue(-5);
+  Value big = ValueFactory::GetBigIntValue(-5);
+  EXPECT_EQ(HashUtil::HashValue(&tiny), HashUtil::HashValue(&big));
+  EXPECT_EQ(HashUtil::HashValue(&small), HashUtil::HashValue(&big));
+  EXPECT_EQ(HashUtil::HashValue(&integer), HashUtil::HashValue(&big));
+}
+
+}  // namespace bustub
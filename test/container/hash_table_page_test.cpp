@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -19,6 +21,7 @@
 #include "storage/disk/disk_manager.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
@@ -117,4 +120,73 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   delete bpm;
 }
 
+// a full bucket of generic keys, some of them with several values, that is emptied and filled again
+TEST(HashTablePageTest, BucketPageFullTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  using BucketPage = HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+  const auto capacity = static_cast<int64_t>(4 * (PAGE_SIZE - 64) / (4 * sizeof(std::pair<GenericKey<8>, RID>) + 5));
+  std::vector<char> data(PAGE_SIZE);
+  auto bucket_page = reinterpret_cast<BucketPage *>(data.data());
+
+  // key i has the values (i, 0) up to (i, i % 3)
+  GenericKey<8> key;
+  int64_t num_values = 0;
+  for (int64_t i = 0; num_values < capacity; i++) {
+    key.SetFromInteger(i);
+    for (int64_t j = 0; j <= i % 3 && num_values < capacity; j++, num_values++) {
+      ASSERT_TRUE(bucket_page->Insert(key, RID(i, j), comparator));
+    }
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_EQ(bucket_page->NumReadable(), capacity);
+  key.SetFromInteger(-1);
+  EXPECT_FALSE(bucket_page->Insert(key, RID(0, 0), comparator));
+
+  auto check = [&](int64_t removed_below) {
+    int64_t remaining = 0;
+    for (int64_t i = 0, count = 0; count < capacity; i++) {
+      std::vector<RID> result;
+      key.SetFromInteger(i);
+      int64_t values = std::min(i % 3 + 1, capacity - count);
+      count += values;
+      EXPECT_EQ(bucket_page->GetValue(key, comparator, &result), i >= removed_below) << i;
+      ASSERT_EQ(result.size(), i >= removed_below ? values : 0) << i;
+      for (const auto &rid : result) {
+        EXPECT_EQ(rid.GetPageId(), i);
+      }
+      remaining += result.size();
+    }
+    EXPECT_EQ(bucket_page->NumReadable(), remaining);
+    std::vector<RID> result;
+    key.SetFromInteger(capacity);
+    EXPECT_FALSE(bucket_page->GetValue(key, comparator, &result));
+  };
+  check(0);
+
+  // remove every value of the first keys, half the bucket
+  int64_t removed = 0;
+  int64_t removed_below = 0;
+  for (; removed < capacity / 2; removed_below++) {
+    key.SetFromInteger(removed_below);
+    for (int64_t j = 0; j <= removed_below % 3; j++, removed++) {
+      ASSERT_TRUE(bucket_page->Remove(key, RID(removed_below, j), comparator));
+      EXPECT_FALSE(bucket_page->Remove(key, RID(removed_below, j), comparator));
+    }
+  }
+  EXPECT_FALSE(bucket_page->IsFull());
+  EXPECT_FALSE(bucket_page->IsEmpty());
+  check(removed_below);
+
+  // the freed slots are taken again
+  key.SetFromInteger(-1);
+  for (int64_t i = 0; i < removed; i++) {
+    ASSERT_TRUE(bucket_page->Insert(key, RID(-1, i), comparator));
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  std::vector<RID> result;
+  EXPECT_TRUE(bucket_page->GetValue(key, comparator, &result));
+  EXPECT_EQ(result.size(), removed);
+}
+
 }  // namespace bustub
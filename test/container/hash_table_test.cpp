@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -27,7 +29,11 @@ namespace bustub {
 TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
-  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  // create the header page
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
 
   int batch = 496*2;
   for (int i = 0; i < batch; ++i) {
@@ -190,4 +196,264 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// writers insert their own keys, enough to split buckets while the others insert into them, and remove every other
+// one again, so that buckets merge too; readers only ever see a key with its value
+TEST(HashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create the header page
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+
+  const int num_threads = 4;
+  const int keys_per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, i * num_threads + thread, i));
+        if (i % 2 == 1) {
+          EXPECT_TRUE(ht.Remove(nullptr, (i - 1) * num_threads + thread, i - 1));
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      for (int key = 0; key < keys_per_thread * num_threads; key += 3) {
+        std::vector<int> res;
+        if (ht.GetValue(nullptr, key, &res)) {
+          EXPECT_EQ(1, res.size());
+          EXPECT_EQ(key / num_threads, res[0]);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int key = 0; key < keys_per_thread * num_threads; key++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    if (key / num_threads % 2 == 1) {
+      ASSERT_EQ(1, res.size()) << key;
+      EXPECT_EQ(key / num_threads, res[0]);
+    } else {
+      EXPECT_EQ(0, res.size()) << key;
+    }
+  }
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// more buckets than a directory page has slots, so that the directory grows into segments and shrinks back
+TEST(HashTableTest, LargeDirectoryTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(200, disk_manager);
+  // create the header page
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+
+  const int num_keys = 300000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+  }
+  EXPECT_GT(ht.GetGlobalDepth(), 9);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << i;
+  }
+  EXPECT_EQ(ht.GetGlobalDepth(), 0);
+  ht.VerifyIntegrity();
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// many values of one key go into overflow pages instead of splitting the directory up to its maximum depth
+TEST(HashTableTest, OverflowChainTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create the header page
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+
+  // the skewed key first, so that the buckets the other keys split are chains already
+  const int num_values = 5000;
+  const int num_keys = 2000;
+  for (int i = 0; i < num_values; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, -1, i)) << i;
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, -1, 0));
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+  }
+  EXPECT_LE(ht.GetGlobalDepth(), 5);
+  ht.VerifyIntegrity();
+
+  std::vector<int> res;
+  ht.GetValue(nullptr, -1, &res);
+  ASSERT_EQ(num_values, res.size());
+  std::sort(res.begin(), res.end());
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_EQ(i, res[i]);
+  }
+  for (int i = 0; i < num_keys; i++) {
+    res.clear();
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << i;
+  }
+
+  // remove from the front and the back of the chain, so that the pages left over get folded together
+  for (int i = 0; i < num_values / 2; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, -1, i)) << i;
+    ASSERT_TRUE(ht.Remove(nullptr, -1, num_values - 1 - i)) << i;
+    EXPECT_FALSE(ht.Remove(nullptr, -1, i)) << i;
+    if (i % 500 == 0) {
+      res.clear();
+      ht.GetValue(nullptr, -1, &res);
+      ASSERT_EQ(num_values - 2 * (i + 1), res.size()) << i;
+    }
+  }
+  res.clear();
+  EXPECT_FALSE(ht.GetValue(nullptr, -1, &res));
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << i;
+  }
+  EXPECT_EQ(ht.GetGlobalDepth(), 0);
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// batched lookups of keys in random order, with repeated and missing keys and a key whose values fill a chain, give
+// the same values as one lookup per key
+TEST(HashTableTest, GetValuesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+  }
+  for (int i = 1; i < 1000; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, 0, -i)) << i;
+  }
+
+  std::vector<int> keys;
+  for (int i = -100; i < num_keys + 100; i++) {
+    keys.push_back(i);
+    if (i % 10 == 0) {
+      keys.push_back(i);
+    }
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  std::vector<std::vector<int>> results;
+  ht.GetValues(nullptr, keys, &results);
+  ASSERT_EQ(keys.size(), results.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> expected;
+    ht.GetValue(nullptr, keys[i], &expected);
+    std::sort(expected.begin(), expected.end());
+    std::sort(results[i].begin(), results[i].end());
+    ASSERT_EQ(expected, results[i]) << keys[i];
+  }
+  EXPECT_EQ(1000, results[std::find(keys.begin(), keys.end(), 0) - keys.begin()].size());
+
+  ht.GetValues(nullptr, {}, &results);
+  EXPECT_TRUE(results.empty());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// a table written to disk is opened by another buffer pool under the name it has in the header page, and grows there
+TEST(HashTableTest, ReopenTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+
+  const int num_keys = 5000;
+  uint32_t global_depth;
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+    }
+    global_depth = ht.GetGlobalDepth();
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // the new buffer pool allocates after the pages in the file, so the splits do not overwrite any of them
+  bpm = new BufferPoolManagerInstance(50, disk_manager);
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true, true);
+    EXPECT_EQ(global_depth, ht.GetGlobalDepth());
+    ht.VerifyIntegrity();
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      ASSERT_EQ(1, res.size()) << i;
+      EXPECT_EQ(i, res[0]);
+    }
+    for (int i = num_keys; i < 4 * num_keys; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+    }
+    EXPECT_GT(ht.GetGlobalDepth(), global_depth);
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true, true);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < 4 * num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << i;
+    EXPECT_EQ(i, res[0]);
+  }
+  for (int i = 0; i < 4 * num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << i;
+  }
+  EXPECT_EQ(ht.GetGlobalDepth(), 0);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,162 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  // insert a few values, and a second value for every other key
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+    if (i % 2 == 0) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i + 1));
+    }
+  }
+  for (int i = 0; i < 5; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    EXPECT_EQ(i % 2 == 0 ? 2 : 1, res.size()) << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // remove them again, leaving tombstones that later keys probe past
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 0, ht.GetValue(nullptr, i, &res));
+    if (i % 2 == 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, 2 * i + 1));
+    }
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// a table of one block that has to grow many times, with every key checked while pairs are moved between tables, and
+// then removes and inserts of new keys, which rebuild the table to clear the tombstones
+TEST(LinearProbeHashTableTest, ResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1, HashFunction<int>());
+  size_t initial_size = ht.GetSize();
+
+  const int num_keys = 50000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << i;
+    if (i % 1000 == 0) {
+      for (int j = 0; j <= i; j += 7) {
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, j, &res)) << j;
+        ASSERT_EQ(1, res.size());
+        EXPECT_EQ(j, res[0]);
+      }
+    }
+  }
+  EXPECT_GE(ht.GetSize(), num_keys);
+  EXPECT_FALSE(ht.Insert(nullptr, 0, 0));
+
+  for (int round = 1; round <= 3; round++) {
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Remove(nullptr, (round - 1) * num_keys + i, (round - 1) * num_keys + i)) << i;
+      ASSERT_TRUE(ht.Insert(nullptr, round * num_keys + i, round * num_keys + i)) << i;
+    }
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      EXPECT_FALSE(ht.GetValue(nullptr, (round - 1) * num_keys + i, &res)) << i;
+      ASSERT_TRUE(ht.GetValue(nullptr, round * num_keys + i, &res)) << i;
+      ASSERT_EQ(1, res.size());
+    }
+  }
+
+  // an explicit resize moves the pairs like any other
+  ht.Resize(4 * num_keys);
+  EXPECT_GE(ht.GetSize(), 8 * num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, 3 * num_keys + i, 3 * num_keys + i)) << i;
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// writers insert their own keys, enough to resize the table while the others insert into it, and remove every other
+// one again; readers only ever see a key with its value
+TEST(LinearProbeHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1, HashFunction<int>());
+
+  const int num_threads = 4;
+  const int keys_per_thread = 5000;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, i * num_threads + thread, i));
+        if (i % 2 == 1) {
+          EXPECT_TRUE(ht.Remove(nullptr, (i - 1) * num_threads + thread, i - 1));
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      for (int key = 0; key < keys_per_thread * num_threads; key += 3) {
+        std::vector<int> res;
+        if (ht.GetValue(nullptr, key, &res)) {
+          EXPECT_EQ(1, res.size());
+          EXPECT_EQ(key / num_threads, res[0]);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int key = 0; key < keys_per_thread * num_threads; key++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    if (key / num_threads % 2 == 1) {
+      ASSERT_EQ(1, res.size()) << key;
+      EXPECT_EQ(key / num_threads, res[0]);
+    } else {
+      EXPECT_EQ(0, res.size()) << key;
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
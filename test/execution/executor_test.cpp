@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <string>
@@ -31,6 +32,7 @@
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
@@ -329,6 +331,53 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
   }
 }
 
+// SELECT colA, colB FROM test_1 WHERE colA < 500, through an index on colA that includes colB
+TEST_F(ExecutorTest, SimpleIndexOnlyScanTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a integer");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "covering_index", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{}, true, {1});
+  ASSERT_TRUE(index_info->index_->GetMetadata()->IsCovering());
+
+  // a row inserted after the index was built is covered as well
+  std::vector<std::vector<Value>> raw_vals{{ValueFactory::GetIntegerValue(-1), ValueFactory::GetIntegerValue(7),
+                                            ValueFactory::GetIntegerValue(0), ValueFactory::GetIntegerValue(0)}};
+  InsertPlanNode insert_plan{std::move(raw_vals), table_info->oid_};
+  GetExecutionEngine()->Execute(&insert_plan, nullptr, GetTxn(), GetExecutorContext());
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto col_c = MakeColumnValueExpression(schema, 0, "colC");
+  auto const500 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(500));
+  auto predicate = MakeComparisonExpression(col_a, const500, ComparisonType::LessThan);
+  auto all_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}, {"colC", col_c}});
+  SeqScanPlanNode seq_scan_plan{all_schema, predicate, table_info->oid_};
+  std::vector<Tuple> expected;
+  GetExecutionEngine()->Execute(&seq_scan_plan, &expected, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(expected.size(), 501);
+  std::sort(expected.begin(), expected.end(), [all_schema](const Tuple &lhs, const Tuple &rhs) {
+    return lhs.GetValue(all_schema, 0).GetAs<int32_t>() < rhs.GetValue(all_schema, 0).GetAs<int32_t>();
+  });
+
+  // colA and colB are read from the index alone, colC from the table, in either direction
+  for (bool descending : {false, true}) {
+    for (const auto &column : {"colB", "colC"}) {
+      auto out_schema = MakeOutputSchema({{"colA", col_a}, {column, column[3] == 'B' ? col_b : col_c}});
+      IndexScanPlanNode index_scan_plan{out_schema, predicate, index_info->index_oid_, descending};
+      std::vector<Tuple> result_set;
+      GetExecutionEngine()->Execute(&index_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+      ASSERT_EQ(result_set.size(), expected.size());
+      for (size_t i = 0; i < result_set.size(); i++) {
+        const auto &row = expected[descending ? expected.size() - 1 - i : i];
+        ASSERT_EQ(result_set[i].GetValue(out_schema, 0).GetAs<int32_t>(), row.GetValue(all_schema, 0).GetAs<int32_t>());
+        ASSERT_EQ(result_set[i].GetValue(out_schema, 1).GetAs<int32_t>(),
+                  row.GetValue(all_schema, all_schema->GetColIdx(column)).GetAs<int32_t>());
+      }
+    }
+  }
+}
+
 // DELETE FROM test_1 WHERE col_a == 50;
 TEST_F(ExecutorTest, SimpleDeleteTest) {
   // Construct query plan
@@ -378,6 +427,44 @@ TEST_F(ExecutorTest, SimpleDeleteTest) {
   ASSERT_TRUE(rids.empty());
 }
 
+// DELETE FROM test_1 WHERE colA < 500, then DELETE FROM test_1, both through an index scan on colA
+TEST_F(ExecutorTest, DeleteThroughIndexScanTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a integer");
+  auto *index_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{}, true, {}, IndexType::B_PLUS_TREE);
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto const500 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(500));
+  auto predicate = MakeComparisonExpression(col_a, const500, ComparisonType::LessThan);
+  auto out_schema = MakeOutputSchema({{"colA", col_a}});
+
+  // the scans return more rows than fit in a batch, so the deletes change the leaves the scans are parked on
+  IndexScanPlanNode ascending_scan_plan{out_schema, predicate, index_info->index_oid_, false};
+  DeletePlanNode ascending_delete_plan{&ascending_scan_plan, table_info->oid_};
+  GetExecutionEngine()->Execute(&ascending_delete_plan, nullptr, GetTxn(), GetExecutorContext());
+
+  SeqScanPlanNode seq_scan_plan{out_schema, nullptr, table_info->oid_};
+  std::vector<Tuple> result_set;
+  GetExecutionEngine()->Execute(&seq_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST1_SIZE - 500);
+  for (const auto &tuple : result_set) {
+    ASSERT_GE(tuple.GetValue(out_schema, 0).GetAs<int32_t>(), 500);
+  }
+
+  IndexScanPlanNode descending_scan_plan{out_schema, nullptr, index_info->index_oid_, true};
+  DeletePlanNode descending_delete_plan{&descending_scan_plan, table_info->oid_};
+  GetExecutionEngine()->Execute(&descending_delete_plan, nullptr, GetTxn(), GetExecutorContext());
+
+  result_set.clear();
+  GetExecutionEngine()->Execute(&seq_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_TRUE(result_set.empty());
+  result_set.clear();
+  GetExecutionEngine()->Execute(&ascending_scan_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_TRUE(result_set.empty());
+}
+
 // SELECT test_1.col_a, test_1.col_b, test_2.col1, test_2.col3 sFROM test_1 JOIN test_2 ON test_1.col_a = test_2.col1; pass
 TEST_F(ExecutorTest, SimpleNestedLoopJoinTest) {
   const Schema *out_schema1;
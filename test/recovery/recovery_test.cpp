@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/bustub_instance.h"
@@ -23,6 +24,7 @@
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -31,14 +33,16 @@ class RecoveryTest : public ::testing::Test {
   // This function is called before every test.
   void SetUp() override {
     remove("test.db");
-    remove("test.log");
+    remove("test.log.0");
+    remove("test.master");
   }
 
   // This function is called after every test.
   void TearDown() override {
     LOG_INFO("Tearing down the system..");
     remove("test.db");
-    remove("test.log");
+    remove("test.log.0");
+    remove("test.master");
   };
 };
 
@@ -314,4 +318,410 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, FuzzyCheckpointTest) {
+  BustubInstance *bustub_instance = new BustubInstance("test.db");
+
+  ASSERT_FALSE(enable_logging);
+  bustub_instance->log_manager_->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+  LOG_INFO("System logging thread running...");
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+  auto val_0 = tuple.GetValue(&schema, 0);
+
+  RID checkpointed_rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &checkpointed_rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  // a transaction that is still running while the checkpoint is taken
+  Transaction *loser_txn = bustub_instance->transaction_manager_->Begin();
+  RID loser_rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &loser_rid, loser_txn));
+
+  LOG_INFO("Fuzzy checkpoint without blocking transactions");
+  bustub_instance->checkpoint_manager_->FuzzyCheckpoint();
+  bustub_instance->checkpoint_manager_->WaitForBackgroundFlush();
+
+  // the background flush must have cleaned every page that was dirty at checkpoint time
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table;
+  bustub_instance->buffer_pool_manager_->GetDirtyPageTable(&dirty_page_table);
+  EXPECT_TRUE(dirty_page_table.empty());
+
+  // committed after the checkpoint, only in the log
+  Transaction *winner_txn = bustub_instance->transaction_manager_->Begin();
+  RID winner_rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &winner_rid, winner_txn));
+  bustub_instance->transaction_manager_->Commit(winner_txn);
+  delete winner_txn;
+
+  LOG_INFO("System crash before loser txn commits");
+  delete loser_txn;
+  delete test_table;
+  delete bustub_instance;
+
+  bustub_instance = new BustubInstance("test.db");
+  ASSERT_FALSE(enable_logging);
+  log_offset_t checkpoint_offset;
+  ASSERT_TRUE(bustub_instance->disk_manager_->ReadMasterRecord(&checkpoint_offset));
+  EXPECT_GT(checkpoint_offset, 0);
+
+  LOG_INFO("Recovery started..");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+
+  Tuple old_tuple;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  ASSERT_TRUE(test_table->GetTuple(checkpointed_rid, &old_tuple, txn));
+  EXPECT_EQ(old_tuple.GetValue(&schema, 0).CompareEquals(val_0), CmpBool::CmpTrue);
+  ASSERT_TRUE(test_table->GetTuple(winner_rid, &old_tuple, txn));
+  EXPECT_EQ(old_tuple.GetValue(&schema, 0).CompareEquals(val_0), CmpBool::CmpTrue);
+  EXPECT_FALSE(test_table->GetTuple(loser_rid, &old_tuple, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+
+  delete txn;
+  delete test_table;
+  delete log_recovery;
+  delete bustub_instance;
+}
+
+// two losers whose changes are interleaved, recovered three times: later recoveries find the CLRs and ABORT records
+// of the first one, redo the CLRs onto the page the first one did not write back, and must not revert anything again
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, RepeatedRecoveryTest) {
+  BustubInstance *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID committed_rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &committed_rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  Transaction *loser_txn1 = bustub_instance->transaction_manager_->Begin();
+  Transaction *loser_txn2 = bustub_instance->transaction_manager_->Begin();
+  RID loser_rid1;
+  RID loser_rid2;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &loser_rid1, loser_txn1));
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &loser_rid2, loser_txn2));
+  ASSERT_TRUE(test_table->MarkDelete(committed_rid, loser_txn1));
+  // the page reaches the disk with the changes of both losers
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+
+  LOG_INFO("System crash before the losers commit");
+  delete loser_txn1;
+  delete loser_txn2;
+  delete test_table;
+  delete bustub_instance;
+
+  for (int recovery = 0; recovery < 3; recovery++) {
+    bustub_instance = new BustubInstance("test.db");
+    auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                         bustub_instance->log_manager_);
+    log_recovery->Redo();
+    log_recovery->Undo();
+
+    Tuple old_tuple;
+    txn = bustub_instance->transaction_manager_->Begin();
+    test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                               bustub_instance->log_manager_, first_page_id);
+    EXPECT_TRUE(test_table->GetTuple(committed_rid, &old_tuple, txn)) << recovery;
+    EXPECT_FALSE(test_table->GetTuple(loser_rid1, &old_tuple, txn)) << recovery;
+    EXPECT_FALSE(test_table->GetTuple(loser_rid2, &old_tuple, txn)) << recovery;
+    bustub_instance->transaction_manager_->Commit(txn);
+
+    LOG_INFO("System crash after recovery");
+    if (recovery > 0) {
+      bustub_instance->buffer_pool_manager_->FlushPage(first_page_id);
+    }
+    delete txn;
+    delete test_table;
+    delete log_recovery;
+    delete bustub_instance;
+  }
+}
+
+// a page that stays in the buffer pool while clean gets the recLSN of whoever dirties it, not of when it was loaded
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, RecLSNTest) {
+  BustubInstance *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  auto *bpm = bustub_instance->buffer_pool_manager_;
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bpm, bustub_instance->lock_manager_, bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  bpm->FlushPage(first_page_id);
+
+  // read and let go of while clean, then the log moves on without the page
+  ASSERT_NE(nullptr, bpm->FetchPage(first_page_id));
+  ASSERT_TRUE(bpm->UnpinPage(first_page_id, false));
+  for (int i = 0; i < 10; i++) {
+    txn = bustub_instance->transaction_manager_->Begin();
+    bustub_instance->transaction_manager_->Commit(txn);
+    delete txn;
+  }
+  lsn_t first_change_lsn = bustub_instance->log_manager_->GetNextLSN();
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  ASSERT_TRUE(test_table->MarkDelete(rid, txn));
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_page_table;
+  bpm->GetDirtyPageTable(&dirty_page_table);
+  ASSERT_EQ(1, dirty_page_table.size());
+  EXPECT_EQ(first_page_id, dirty_page_table[0].first);
+  EXPECT_GE(dirty_page_table[0].second, first_change_lsn);
+  EXPECT_LE(dirty_page_table[0].second, txn->GetPrevLSN());
+  bustub_instance->transaction_manager_->Commit(txn);
+
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, DeltaUpdateTest) {
+  BustubInstance *bustub_instance = new BustubInstance("test.db");
+
+  ASSERT_FALSE(enable_logging);
+  bustub_instance->log_manager_->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  Column col3{"c", TypeId::VARCHAR, 64};
+  std::vector<Column> cols{col1, col2, col3};
+  Schema schema{cols};
+  std::string padding(48, 'x');
+  const Tuple tuple{{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(2),
+                     ValueFactory::GetVarcharValue(padding)},
+                    &schema};
+  const Tuple committed_tuple{{ValueFactory::GetIntegerValue(10), ValueFactory::GetIntegerValue(2),
+                               ValueFactory::GetVarcharValue(padding)},
+                              &schema};
+  const Tuple loser_tuple{{ValueFactory::GetIntegerValue(10), ValueFactory::GetIntegerValue(20),
+                           ValueFactory::GetVarcharValue(padding)},
+                          &schema};
+
+  // changing one integer of a wide row only logs a few bytes
+  RID dummy_rid;
+  LogRecord full_record(0, INVALID_LSN, LogRecordType::UPDATE, dummy_rid, tuple, committed_tuple);
+  LogRecord delta_record(0, INVALID_LSN, dummy_rid, tuple, committed_tuple);
+  EXPECT_EQ(delta_record.GetDeltaRanges().size(), 1);
+  EXPECT_LT(delta_record.GetSize() * 4, full_record.GetSize());
+
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  bustub_instance->buffer_pool_manager_->FlushPage(first_page_id);
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  ASSERT_TRUE(test_table->UpdateTuple(committed_tuple, rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  ASSERT_TRUE(test_table->UpdateTuple(loser_tuple, rid, txn));
+  // both updates only reach the disk through the log, redo replays them and undo reverts the second one
+  bustub_instance->log_manager_->Flush(true);
+
+  LOG_INFO("System crash before commit");
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+
+  Tuple old_tuple;
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  ASSERT_TRUE(test_table->GetTuple(rid, &old_tuple, txn));
+  EXPECT_EQ(old_tuple.GetValue(&schema, 0).GetAs<int32_t>(), 10);
+  EXPECT_EQ(old_tuple.GetValue(&schema, 1).GetAs<int32_t>(), 2);
+  EXPECT_EQ(old_tuple.GetValue(&schema, 2).CompareEquals(ValueFactory::GetVarcharValue(padding)), CmpBool::CmpTrue);
+  bustub_instance->transaction_manager_->Commit(txn);
+
+  delete txn;
+  delete test_table;
+  delete log_recovery;
+  delete bustub_instance;
+}
+// a delta update whose range claims more bytes than the record holds ends the log instead of being read past its end
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, CorruptDeltaUpdateTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  auto *log_manager = new LogManager(disk_manager);
+
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple{{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(2)}, &schema};
+  const Tuple new_tuple{{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(3)}, &schema};
+
+  LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+  log_manager->AppendLogRecord(&begin_record);
+  LogRecord delta_record(0, begin_record.GetLSN(), RID(0, 0), tuple, new_tuple);
+  log_manager->AppendLogRecord(&delta_record);
+  ASSERT_EQ(1, delta_record.GetDeltaRanges().size());
+  size_t length = delta_record.GetDeltaRanges()[0].old_bytes_.size();
+  ASSERT_LT(length, 0x40);
+
+  // the length of the only range is the varint right before its two images
+  std::vector<char> log(log_manager->GetLogBuffer(),
+                        log_manager->GetLogBuffer() + begin_record.GetSize() + delta_record.GetSize());
+  log[log.size() - 2 * length - 1] = 0x7f;
+  disk_manager->WriteLog(log.data(), static_cast<int>(log.size()));
+
+  auto *log_recovery = new LogRecovery(disk_manager, bpm);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  EXPECT_EQ(delta_record.GetLSN(), log_recovery->GetNextLSN());
+
+  delete log_recovery;
+  delete log_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// a tuple length that is negative or runs past the end of its record ends the log
+TEST_F(RecoveryTest, CorruptTupleRecordTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::INTEGER};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple{{ValueFactory::GetIntegerValue(1), ValueFactory::GetIntegerValue(2)}, &schema};
+
+  for (int32_t corrupt_length : {static_cast<int32_t>(tuple.GetLength() + 1), -1, 0x7fffffff}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+    auto *log_manager = new LogManager(disk_manager);
+
+    LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+    log_manager->AppendLogRecord(&begin_record);
+    LogRecord insert_record(0, begin_record.GetLSN(), LogRecordType::INSERT, RID(0, 0), tuple);
+    log_manager->AppendLogRecord(&insert_record);
+
+    // the length of the tuple is the last field but the tuple itself
+    std::vector<char> log(log_manager->GetLogBuffer(),
+                          log_manager->GetLogBuffer() + begin_record.GetSize() + insert_record.GetSize());
+    memcpy(&log[log.size() - tuple.GetLength() - sizeof(int32_t)], &corrupt_length, sizeof(int32_t));
+    disk_manager->WriteLog(log.data(), static_cast<int>(log.size()));
+
+    auto *log_recovery = new LogRecovery(disk_manager, bpm);
+    log_recovery->Redo();
+    log_recovery->Undo();
+    EXPECT_EQ(insert_record.GetLSN(), log_recovery->GetNextLSN()) << corrupt_length;
+
+    delete log_recovery;
+    delete log_manager;
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log.0");
+    remove("test.master");
+  }
+}
+
+// a CHECKPOINT_END whose table sizes do not fit into the record ends the log instead of allocating for them
+TEST_F(RecoveryTest, CorruptCheckpointTest) {
+  for (int32_t corrupt_size : {3, -1, 0x7fffffff}) {
+    for (bool corrupt_dpt : {false, true}) {
+      auto *disk_manager = new DiskManager("test.db");
+      auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+      auto *log_manager = new LogManager(disk_manager);
+
+      LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+      log_manager->AppendLogRecord(&begin_record);
+      LogRecord checkpoint_record(0, {{0, begin_record.GetLSN()}}, {{0, begin_record.GetLSN()}});
+      log_manager->AppendLogRecord(&checkpoint_record);
+
+      // each table is its size followed by one entry
+      std::vector<char> log(log_manager->GetLogBuffer(),
+                            log_manager->GetLogBuffer() + begin_record.GetSize() + checkpoint_record.GetSize());
+      size_t dpt_offset = log.size() - sizeof(int32_t) - sizeof(page_id_t) - sizeof(lsn_t);
+      size_t att_offset = dpt_offset - sizeof(int32_t) - sizeof(txn_id_t) - sizeof(lsn_t);
+      memcpy(&log[corrupt_dpt ? dpt_offset : att_offset], &corrupt_size, sizeof(int32_t));
+      disk_manager->WriteLog(log.data(), static_cast<int>(log.size()));
+
+      auto *log_recovery = new LogRecovery(disk_manager, bpm);
+      log_recovery->Redo();
+      log_recovery->Undo();
+      EXPECT_EQ(checkpoint_record.GetLSN(), log_recovery->GetNextLSN()) << corrupt_size << " " << corrupt_dpt;
+
+      delete log_recovery;
+      delete log_manager;
+      delete bpm;
+      disk_manager->ShutDown();
+      delete disk_manager;
+      remove("test.db");
+      remove("test.log.0");
+      remove("test.master");
+    }
+  }
+}
+
+// a record that does not fit into the log buffer is rejected instead of waiting for room that never comes
+TEST_F(RecoveryTest, OversizeRecordTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *log_manager = new LogManager(disk_manager);
+
+  LogRecord begin_record(0, INVALID_LSN, LogRecordType::BEGIN);
+  log_manager->AppendLogRecord(&begin_record);
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txn_table(LOG_BUFFER_SIZE / (sizeof(txn_id_t) + sizeof(lsn_t)));
+  LogRecord checkpoint_record(0, active_txn_table, {});
+  EXPECT_THROW(log_manager->AppendLogRecord(&checkpoint_record), Exception);
+
+  LogRecord commit_record(0, begin_record.GetLSN(), LogRecordType::COMMIT);
+  EXPECT_EQ(begin_record.GetLSN() + 1, log_manager->AppendLogRecord(&commit_record));
+
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
 }  // namespace bustub
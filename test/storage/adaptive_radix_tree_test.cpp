@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_radix_tree_test.cpp
+//
+// Identification: test/storage/adaptive_radix_tree_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/adaptive_radix_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = AdaptiveRadixTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+// every key of expected must map to its value, and none of the other keys
+void CheckTree(Tree *tree, const std::map<int64_t, int64_t> &expected, const std::vector<int64_t> &keys) {
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    auto found = expected.find(key);
+    ASSERT_EQ(tree->GetValue(index_key, &rids), found != expected.end()) << key;
+    if (found != expected.end()) {
+      ASSERT_EQ(rids.size(), 1) << key;
+      EXPECT_EQ(rids[0].Get(), found->second) << key;
+    }
+  }
+}
+
+// random inserts and removes against a map, over keys that share long prefixes, keys that differ in their first byte
+// and keys that differ in a byte in the middle, so that prefixes are split and merged and nodes of every size grow and
+// shrink
+TEST(AdaptiveRadixTreeTest, RandomOperationsTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::mt19937_64 random(15445);
+
+  std::vector<std::vector<int64_t>> key_sets(3);
+  for (int64_t i = 0; i < 2000; i++) {
+    key_sets[0].push_back(i - 1000);
+    key_sets[1].push_back(static_cast<int64_t>(random()));
+    key_sets[2].push_back((i % 300) << 32 | (i / 300));
+  }
+
+  for (const auto &keys : key_sets) {
+    Tree tree(comparator);
+    EXPECT_TRUE(tree.IsEmpty());
+    std::map<int64_t, int64_t> expected;
+    GenericKey<8> index_key;
+    for (int i = 0; i < 20000; i++) {
+      int64_t key = keys[random() % keys.size()];
+      index_key.SetFromInteger(key);
+      RID rid(i, static_cast<uint32_t>(key));
+      if (random() % 3 == 0) {
+        EXPECT_EQ(tree.Remove(index_key), expected.erase(key) == 1) << key;
+      } else {
+        EXPECT_EQ(tree.Insert(index_key, rid), expected.count(key) == 0) << key;
+        expected.emplace(key, rid.Get());
+      }
+      if (i % 5000 == 0) {
+        CheckTree(&tree, expected, keys);
+      }
+    }
+    EXPECT_FALSE(tree.IsEmpty());
+    CheckTree(&tree, expected, keys);
+
+    // insert everything, then remove everything in random order
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, static_cast<uint32_t>(key)));
+      expected.emplace(key, RID(0, static_cast<uint32_t>(key)).Get());
+    }
+    CheckTree(&tree, expected, keys);
+    auto shuffled = keys;
+    std::shuffle(shuffled.begin(), shuffled.end(), random);
+    for (auto key : shuffled) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Remove(index_key)) << key;
+      EXPECT_FALSE(tree.Remove(index_key)) << key;
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    CheckTree(&tree, {}, keys);
+  }
+}
+
+TEST(AdaptiveRadixTreeTest, ConcurrentTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  Tree tree(comparator);
+
+  // writers insert their own keys and remove every other one again, readers only ever see a key with its value
+  const int num_threads = 4;
+  const int64_t keys_per_thread = 5000;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      GenericKey<8> index_key;
+      for (int64_t i = 0; i < keys_per_thread; i++) {
+        index_key.SetFromInteger(i * num_threads + thread);
+        EXPECT_TRUE(tree.Insert(index_key, RID(thread, static_cast<uint32_t>(i))));
+        if (i % 2 == 1) {
+          index_key.SetFromInteger((i - 1) * num_threads + thread);
+          EXPECT_TRUE(tree.Remove(index_key));
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      GenericKey<8> index_key;
+      for (int64_t key = 0; key < keys_per_thread * num_threads; key += 3) {
+        std::vector<RID> rids;
+        index_key.SetFromInteger(key);
+        if (tree.GetValue(index_key, &rids)) {
+          EXPECT_EQ(rids[0].GetPageId(), key % num_threads);
+          EXPECT_EQ(rids[0].GetSlotNum(), key / num_threads);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::map<int64_t, int64_t> expected;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < keys_per_thread * num_threads; key++) {
+    keys.push_back(key);
+    if (key / num_threads % 2 == 1) {
+      expected[key] = RID(static_cast<int32_t>(key % num_threads), static_cast<uint32_t>(key / num_threads)).Get();
+    }
+  }
+  CheckTree(&tree, expected, keys);
+}
+
+}  // namespace bustub
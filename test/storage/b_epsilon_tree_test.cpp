@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_epsilon_tree_test.cpp
+//
+// Identification: test/storage/b_epsilon_tree_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_epsilon_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BEpsilonTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+// every key of expected must map to its value, and none of the keys up to max_key that are not in it
+void CheckTree(Tree *tree, const std::map<int64_t, int64_t> &expected, int64_t max_key) {
+  GenericKey<8> index_key;
+  for (int64_t key = 0; key < max_key; key++) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    auto found = expected.find(key);
+    ASSERT_EQ(tree->GetValue(index_key, &rids), found != expected.end()) << key;
+    if (found != expected.end()) {
+      ASSERT_EQ(rids.size(), 1) << key;
+      EXPECT_EQ(rids[0].Get(), found->second) << key;
+    }
+  }
+}
+
+// random inserts, overwrites and removes against a map, with pages small enough that the messages are flushed down
+// several levels
+TEST(BEpsilonTreeTest, RandomOperationsTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  for (auto sizes : std::vector<std::vector<int>>{{2, 3, 1}, {4, 4, 6}, {16, 5, 30}}) {
+    Tree tree("foo_pk", bpm, comparator, sizes[0], sizes[1], sizes[2]);
+    EXPECT_TRUE(tree.IsEmpty());
+    std::mt19937 random(15445);
+    std::map<int64_t, int64_t> expected;
+    const int64_t max_key = 2000;
+    GenericKey<8> index_key;
+    for (int i = 0; i < 10000; i++) {
+      int64_t key = random() % max_key;
+      index_key.SetFromInteger(key);
+      if (random() % 3 == 0) {
+        tree.Remove(index_key);
+        expected.erase(key);
+      } else {
+        tree.Insert(index_key, RID(i, static_cast<uint32_t>(key)));
+        expected[key] = RID(i, static_cast<uint32_t>(key)).Get();
+      }
+      if (i % 2500 == 0) {
+        CheckTree(&tree, expected, max_key);
+      }
+    }
+    EXPECT_FALSE(tree.IsEmpty());
+    CheckTree(&tree, expected, max_key);
+
+    // remove everything, then insert in ascending order
+    for (int64_t key = 0; key < max_key; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    CheckTree(&tree, {}, max_key);
+    expected.clear();
+    for (int64_t key = 0; key < max_key; key++) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, static_cast<uint32_t>(key)));
+      expected[key] = RID(0, static_cast<uint32_t>(key)).Get();
+    }
+    CheckTree(&tree, expected, max_key);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the default page sizes, with more keys than the buffer pool holds pages
+TEST(BEpsilonTreeTest, DefaultSizesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  Tree tree("foo_pk", bpm, comparator);
+
+  std::vector<int64_t> keys;
+  const int64_t max_key = 50000;
+  for (int64_t key = 0; key < max_key; key += 2) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  std::map<int64_t, int64_t> expected;
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(static_cast<int32_t>(key >> 8), static_cast<uint32_t>(key)));
+    expected[key] = RID(static_cast<int32_t>(key >> 8), static_cast<uint32_t>(key)).Get();
+  }
+  CheckTree(&tree, expected, max_key);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BEpsilonTreeTest, ConcurrentTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  Tree tree("foo_pk", bpm, comparator, 8, 4, 16);
+
+  // writers insert their own keys and remove every other one again, readers only ever see a key with its value
+  const int num_threads = 4;
+  const int64_t keys_per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      GenericKey<8> index_key;
+      for (int64_t i = 0; i < keys_per_thread; i++) {
+        index_key.SetFromInteger(i * num_threads + thread);
+        tree.Insert(index_key, RID(thread, static_cast<uint32_t>(i)));
+        if (i % 2 == 1) {
+          index_key.SetFromInteger((i - 1) * num_threads + thread);
+          tree.Remove(index_key);
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      GenericKey<8> index_key;
+      for (int64_t key = 0; key < keys_per_thread * num_threads; key += 7) {
+        std::vector<RID> rids;
+        index_key.SetFromInteger(key);
+        if (tree.GetValue(index_key, &rids)) {
+          EXPECT_EQ(rids[0].GetPageId(), key % num_threads);
+          EXPECT_EQ(rids[0].GetSlotNum(), key / num_threads);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::map<int64_t, int64_t> expected;
+  for (int64_t key = 0; key < keys_per_thread * num_threads; key++) {
+    if (key / num_threads % 2 == 1) {
+      expected[key] = RID(static_cast<int32_t>(key % num_threads), static_cast<uint32_t>(key / num_threads)).Get();
+    }
+  }
+  CheckTree(&tree, expected, keys_per_thread * num_threads);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,291 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <tuple>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/external_sort.h"
+#include "storage/page/header_page.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+// walk the subtree below page_id, checking parent links and min sizes, and return the number of keys in it
+auto CheckSubtree(BufferPoolManager *bpm, page_id_t page_id, page_id_t parent_id, int depth, int *leaf_depth)
+    -> int64_t {
+  auto node = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+  EXPECT_EQ(node->GetParentPageId(), parent_id);
+  if (!node->IsRootPage()) {
+    EXPECT_GE(node->GetSize(), node->GetMinSize());
+  }
+  EXPECT_LE(node->GetSize(), node->GetMaxSize());
+  int64_t count = 0;
+  if (node->IsLeafPage()) {
+    if (*leaf_depth == -1) {
+      *leaf_depth = depth;
+    }
+    EXPECT_EQ(depth, *leaf_depth);
+    count = node->GetSize();
+  } else {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    EXPECT_GE(internal->GetSize(), 2);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      count += CheckSubtree(bpm, internal->ValueAt(i), page_id, depth + 1, leaf_depth);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+  return count;
+}
+
+auto CheckTree(BufferPoolManager *bpm, const std::string &name) -> int64_t {
+  auto header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  page_id_t root_id = INVALID_PAGE_ID;
+  header_page->GetRootId(name, &root_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  if (root_id == INVALID_PAGE_ID) {
+    return 0;
+  }
+  int leaf_depth = -1;
+  return CheckSubtree(bpm, root_id, INVALID_PAGE_ID, 0, &leaf_depth);
+}
+
+TEST(BPlusTreeBulkLoadTest, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // leaf max size, internal max size, fill factor
+  std::vector<std::tuple<int, int, double>> shapes = {{2, 3, 1.0}, {3, 4, 0.5}, {5, 5, 0.7}, {8, 6, 1.0}};
+  for (auto [leaf_max_size, internal_max_size, fill_factor] : shapes) {
+    for (int64_t scale_factor : {0, 1, 2, 3, 7, 20, 100, 1000}) {
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, leaf_max_size,
+                                                               internal_max_size);
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(&page_id);
+      (void)header_page;
+
+      // every key is produced twice, the duplicate is skipped
+      int64_t produced = 0;
+      auto next_entry = [&produced, scale_factor](GenericKey<8> *key, RID *rid) {
+        if (produced == 2 * scale_factor) {
+          return false;
+        }
+        int64_t k = produced++ / 2 + 1;
+        key->SetFromInteger(k);
+        rid->Set(static_cast<int32_t>(k >> 32), k & 0xFFFFFFFF);
+        return true;
+      };
+      ASSERT_TRUE(tree.BulkLoad(next_entry, fill_factor));
+      EXPECT_EQ(tree.IsEmpty(), scale_factor == 0);
+      EXPECT_EQ(CheckTree(bpm, "foo_pk"), scale_factor);
+
+      int64_t current_key = 1;
+      for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+        EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+        current_key = current_key + 1;
+      }
+      EXPECT_EQ(current_key, scale_factor + 1);
+
+      // a loaded tree refuses a second load but keeps working as usual
+      produced = 0;
+      EXPECT_EQ(tree.BulkLoad(next_entry, fill_factor), scale_factor == 0);
+      GenericKey<8> index_key;
+      RID rid;
+      for (int64_t key = scale_factor + 1; key <= scale_factor + 50; key++) {
+        index_key.SetFromInteger(key);
+        rid.Set(0, key);
+        EXPECT_TRUE(tree.Insert(index_key, rid));
+      }
+      for (int64_t key = 1; key <= scale_factor + 50; key += 2) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key);
+      }
+      EXPECT_EQ(CheckTree(bpm, "foo_pk"), (scale_factor + 50) / 2);
+      std::vector<RID> rids;
+      for (int64_t key = 1; key <= scale_factor + 50; key++) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        EXPECT_EQ(tree.GetValue(index_key, &rids), key % 2 == 0);
+      }
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete bpm;
+      delete disk_manager;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+}
+
+// input out of order throws and leaves the tree empty, ready for a load of proper input
+TEST(BPlusTreeBulkLoadTest, OutOfOrderTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // 1 to 500, then 3 again
+  int64_t produced = 0;
+  int64_t num_keys = 500;
+  auto next_entry = [&produced, &num_keys](GenericKey<8> *key, RID *rid) {
+    if (produced > num_keys) {
+      return false;
+    }
+    int64_t k = produced++ == num_keys ? 3 : produced;
+    key->SetFromInteger(k);
+    rid->Set(0, k);
+    return true;
+  };
+  EXPECT_THROW(tree.BulkLoad(next_entry), Exception);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_EQ(CheckTree(bpm, "foo_pk"), 0);
+  EXPECT_TRUE(tree.Begin() == tree.End());
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  index_key.SetFromInteger(1);
+  EXPECT_FALSE(tree.GetValue(index_key, &rids));
+
+  produced = 0;
+  num_keys = 99;
+  auto next_in_order = [&](GenericKey<8> *key, RID *rid) { return produced < num_keys && next_entry(key, rid); };
+  ASSERT_TRUE(tree.BulkLoad(next_in_order));
+  EXPECT_EQ(CheckTree(bpm, "foo_pk"), num_keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeBulkLoadTest, ExternalSortTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  const size_t pool_size = 10;
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 5000; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+
+  {
+    // runs of 64 pairs merged two at a time take several passes through a pool much smaller than the input
+    ExternalSort<GenericKey<8>, RID, GenericComparator<8>> sorter(bpm, comparator, 64, 2);
+    GenericKey<8> index_key;
+    RID rid;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      rid.Set(0, key);
+      sorter.Add(index_key, rid);
+    }
+    sorter.Sort();
+    EXPECT_EQ(sorter.GetRunCount(), (keys.size() + 63) / 64);
+    int64_t current_key = 1;
+    while (sorter.Next(&index_key, &rid)) {
+      EXPECT_EQ(rid.GetSlotNum(), current_key);
+      current_key = current_key + 1;
+    }
+    EXPECT_EQ(current_key, keys.size() + 1);
+  }
+
+  {
+    // abandoning the output half way releases everything as well
+    ExternalSort<GenericKey<8>, RID, GenericComparator<8>> sorter(bpm, comparator, 64, 4);
+    GenericKey<8> index_key;
+    RID rid;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      sorter.Add(index_key, rid);
+    }
+    sorter.Sort();
+    for (int i = 0; i < 100; i++) {
+      EXPECT_TRUE(sorter.Next(&index_key, &rid));
+    }
+  }
+
+  // no page is left pinned
+  page_id_t page_id;
+  for (size_t i = 0; i < pool_size; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeBulkLoadTest, InsertFromFileTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 300; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  {
+    std::ofstream output("bulk_load_keys.txt");
+    for (size_t i = 0; i < keys.size(); i++) {
+      output << keys[i] << (i % 2 == 0 ? " " : "\n");
+    }
+  }
+  // the first file is bulk loaded into the empty tree, the second one inserted on top
+  tree.InsertFromFile("bulk_load_keys.txt");
+  {
+    std::ofstream output("bulk_load_keys.txt");
+    output << "301 0 302\n";
+  }
+  tree.InsertFromFile("bulk_load_keys.txt");
+  remove("bulk_load_keys.txt");
+  EXPECT_EQ(CheckTree(bpm, "foo_pk"), 303);
+
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 303);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_compression_test.cpp
+//
+// Identification: test/storage/b_plus_tree_compression_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/page/header_page.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using CompressedKey = GenericKey<64>;
+using CompressedComparator = GenericComparator<64>;
+using CompressedTree = BPlusTree<CompressedKey, RID, CompressedComparator>;
+using CompressedInternalPage = BPlusTreeInternalPage<CompressedKey, page_id_t, CompressedComparator>;
+
+// key over eight bigint columns; the first one orders the keys, the others are either zero or random noise
+auto MakeKey(int64_t key, std::mt19937_64 *noise) -> CompressedKey {
+  CompressedKey index_key;
+  index_key.SetFromInteger(key);
+  if (noise != nullptr) {
+    for (size_t offset = sizeof(int64_t); offset < sizeof(CompressedKey); offset += sizeof(int64_t)) {
+      auto column = static_cast<int64_t>((*noise)() >> 2);
+      memcpy(index_key.data_ + offset, &column, sizeof(int64_t));
+    }
+  }
+  return index_key;
+}
+
+// walk the subtree below page_id, checking parent links and sizes, and count its keys and leaves
+void CheckSubtree(BufferPoolManager *bpm, page_id_t page_id, page_id_t parent_id, int64_t *keys, int64_t *leaves) {
+  auto node = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+  EXPECT_EQ(node->GetParentPageId(), parent_id);
+  if (!node->IsRootPage()) {
+    EXPECT_GE(node->GetSize(), node->GetMinSize());
+  }
+  EXPECT_LE(node->GetSize(), node->GetMaxSize());
+  if (node->IsLeafPage()) {
+    *keys += node->GetSize();
+    *leaves += 1;
+  } else {
+    auto internal = reinterpret_cast<CompressedInternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      CheckSubtree(bpm, internal->ValueAt(i), page_id, keys, leaves);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+}
+
+// check the tree and its scan order against the expected keys, which are sorted and whose noise is reproducible
+void CheckTree(BufferPoolManager *bpm, CompressedTree *tree, const std::vector<int64_t> &expected, int64_t *leaves) {
+  auto header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  page_id_t root_id = INVALID_PAGE_ID;
+  header_page->GetRootId("foo_pk", &root_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  int64_t keys = 0;
+  *leaves = 0;
+  if (root_id != INVALID_PAGE_ID) {
+    CheckSubtree(bpm, root_id, INVALID_PAGE_ID, &keys, leaves);
+  }
+  EXPECT_EQ(keys, expected.size());
+
+  size_t i = 0;
+  for (auto iterator = tree->Begin(); iterator != tree->End(); ++iterator, ++i) {
+    ASSERT_LT(i, expected.size());
+    EXPECT_EQ((*iterator).first.ToString(), expected[i]);
+    EXPECT_EQ((*iterator).second.GetSlotNum(), expected[i]);
+  }
+  EXPECT_EQ(i, expected.size());
+}
+
+TEST(BPlusTreeCompressionTest, PrefixCompressionTest) {
+  auto key_schema = ParseCreateStatement("a bigint,b bigint,c bigint,d bigint,e bigint,f bigint,g bigint,h bigint");
+  CompressedComparator comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  CompressedTree tree("foo_pk", bpm, comparator);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // even keys are mostly zero bytes and compress well
+  const int64_t scale_factor = 20000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 2; key <= 2 * scale_factor; key += 2) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  RID rid;
+  for (auto key : keys) {
+    rid.Set(0, key);
+    EXPECT_TRUE(tree.Insert(MakeKey(key, nullptr), rid));
+  }
+  std::sort(keys.begin(), keys.end());
+  int64_t leaves;
+  CheckTree(bpm, &tree, keys, &leaves);
+  // leaves hold more pairs than fit into a page uncompressed
+  int64_t uncompressed = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(CompressedKey) + sizeof(RID));
+  EXPECT_GT(static_cast<int64_t>(keys.size()), leaves * uncompressed);
+
+  // odd keys carry random noise, so the pages they land on no longer fit as many pairs and split early
+  std::mt19937_64 noise(15445);
+  std::vector<int64_t> noisy_keys;
+  std::vector<CompressedKey> noisy_index_keys;
+  for (int64_t key = 1; key < 2 * scale_factor; key += 20) {
+    noisy_keys.push_back(key);
+    noisy_index_keys.push_back(MakeKey(key, &noise));
+  }
+  // a cluster of keys that mostly differ in their last column only is separated by keys as wide as they are,
+  // which do not fit into internal pages as many as the short separators elsewhere
+  for (int i = 0; i < 10000; i++) {
+    noisy_keys.push_back(2 * scale_factor + 1);
+    CompressedKey index_key = MakeKey(2 * scale_factor + 1, &noise);
+    for (size_t offset = sizeof(int64_t); offset + sizeof(int64_t) < sizeof(CompressedKey); offset += sizeof(int64_t)) {
+      int64_t column = noise() % 2;
+      memcpy(index_key.data_ + offset, &column, sizeof(int64_t));
+    }
+    noisy_index_keys.push_back(index_key);
+  }
+  std::vector<size_t> order(noisy_keys.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+  for (auto i : order) {
+    rid.Set(0, noisy_keys[i]);
+    EXPECT_TRUE(tree.Insert(noisy_index_keys[i], rid));
+    EXPECT_FALSE(tree.Insert(noisy_index_keys[i], rid));
+  }
+  std::vector<int64_t> expected;
+  std::merge(keys.begin(), keys.end(), noisy_keys.begin(), noisy_keys.end(), std::back_inserter(expected));
+  CheckTree(bpm, &tree, expected, &leaves);
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < noisy_keys.size(); i++) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(noisy_index_keys[i], &rids));
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), noisy_keys[i]);
+    // only the noise tells the key apart from an absent one
+    EXPECT_FALSE(tree.GetValue(MakeKey(noisy_keys[i], nullptr), &rids));
+  }
+
+  // removing keys merges and redistributes pages whose keys compress differently
+  std::shuffle(order.begin(), order.end(), std::mt19937(15446));
+  for (size_t j = 0; j < order.size() / 2; j++) {
+    tree.Remove(noisy_index_keys[order[j]]);
+  }
+  for (auto key : keys) {
+    if (key % 6 != 0) {
+      tree.Remove(MakeKey(key, nullptr));
+    }
+  }
+  std::vector<int64_t> remaining;
+  std::vector<bool> removed(noisy_keys.size(), false);
+  for (size_t j = 0; j < order.size() / 2; j++) {
+    removed[order[j]] = true;
+  }
+  for (size_t i = 0; i < noisy_keys.size(); i++) {
+    if (!removed[i]) {
+      remaining.push_back(noisy_keys[i]);
+    }
+  }
+  for (auto key : keys) {
+    if (key % 6 == 0) {
+      remaining.push_back(key);
+    }
+  }
+  std::sort(remaining.begin(), remaining.end());
+  CheckTree(bpm, &tree, remaining, &leaves);
+
+  for (size_t i = 0; i < noisy_keys.size(); i++) {
+    tree.Remove(noisy_index_keys[i]);
+  }
+  for (auto key : keys) {
+    tree.Remove(MakeKey(key, nullptr));
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -10,14 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
+#include <random>
 #include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/page/header_page.h"
 #include "test_util.h"  // NOLINT
 
 namespace bustub {
@@ -100,7 +104,7 @@ void DeleteHelperSplit(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
+TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -152,7 +156,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
+TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -203,7 +207,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
+TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -245,7 +249,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
+TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -288,7 +292,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
+TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -333,4 +337,309 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, OptimisticMixTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // small nodes so that splits and merges reach the root while other threads are descending
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int64_t scale_factor = 2000;
+  const int total_threads = 4;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  LaunchParallelTest(total_threads, InsertHelperSplit, &tree, keys, total_threads);
+
+  // remove the odd keys while readers keep looking up the even ones
+  std::vector<int64_t> remove_keys;
+  for (auto key : keys) {
+    if (key % 2 == 1) {
+      remove_keys.push_back(key);
+    }
+  }
+  std::atomic<bool> lookup_failed{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([&tree, &lookup_failed, scale_factor] {
+      GenericKey<8> key;
+      std::vector<RID> rids;
+      for (int64_t k = 2; k <= scale_factor; k += 2) {
+        rids.clear();
+        key.SetFromInteger(k);
+        if (!tree.GetValue(key, &rids) || rids[0].GetSlotNum() != k) {
+          lookup_failed = true;
+        }
+      }
+    });
+  }
+  LaunchParallelTest(total_threads, DeleteHelperSplit, &tree, remove_keys, total_threads);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_FALSE(lookup_failed);
+
+  int64_t current_key = 2;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(current_key, scale_factor + 2);
+
+  // drain the tree completely and start it over
+  std::vector<int64_t> remaining_keys;
+  for (auto key : keys) {
+    if (key % 2 == 0) {
+      remaining_keys.push_back(key);
+    }
+  }
+  LaunchParallelTest(total_threads, DeleteHelperSplit, &tree, remaining_keys, total_threads);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin() == tree.End());
+  InsertHelper(&tree, {42});
+  std::vector<RID> rids;
+  index_key.SetFromInteger(42);
+  EXPECT_TRUE(tree.GetValue(index_key, &rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// walk every level of a B-link tree along the right links, checking that the high key of each page separates its keys
+// from those of its right sibling; returns the number of keys in the leaves
+auto CheckBLinkLevels(BufferPoolManager *bpm, const GenericComparator<8> &comparator) -> int64_t {
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+  auto header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  page_id_t level_page_id = INVALID_PAGE_ID;
+  header_page->GetRootId("foo_pk", &level_page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  int64_t keys = 0;
+  while (level_page_id != INVALID_PAGE_ID) {
+    bool leaf_level = false;
+    page_id_t next_level_page_id = INVALID_PAGE_ID;
+    bool has_low_key = false;
+    GenericKey<8> low_key;
+    for (page_id_t page_id = level_page_id; page_id != INVALID_PAGE_ID;) {
+      auto node = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(page_id)->GetData());
+      page_id_t next_page_id;
+      GenericKey<8> high_key;
+      std::vector<GenericKey<8>> node_keys;
+      if (node->IsLeafPage()) {
+        auto leaf = reinterpret_cast<LeafPage *>(node);
+        leaf_level = true;
+        next_page_id = leaf->GetNextPageId();
+        high_key = leaf->GetHighKey();
+        for (int i = 0; i < leaf->GetSize(); i++) {
+          node_keys.push_back(leaf->KeyAt(i));
+        }
+        keys += leaf->GetSize();
+      } else {
+        auto internal = reinterpret_cast<InternalPage *>(node);
+        next_page_id = internal->GetNextPageId();
+        high_key = internal->GetHighKey();
+        if (page_id == level_page_id) {
+          next_level_page_id = internal->ValueAt(0);
+        } else {
+          // the first key of an internal page is the high key of its left sibling
+          EXPECT_EQ(comparator(internal->KeyAt(0), low_key), 0);
+        }
+        for (int i = 1; i < internal->GetSize(); i++) {
+          node_keys.push_back(internal->KeyAt(i));
+        }
+      }
+      for (const auto &key : node_keys) {
+        EXPECT_FALSE(has_low_key && comparator(key, low_key) < 0);
+        EXPECT_FALSE(next_page_id != INVALID_PAGE_ID && comparator(key, high_key) >= 0);
+      }
+      has_low_key = true;
+      low_key = high_key;
+      bpm->UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    level_page_id = leaf_level ? INVALID_PAGE_ID : next_level_page_id;
+  }
+  return keys;
+}
+
+TEST(BPlusTreeConcurrentTest, BLinkMixTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // small nodes so that splits reach the root while other threads are descending
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4, BPlusTreeMode::B_LINK);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // every thread inserts an increasing run of keys, so all of them keep splitting the rightmost pages, while a reader
+  // looks up the last key each of them inserted
+  const int64_t scale_factor = 2000;
+  const int total_threads = 4;
+  std::vector<std::atomic<int64_t>> last_inserted(total_threads);
+  for (auto &last : last_inserted) {
+    last = 0;
+  }
+  std::atomic<bool> lookup_failed{false};
+  std::atomic<int> inserting{total_threads};
+  std::thread reader([&tree, &lookup_failed, &inserting, &last_inserted] {
+    GenericKey<8> key;
+    std::vector<RID> rids;
+    while (inserting > 0) {
+      for (auto &last : last_inserted) {
+        int64_t k = last;
+        if (k == 0) {
+          continue;
+        }
+        rids.clear();
+        key.SetFromInteger(k);
+        if (!tree.GetValue(key, &rids) || rids[0].GetSlotNum() != k) {
+          lookup_failed = true;
+        }
+      }
+    }
+  });
+  LaunchParallelTest(total_threads, [&tree, &inserting, &last_inserted, scale_factor](uint64_t thread_itr) {
+    GenericKey<8> index_key;
+    for (int64_t key = thread_itr + 1; key <= scale_factor; key += total_threads) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+      last_inserted[thread_itr] = key;
+    }
+    inserting--;
+  });
+  reader.join();
+  EXPECT_FALSE(lookup_failed);
+  EXPECT_EQ(CheckBLinkLevels(bpm, comparator), scale_factor);
+
+  // remove the odd keys while readers keep looking up the even ones and new keys are appended
+  std::vector<int64_t> remove_keys;
+  std::vector<int64_t> more_keys;
+  for (int64_t key = 1; key <= scale_factor; key += 2) {
+    remove_keys.push_back(key);
+    more_keys.push_back(scale_factor + key + 1);
+  }
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([&tree, &lookup_failed, scale_factor] {
+      GenericKey<8> key;
+      std::vector<RID> rids;
+      for (int64_t k = 2; k <= scale_factor; k += 2) {
+        rids.clear();
+        key.SetFromInteger(k);
+        if (!tree.GetValue(key, &rids) || rids[0].GetSlotNum() != k) {
+          lookup_failed = true;
+        }
+      }
+    });
+  }
+  readers.emplace_back([&tree, &more_keys] { InsertHelper(&tree, more_keys); });
+  LaunchParallelTest(total_threads, DeleteHelperSplit, &tree, remove_keys, total_threads);
+  for (auto &thread : readers) {
+    thread.join();
+  }
+  EXPECT_FALSE(lookup_failed);
+  EXPECT_EQ(CheckBLinkLevels(bpm, comparator), scale_factor);
+
+  int64_t current_key = 2;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(current_key, 2 * scale_factor + 2);
+
+  // emptied leaves stay linked and are skipped
+  std::vector<int64_t> remaining_keys;
+  for (int64_t key = 2; key <= 2 * scale_factor; key += 2) {
+    if (key % 10 != 0) {
+      remaining_keys.push_back(key);
+    }
+  }
+  LaunchParallelTest(total_threads, DeleteHelperSplit, &tree, remaining_keys, total_threads);
+  current_key = 10;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 10;
+  }
+  EXPECT_EQ(current_key, 2 * scale_factor + 10);
+  EXPECT_EQ(CheckBLinkLevels(bpm, comparator), scale_factor / 5);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, BLinkBulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 5, 5, BPlusTreeMode::B_LINK);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // bulk loaded pages are linked on every level, so concurrent inserts can move right from the start
+  const int64_t scale_factor = 1000;
+  int64_t next = 0;
+  EXPECT_TRUE(tree.BulkLoad([&next, scale_factor](GenericKey<8> *key, RID *rid) {
+    if (next >= scale_factor) {
+      return false;
+    }
+    next++;
+    key->SetFromInteger(4 * next);
+    rid->Set(0, 4 * next);
+    return true;
+  }));
+  EXPECT_EQ(CheckBLinkLevels(bpm, comparator), scale_factor);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 4 * scale_factor; key++) {
+    if (key % 4 != 0) {
+      keys.push_back(key);
+    }
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  const int total_threads = 4;
+  LaunchParallelTest(total_threads, InsertHelperSplit, &tree, keys, total_threads);
+  EXPECT_EQ(CheckBLinkLevels(bpm, comparator), 4 * scale_factor);
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= 4 * scale_factor; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
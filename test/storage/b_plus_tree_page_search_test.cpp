@@ -0,0 +1,192 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_page_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_page_search_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+template <size_t KeySize>
+using SearchLeafPage = BPlusTreeLeafPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+template <size_t KeySize>
+using SearchInternalPage = BPlusTreeInternalPage<GenericKey<KeySize>, page_id_t, GenericComparator<KeySize>>;
+
+// the search every page did before, one comparator call per key
+template <size_t KeySize>
+auto ReferenceKeyIndex(SearchLeafPage<KeySize> *leaf, const GenericKey<KeySize> &key,
+                       const GenericComparator<KeySize> &comparator) -> int {
+  int left = 0;
+  int right = leaf->GetSize();
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    if (comparator(leaf->KeyAt(mid), key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+// fill a leaf and an internal page with as many of the sorted keys as fit, and check that searching for each of
+// the probes finds the same index or child as comparing key by key
+template <size_t KeySize>
+void CheckSearch(const std::vector<GenericKey<KeySize>> &keys, const std::vector<GenericKey<KeySize>> &probes,
+                 const GenericComparator<KeySize> &comparator) {
+  std::vector<char> leaf_data(PAGE_SIZE);
+  auto leaf = reinterpret_cast<SearchLeafPage<KeySize> *>(leaf_data.data());
+  leaf->Init(1, INVALID_PAGE_ID, 1000);
+  for (size_t i = 0; i < keys.size() && leaf->GetSize() + 1 < leaf->GetMaxSize() && leaf->HasRoomFor(keys[i]); i++) {
+    leaf->Insert(keys[i], RID(0, i), comparator);
+  }
+  std::vector<char> internal_data(PAGE_SIZE);
+  auto internal = reinterpret_cast<SearchInternalPage<KeySize> *>(internal_data.data());
+  internal->Init(1, INVALID_PAGE_ID, 1000);
+  internal->PopulateNewRoot(0, keys[0], 1);
+  for (size_t i = 1; i < keys.size() && internal->GetSize() < internal->GetMaxSize() && internal->HasRoomFor(keys[i]);
+       i++) {
+    internal->InsertNodeAfter(i, keys[i], i + 1);
+  }
+  ASSERT_GT(leaf->GetSize(), 1);
+  ASSERT_GT(internal->GetSize(), 2);
+
+  for (const auto &probe : probes) {
+    EXPECT_EQ(leaf->KeyIndex(probe, comparator), ReferenceKeyIndex<KeySize>(leaf, probe, comparator));
+    page_id_t child = 0;
+    for (int i = 1; i < internal->GetSize() && comparator(internal->KeyAt(i), probe) <= 0; i++) {
+      child = internal->ValueAt(i);
+    }
+    EXPECT_EQ(internal->Lookup(probe, comparator), child);
+  }
+}
+
+// keys over one bigint column, spaced stride apart from base
+auto BigintKeys(int64_t base, int64_t stride, int count) -> std::vector<GenericKey<8>> {
+  std::vector<GenericKey<8>> keys(count);
+  for (int i = 0; i < count; i++) {
+    keys[i].SetFromInteger(base + i * stride);
+  }
+  return keys;
+}
+
+TEST(BPlusTreePageSearchTest, SearchTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::mt19937_64 random(15445);
+
+  // strides that leave middles of every width from 1 to 8 bytes, and keys on both sides of zero
+  for (int64_t stride : {int64_t{1}, int64_t{3}, int64_t{300}, int64_t{1} << 20, int64_t{1} << 28, int64_t{1} << 36,
+                         int64_t{1} << 44, int64_t{1} << 52}) {
+    for (int64_t base : {int64_t{0}, -stride * 100, int64_t{1} << 40}) {
+      auto keys = BigintKeys(base, stride, 1000);
+      std::vector<GenericKey<8>> probes = BigintKeys(base - stride, stride, 1002);
+      for (auto offset : {int64_t{-1}, int64_t{1}}) {
+        auto between = BigintKeys(base + offset, stride, 1000);
+        probes.insert(probes.end(), between.begin(), between.end());
+      }
+      probes.push_back(BigintKeys(INT64_MIN + 1, 1, 1)[0]);
+      probes.push_back(BigintKeys(INT64_MAX, 1, 1)[0]);
+      CheckSearch<8>(keys, probes, comparator);
+    }
+  }
+
+  // random keys make the widest middles
+  std::vector<int64_t> values(1000);
+  for (auto &value : values) {
+    value = static_cast<int64_t>(random());
+  }
+  std::sort(values.begin(), values.end());
+  std::vector<GenericKey<8>> keys(values.size());
+  std::vector<GenericKey<8>> probes;
+  for (size_t i = 0; i < values.size(); i++) {
+    keys[i].SetFromInteger(values[i]);
+    probes.push_back(keys[i]);
+    probes.push_back(BigintKeys(values[i] + 1, 1, 1)[0]);
+    probes.push_back(BigintKeys(static_cast<int64_t>(random()), 1, 1)[0]);
+  }
+  CheckSearch<8>(keys, probes, comparator);
+
+  // keys of two integer columns wider than 8 bytes are searched byte by byte
+  auto wide_schema = ParseCreateStatement("a bigint,b bigint,c integer");
+  GenericComparator<32> wide_comparator(wide_schema.get());
+  std::vector<GenericKey<32>> wide_keys;
+  std::vector<GenericKey<32>> wide_probes;
+  for (int i = 0; i < 1000; i++) {
+    std::vector<Value> row = {Value(TypeId::BIGINT, static_cast<int64_t>(random() % 8)),
+                              Value(TypeId::BIGINT, static_cast<int64_t>(random())),
+                              Value(TypeId::INTEGER, static_cast<int32_t>(random() % 4))};
+    GenericKey<32> key;
+    key.SetFromKey(Tuple(row, wide_schema.get()), wide_schema.get());
+    (i % 2 == 0 ? wide_keys : wide_probes).push_back(key);
+  }
+  std::sort(wide_keys.begin(), wide_keys.end(),
+            [&wide_comparator](const auto &lhs, const auto &rhs) { return wide_comparator(lhs, rhs) < 0; });
+  wide_probes.insert(wide_probes.end(), wide_keys.begin(), wide_keys.end());
+  CheckSearch<32>(wide_keys, wide_probes, wide_comparator);
+}
+
+TEST(BPlusTreePageSearchTest, SearchBenchmark) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  std::mt19937_64 random(15445);
+
+  // compare the slot array search with the comparator one on full leaves of dense and sparse bigint keys
+  for (int64_t stride : {int64_t{1}, int64_t{1} << 12, int64_t{1} << 40}) {
+    std::vector<char> leaf_data(PAGE_SIZE);
+    auto leaf = reinterpret_cast<SearchLeafPage<8> *>(leaf_data.data());
+    leaf->Init(1, INVALID_PAGE_ID, 1000);
+    auto keys = BigintKeys(0, stride, 1000);
+    for (size_t i = 0; i < keys.size() && leaf->GetSize() + 1 < leaf->GetMaxSize() && leaf->HasRoomFor(keys[i]);
+         i++) {
+      leaf->Insert(keys[i], RID(0, i), comparator);
+    }
+    std::vector<GenericKey<8>> probes(4096);
+    for (auto &probe : probes) {
+      probe.SetFromInteger(static_cast<int64_t>(random() % (leaf->GetSize() * stride)));
+    }
+
+    const int rounds = 50;
+    int64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+      for (const auto &probe : probes) {
+        checksum += leaf->KeyIndex(probe, comparator);
+      }
+    }
+    auto slot_array_time = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+      for (const auto &probe : probes) {
+        checksum -= ReferenceKeyIndex<8>(leaf, probe, comparator);
+      }
+    }
+    auto comparator_time = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(checksum, 0);
+
+    auto searches = static_cast<double>(rounds * probes.size());
+    std::cout << "leaf of " << leaf->GetSize() << " keys " << stride << " apart: slot array search "
+              << std::chrono::duration<double, std::nano>(slot_array_time).count() / searches
+              << " ns, comparator search "
+              << std::chrono::duration<double, std::nano>(comparator_time).count() / searches << " ns" << std::endl;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,396 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_scan_test.cpp
+//
+// Identification: test/storage/b_plus_tree_scan_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using ScanTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+using ScanItem = std::pair<GenericKey<8>, RID>;
+using ScanIterator = IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
+
+// the slot numbers in [lo, hi) that one step at a time finds
+auto ScanOneByOne(ScanTree *tree, int64_t lo, int64_t hi) -> std::vector<uint32_t> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(lo);
+  std::vector<uint32_t> slots;
+  for (auto iterator = tree->Begin(index_key); iterator != tree->End(); ++iterator) {
+    if ((*iterator).second.GetSlotNum() >= hi) {
+      break;
+    }
+    slots.push_back((*iterator).second.GetSlotNum());
+  }
+  return slots;
+}
+
+// the slot numbers in [lo, hi) that batches of batch_size find, checking that only the last batch comes up short
+auto ScanInBatches(ScanTree *tree, int64_t lo, int64_t hi, int batch_size, const GenericComparator<8> &comparator)
+    -> std::vector<uint32_t> {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(lo);
+  GenericKey<8> end_key;
+  end_key.SetFromInteger(hi);
+  auto iterator = tree->Begin(index_key);
+  std::vector<ScanItem> items(batch_size);
+  std::vector<uint32_t> slots;
+  while (true) {
+    int count = iterator.NextBatch(items.data(), batch_size, end_key, comparator);
+    for (int i = 0; i < count; i++) {
+      EXPECT_EQ(items[i].first.ToString(), items[i].second.GetSlotNum());
+      slots.push_back(items[i].second.GetSlotNum());
+    }
+    if (count < batch_size) {
+      EXPECT_TRUE(iterator.IsEnd());
+      break;
+    }
+  }
+  EXPECT_EQ(iterator.NextBatch(items.data(), batch_size, end_key, comparator), 0);
+  return slots;
+}
+
+TEST(BPlusTreeScanTest, BatchScanTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // a pool much smaller than the tree, so that leaves are read back from disk
+  const size_t pool_size = 50;
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  auto *transaction = new Transaction(0);
+
+  // even keys, with every third hundred taken out again so that some leaves merged or were emptied
+  ScanTree tree("foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  const int64_t key_count = 20000;
+  for (int64_t key = 0; key < key_count; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key), transaction);
+  }
+  for (int64_t key = 0; key < key_count; key += 2) {
+    if (key / 100 % 3 == 1) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+  }
+
+  for (auto [lo, hi] : std::vector<std::pair<int64_t, int64_t>>{
+           {-1, key_count + 1}, {0, key_count}, {101, 599}, {1000, 1001}, {5000, 4000}, {key_count, key_count * 2}}) {
+    auto expected = ScanOneByOne(&tree, lo, hi);
+    for (int batch_size : {1, 7, 128, 1000}) {
+      EXPECT_EQ(ScanInBatches(&tree, lo, hi, batch_size, comparator), expected) << lo << " " << hi << " " << batch_size;
+    }
+  }
+
+  // without an end key the whole rest of the tree is copied
+  index_key.SetFromInteger(key_count / 2);
+  auto iterator = tree.Begin(index_key);
+  std::vector<ScanItem> items(64);
+  std::vector<uint32_t> slots;
+  for (int count; (count = iterator.NextBatch(items.data(), items.size())) > 0;) {
+    for (int i = 0; i < count; i++) {
+      slots.push_back(items[i].second.GetSlotNum());
+    }
+  }
+  EXPECT_EQ(slots, ScanOneByOne(&tree, key_count / 2, key_count));
+
+  // read aheads drop their pins once they are done, so every frame but the header page's can be taken again
+  iterator = tree.End();
+  std::vector<page_id_t> page_ids(pool_size - 1);
+  for (auto &new_page_id : page_ids) {
+    EXPECT_NE(bpm->NewPage(&new_page_id), nullptr);
+  }
+  for (auto new_page_id : page_ids) {
+    bpm->UnpinPage(new_page_id, false);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the keys that a reverse scan from the greatest key not above hi finds, or from the greatest key at all
+auto ScanBackwards(ScanTree *tree, const int64_t *hi) -> std::vector<int64_t> {
+  GenericKey<8> index_key;
+  if (hi != nullptr) {
+    index_key.SetFromInteger(*hi);
+  }
+  std::vector<int64_t> keys;
+  for (auto iterator = hi == nullptr ? tree->RBegin() : tree->RBegin(index_key); iterator != tree->REnd(); ++iterator) {
+    keys.push_back((*iterator).second.GetSlotNum());
+  }
+  return keys;
+}
+
+// every leaf links back to the one before it
+void CheckPrevLinks(ScanTree *tree, BufferPoolManager *bpm) {
+  Page *page = tree->FindLeafPage(GenericKey<8>(), true);
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  while (page != nullptr) {
+    auto leaf = reinterpret_cast<BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>> *>(page->GetData());
+    EXPECT_EQ(leaf->GetPrevPageId(), prev_page_id);
+    prev_page_id = page->GetPageId();
+    page_id_t next_page_id = leaf->GetNextPageId();
+    page->RUnlatch();
+    bpm->UnpinPage(prev_page_id, false);
+    page = next_page_id == INVALID_PAGE_ID ? nullptr : bpm->FetchPage(next_page_id);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+  }
+}
+
+TEST(BPlusTreeScanTest, ReverseScanTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  auto *transaction = new Transaction(0);
+
+  for (auto mode : {BPlusTreeMode::LATCH_CRABBING, BPlusTreeMode::B_LINK}) {
+    // small pages, even keys in random order and every third hundred taken out again, so that leaves split and merge
+    ScanTree tree("foo_pk", bpm, comparator, 8, 8, mode);
+    GenericKey<8> index_key;
+    EXPECT_TRUE(ScanBackwards(&tree, nullptr).empty());
+    const int64_t key_count = 4000;
+    std::vector<int64_t> keys;
+    for (int64_t key = 0; key < key_count; key += 2) {
+      keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key), transaction);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(15721));
+    std::vector<int64_t> expected;
+    for (auto key : keys) {
+      if (key / 100 % 3 == 1) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key, transaction);
+      } else {
+        expected.push_back(key);
+      }
+    }
+    std::sort(expected.rbegin(), expected.rend());
+    CheckPrevLinks(&tree, bpm);
+    EXPECT_EQ(ScanBackwards(&tree, nullptr), expected);
+
+    // from a key that is there, one that was removed, one that never was, and past either end
+    for (int64_t hi : {int64_t{-1}, int64_t{0}, int64_t{101}, int64_t{150}, int64_t{2000}, key_count + 1}) {
+      std::vector<int64_t> from_hi;
+      std::copy_if(expected.begin(), expected.end(), std::back_inserter(from_hi),
+                   [hi](int64_t key) { return key <= hi; });
+      EXPECT_EQ(ScanBackwards(&tree, &hi), from_hi) << hi;
+    }
+  }
+
+  // a bulk loaded tree is linked both ways as well
+  ScanTree bulk_tree("foo_pk", bpm, comparator, 8, 8);
+  int64_t next_key = 0;
+  bulk_tree.BulkLoad([&next_key](GenericKey<8> *key, RID *value) {
+    if (next_key == 1000) {
+      return false;
+    }
+    key->SetFromInteger(next_key);
+    *value = RID(0, next_key++);
+    return true;
+  });
+  CheckPrevLinks(&bulk_tree, bpm);
+  EXPECT_EQ(ScanBackwards(&bulk_tree, nullptr).size(), 1000);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeScanTest, ConcurrentReverseScanTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  for (auto mode : {BPlusTreeMode::LATCH_CRABBING, BPlusTreeMode::B_LINK}) {
+    // the even keys stay while writers insert odd ones around them, so leaves split under the reverse scans, which
+    // must still find every even key in descending order. B-link trees never merge or redistribute, so there the odd
+    // keys are removed and inserted again as well; with latch crabbing a key may move to a leaf the scan already left.
+    const int rounds = mode == BPlusTreeMode::B_LINK ? 3 : 1;
+    ScanTree tree("foo_pk", bpm, comparator, 8, 8, mode);
+    GenericKey<8> index_key;
+    const int64_t key_count = 2000;
+    for (int64_t key = 0; key < key_count; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+    std::atomic<int> writers_done{0};
+    std::vector<std::thread> threads;
+    for (int64_t thread = 0; thread < 2; thread++) {
+      threads.emplace_back([&tree, &writers_done, key_count, rounds, thread] {
+        GenericKey<8> key;
+        for (int round = 0; round < rounds; round++) {
+          for (int64_t odd = 1 + 2 * thread; odd < key_count; odd += 4) {
+            key.SetFromInteger(odd);
+            round % 2 == 0 ? static_cast<void>(tree.Insert(key, RID(0, odd))) : tree.Remove(key);
+          }
+        }
+        writers_done++;
+      });
+    }
+    threads.emplace_back([&tree, &writers_done, key_count] {
+      do {
+        int64_t evens = 0;
+        int64_t last = key_count;
+        for (auto key : ScanBackwards(&tree, nullptr)) {
+          EXPECT_LT(key, last);
+          last = key;
+          evens += key % 2 == 0 ? 1 : 0;
+        }
+        EXPECT_EQ(evens, key_count / 2);
+      } while (writers_done < 2);
+    });
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    CheckPrevLinks(&tree, bpm);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// the keys in [lo, hi) that ParallelScan finds, by sub-range, checking that each sub-range is sorted
+auto ScanInParallel(ScanTree *tree, const GenericKey<8> *lo, const GenericKey<8> *hi, int count)
+    -> std::vector<std::vector<int64_t>> {
+  std::vector<std::vector<int64_t>> parts(count);
+  std::atomic<int> workers{0};
+  tree->ParallelScan(lo, hi, count, [&parts, &workers](int part, ScanIterator *iterator) {
+    workers++;
+    for (; !iterator->IsEnd(); ++(*iterator)) {
+      parts[part].push_back((**iterator).second.GetSlotNum());
+    }
+  });
+  EXPECT_GE(workers, 1);
+  EXPECT_LE(workers, count);
+  parts.resize(workers);
+  return parts;
+}
+
+TEST(BPlusTreeScanTest, PartitionRangeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  for (auto mode : {BPlusTreeMode::LATCH_CRABBING, BPlusTreeMode::B_LINK}) {
+    ScanTree tree("foo_pk", bpm, comparator, 8, 8, mode);
+    GenericKey<8> index_key;
+    EXPECT_TRUE(tree.PartitionRange(nullptr, nullptr, 4).empty());
+    auto parts = ScanInParallel(&tree, nullptr, nullptr, 4);
+    EXPECT_EQ(parts, std::vector<std::vector<int64_t>>(1));
+
+    // a single leaf has no keys to split at
+    for (int64_t key = 0; key < 4; key++) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+    EXPECT_TRUE(tree.PartitionRange(nullptr, nullptr, 4).empty());
+    EXPECT_EQ(ScanInParallel(&tree, nullptr, nullptr, 4), std::vector<std::vector<int64_t>>({{0, 1, 2, 3}}));
+
+    // even keys in random order, so that the tree has a few levels
+    const int64_t key_count = 4000;
+    std::vector<int64_t> keys;
+    for (int64_t key = 4; key < key_count; key += 2) {
+      keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+
+    GenericKey<8> lo_key;
+    GenericKey<8> hi_key;
+    for (auto [lo, hi] : std::vector<std::pair<int64_t, int64_t>>{
+             {-1, key_count + 1}, {0, key_count}, {101, 3001}, {1000, 1003}, {3000, 100}, {key_count, key_count * 2}}) {
+      lo_key.SetFromInteger(lo);
+      hi_key.SetFromInteger(hi);
+      std::vector<int64_t> expected;
+      for (int64_t key = 0; key < key_count; key += key < 4 ? 1 : 2) {
+        if (key >= lo && key < hi) {
+          expected.push_back(key);
+        }
+      }
+      for (int count : {1, 2, 4, 16, 1000}) {
+        auto separators = tree.PartitionRange(&lo_key, &hi_key, count);
+        EXPECT_LE(separators.size(), count - 1);
+        for (size_t i = 0; i < separators.size(); i++) {
+          EXPECT_GT(separators[i].ToString(), i == 0 ? lo : separators[i - 1].ToString());
+          EXPECT_LT(separators[i].ToString(), hi);
+        }
+
+        parts = ScanInParallel(&tree, &lo_key, &hi_key, count);
+        EXPECT_EQ(parts.size(), separators.size() + 1);
+        std::vector<int64_t> found;
+        for (const auto &part : parts) {
+          found.insert(found.end(), part.begin(), part.end());
+        }
+        EXPECT_EQ(found, expected) << lo << " " << hi << " " << count;
+      }
+    }
+
+    // the whole tree splits into sub-ranges of about the same size
+    for (int count : {2, 4, 16}) {
+      auto separators = tree.PartitionRange(nullptr, nullptr, count);
+      EXPECT_EQ(separators.size(), count - 1);
+      parts = ScanInParallel(&tree, nullptr, nullptr, count);
+      for (const auto &part : parts) {
+        EXPECT_GT(part.size(), key_count / 2 / count / 4) << count;
+        EXPECT_LT(part.size(), key_count / 2 / count * 4) << count;
+      }
+    }
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
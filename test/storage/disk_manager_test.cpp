@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstring>
+#include <string>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -24,13 +25,21 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    RemoveLogSegments();
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    RemoveLogSegments();
   };
+
+  void RemoveLogSegments() {
+    for (int i = 0; i < 8; i++) {
+      remove(("test.log." + std::to_string(i)).c_str());
+    }
+  }
 };
 
 // NOLINTNEXTLINE
@@ -72,6 +81,50 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SegmentedLogTest) {
+  const log_offset_t segment_size = 64;
+  char data[2][100];
+  char buf[200] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, segment_size);
+  for (int i = 0; i < 100; i++) {
+    data[0][i] = static_cast<char>(i);
+    data[1][i] = static_cast<char>(100 + i);
+  }
+
+  // writes and reads cross segment boundaries
+  dm.WriteLog(data[0], sizeof(data[0]));
+  dm.WriteLog(data[1], sizeof(data[1]));
+  EXPECT_EQ(dm.GetLogEnd(), 200);
+  ASSERT_TRUE(dm.ReadLog(buf, 150, 50));
+  for (int i = 0; i < 150; i++) {
+    EXPECT_EQ(buf[i], static_cast<char>(50 + i));
+  }
+  EXPECT_FALSE(dm.ReadLog(buf, sizeof(buf), 200));
+
+  // only whole segments before the offset are dropped
+  dm.TruncateLog(130);
+  EXPECT_EQ(dm.GetLogStart(), 128);
+  EXPECT_FALSE(dm.ReadLog(buf, sizeof(buf), 100));
+  ASSERT_TRUE(dm.ReadLog(buf, sizeof(buf), 128));
+  EXPECT_EQ(buf[0], static_cast<char>(128));
+  EXPECT_EQ(buf[71], static_cast<char>(199));
+  EXPECT_EQ(buf[72], 0);
+  dm.ShutDown();
+
+  // the segments left behind are found again, so offsets stay stable across restarts
+  auto dm2 = DiskManager(db_file, segment_size);
+  EXPECT_EQ(dm2.GetLogStart(), 128);
+  EXPECT_EQ(dm2.GetLogEnd(), 200);
+  dm2.WriteLog(data[0], 10);
+  ASSERT_TRUE(dm2.ReadLog(buf, 20, 195));
+  EXPECT_EQ(buf[0], static_cast<char>(195));
+  EXPECT_EQ(buf[5], static_cast<char>(0));
+  EXPECT_EQ(buf[14], static_cast<char>(9));
+  dm2.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer_test.cpp
+//
+// Identification: test/storage/key_normalizer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cfloat>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/index/key_normalizer.h"
+#include "test_util.h"  // NOLINT
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+auto Sign(int result) -> int { return (result > 0) - (result < 0); }
+
+// three-way comparison of non-NULL values of the same type
+auto CompareValues(const Value &lhs, const Value &rhs) -> int {
+  if (lhs.CompareLessThan(rhs) == CmpBool::CmpTrue) {
+    return -1;
+  }
+  return lhs.CompareGreaterThan(rhs) == CmpBool::CmpTrue ? 1 : 0;
+}
+
+auto Normalize(const Value &value) -> std::vector<char> {
+  std::vector<char> data(64, 0);
+  size_t offset = 0;
+  KeyNormalizer::Encode(value, data.data(), data.size(), &offset);
+  data.resize(offset);
+  return data;
+}
+
+auto CompareNormalized(const std::vector<char> &lhs, const std::vector<char> &rhs) -> int {
+  int result = memcmp(lhs.data(), rhs.data(), std::min(lhs.size(), rhs.size()));
+  return result != 0 ? Sign(result) : Sign(static_cast<int>(lhs.size()) - static_cast<int>(rhs.size()));
+}
+
+// encoded values compare like the values and decode back to them
+void CheckOrder(const std::vector<Value> &values) {
+  for (const auto &lhs : values) {
+    auto data = Normalize(lhs);
+    size_t offset = 0;
+    Value decoded = KeyNormalizer::Decode(lhs.GetTypeId(), data.data(), data.size(), &offset);
+    EXPECT_EQ(offset, data.size());
+    EXPECT_EQ(decoded.CompareEquals(lhs), CmpBool::CmpTrue) << lhs.ToString();
+    for (const auto &rhs : values) {
+      EXPECT_EQ(CompareNormalized(data, Normalize(rhs)), CompareValues(lhs, rhs))
+          << lhs.ToString() << " vs " << rhs.ToString();
+    }
+  }
+}
+
+TEST(KeyNormalizerTest, OrderTest) {
+  std::mt19937_64 random(15445);
+
+  std::vector<Value> values;
+  for (int8_t i : {INT8_MIN + 1, -100, -1, 0, 1, 100, INT8_MAX}) {
+    values.emplace_back(TypeId::TINYINT, i);
+  }
+  CheckOrder(values);
+
+  values.clear();
+  for (int16_t i : {INT16_MIN + 1, -300, -1, 0, 1, 255, 256, INT16_MAX}) {
+    values.emplace_back(TypeId::SMALLINT, i);
+  }
+  CheckOrder(values);
+
+  values.clear();
+  for (int i = 0; i < 50; i++) {
+    values.emplace_back(TypeId::INTEGER, static_cast<int32_t>(random()));
+  }
+  values.emplace_back(TypeId::INTEGER, BUSTUB_INT32_MIN);
+  values.emplace_back(TypeId::INTEGER, BUSTUB_INT32_MAX);
+  CheckOrder(values);
+
+  values.clear();
+  for (int i = 0; i < 50; i++) {
+    values.emplace_back(TypeId::BIGINT, static_cast<int64_t>(random()));
+  }
+  values.emplace_back(TypeId::BIGINT, BUSTUB_INT64_MIN);
+  values.emplace_back(TypeId::BIGINT, BUSTUB_INT64_MAX);
+  CheckOrder(values);
+
+  values.clear();
+  std::uniform_real_distribution<double> decimals(-1e6, 1e6);
+  for (int i = 0; i < 50; i++) {
+    values.emplace_back(TypeId::DECIMAL, decimals(random));
+  }
+  for (double d : {-1e300, -1.0, -DBL_MIN, -0.0, 0.0, DBL_MIN, 1.0, DBL_MAX}) {
+    values.emplace_back(TypeId::DECIMAL, d);
+  }
+  CheckOrder(values);
+
+  // timestamps have no comparison functions, so their encodings are checked against the raw integers
+  std::vector<uint64_t> timestamps = {0, 1, 255, 256, BUSTUB_TIMESTAMP_NULL - 1};
+  for (auto lhs : timestamps) {
+    auto data = Normalize(Value(TypeId::TIMESTAMP, lhs));
+    size_t offset = 0;
+    EXPECT_EQ(KeyNormalizer::Decode(TypeId::TIMESTAMP, data.data(), data.size(), &offset).GetAs<uint64_t>(), lhs);
+    for (auto rhs : timestamps) {
+      EXPECT_EQ(CompareNormalized(data, Normalize(Value(TypeId::TIMESTAMP, rhs))), (lhs > rhs) - (lhs < rhs));
+    }
+  }
+
+  values.clear();
+  for (const char *s : {"", "a", "ab", "abc", "b", "ba", "\x7f", "\x80", "\xff"}) {
+    values.emplace_back(TypeId::VARCHAR, std::string(s));
+  }
+  // embedded null characters still order by the full string
+  values.emplace_back(TypeId::VARCHAR, std::string("a\0", 2));
+  values.emplace_back(TypeId::VARCHAR, std::string("a\0b", 3));
+  values.emplace_back(TypeId::VARCHAR, std::string("a\x01", 2));
+  CheckOrder(values);
+}
+
+TEST(KeyNormalizerTest, NullTest) {
+  // NULLs sort first and decode as NULL, except for timestamps where they sort last
+  for (auto type_id : {TypeId::BOOLEAN, TypeId::TINYINT, TypeId::SMALLINT, TypeId::INTEGER, TypeId::BIGINT,
+                       TypeId::DECIMAL, TypeId::VARCHAR}) {
+    Value null = ValueFactory::GetNullValueByType(type_id);
+    Value smallest = type_id == TypeId::BOOLEAN ? ValueFactory::GetBooleanValue(false) : Type::GetMinValue(type_id);
+    EXPECT_LT(CompareNormalized(Normalize(null), Normalize(smallest)), 0);
+    auto data = Normalize(null);
+    size_t offset = 0;
+    EXPECT_TRUE(KeyNormalizer::Decode(type_id, data.data(), data.size(), &offset).IsNull());
+  }
+  EXPECT_GT(CompareNormalized(Normalize(Value(TypeId::TIMESTAMP, BUSTUB_TIMESTAMP_NULL)),
+                              Normalize(Value(TypeId::TIMESTAMP, BUSTUB_TIMESTAMP_NULL - 1))),
+            0);
+}
+
+TEST(KeyNormalizerTest, GenericKeyTest) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(8),c double");
+  GenericComparator<32> comparator(key_schema.get());
+
+  // few distinct values per column, so that later columns decide many comparisons
+  std::mt19937 random(15445);
+  std::vector<std::string> strings = {"", "x", "xy", "xyz", "y"};
+  std::vector<std::vector<Value>> rows;
+  std::vector<GenericKey<32>> keys;
+  for (int i = 0; i < 100; i++) {
+    std::vector<Value> row = {Value(TypeId::INTEGER, static_cast<int32_t>(random() % 3) - 1),
+                              Value(TypeId::VARCHAR, strings[random() % strings.size()]),
+                              Value(TypeId::DECIMAL, static_cast<double>(random() % 5) - 2.5)};
+    GenericKey<32> key;
+    key.SetFromKey(Tuple(row, key_schema.get()), key_schema.get());
+    for (uint32_t column = 0; column < row.size(); column++) {
+      EXPECT_EQ(key.ToValue(key_schema.get(), column).CompareEquals(row[column]), CmpBool::CmpTrue);
+    }
+    rows.push_back(row);
+    keys.push_back(key);
+  }
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    for (size_t j = 0; j < rows.size(); j++) {
+      int expected = 0;
+      for (uint32_t column = 0; column < rows[i].size() && expected == 0; column++) {
+        expected = CompareValues(rows[i][column], rows[j][column]);
+      }
+      EXPECT_EQ(Sign(comparator(keys[i], keys[j])), expected);
+    }
+  }
+
+  // a key that does not fit is cut short, keeping the order of the columns that do fit
+  GenericKey<8> short_key;
+  std::vector<Value> row = {Value(TypeId::INTEGER, 7), Value(TypeId::VARCHAR, std::string("longer than the key")),
+                            Value(TypeId::DECIMAL, 1.0)};
+  short_key.SetFromKey(Tuple(row, key_schema.get()), key_schema.get());
+  EXPECT_EQ(short_key.ToValue(key_schema.get(), 0).GetAs<int32_t>(), 7);
+  EXPECT_EQ(short_key.ToValue(key_schema.get(), 1).ToString(), "lon");
+}
+
+}  // namespace bustub
@@ -0,0 +1,245 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// posting_list_test.cpp
+//
+// Identification: test/storage/posting_list_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/adaptive_radix_tree_index.h"
+#include "storage/index/b_epsilon_tree_index.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/extendible_hash_table_index.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+// the RIDs of key must be expected, in order
+void CheckKey(Index *index, const Schema *schema, int64_t key, const std::set<int64_t> &expected) {
+  std::vector<RID> rids;
+  index->ScanKey(Tuple({Value(TypeId::BIGINT, key)}, schema), &rids, nullptr);
+  ASSERT_EQ(rids.size(), expected.size()) << key;
+  size_t i = 0;
+  for (auto rid : expected) {
+    EXPECT_EQ(rids[i++].Get(), rid) << key;
+  }
+}
+
+// a key with many RIDs over several pages, a key with one and a key with two, with RIDs inserted in random order and
+// some of them twice, then removed again in part
+void CheckNonUniqueIndex(Index *index, const Schema *schema) {
+  std::mt19937 random(15445);
+  std::vector<std::set<int64_t>> expected(3);
+  std::vector<RID> rids;
+  for (int i = 0; i < 10000; i++) {
+    rids.emplace_back(i / 50, i % 50);
+  }
+  rids.emplace_back(1 << 30, 7);
+  std::shuffle(rids.begin(), rids.end(), random);
+  for (const auto &rid : rids) {
+    index->InsertEntry(Tuple({Value(TypeId::BIGINT, int64_t{0})}, schema), rid, nullptr);
+    expected[0].insert(rid.Get());
+  }
+  for (const auto &rid : {RID(5, 5), RID(5, 5), RID(3, 1)}) {
+    index->InsertEntry(Tuple({Value(TypeId::BIGINT, int64_t{2})}, schema), rid, nullptr);
+    expected[2].insert(rid.Get());
+  }
+  index->InsertEntry(Tuple({Value(TypeId::BIGINT, int64_t{1})}, schema), RID(9, 9), nullptr);
+  index->InsertEntry(Tuple({Value(TypeId::BIGINT, int64_t{1})}, schema), RID(9, 9), nullptr);
+  expected[1].insert(RID(9, 9).Get());
+  for (int64_t key = 0; key < 3; key++) {
+    CheckKey(index, schema, key, expected[key]);
+  }
+  CheckKey(index, schema, 3, {});
+
+  // remove every RID of the first key that is not on an even table page, and some that are not there at all
+  std::shuffle(rids.begin(), rids.end(), random);
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() % 2 == 1) {
+      index->DeleteEntry(Tuple({Value(TypeId::BIGINT, int64_t{0})}, schema), rid, nullptr);
+      expected[0].erase(rid.Get());
+    }
+  }
+  index->DeleteEntry(Tuple({Value(TypeId::BIGINT, int64_t{0})}, schema), RID(100000, 1), nullptr);
+  index->DeleteEntry(Tuple({Value(TypeId::BIGINT, int64_t{1})}, schema), RID(9, 8), nullptr);
+  CheckKey(index, schema, 0, expected[0]);
+  CheckKey(index, schema, 1, expected[1]);
+
+  // emptied keys go away and can come back
+  for (int64_t key = 1; key < 3; key++) {
+    for (auto rid : expected[key]) {
+      index->DeleteEntry(Tuple({Value(TypeId::BIGINT, key)}, schema), RID(rid), nullptr);
+    }
+    CheckKey(index, schema, key, {});
+  }
+  index->InsertEntry(Tuple({Value(TypeId::BIGINT, int64_t{2})}, schema), RID(4, 4), nullptr);
+  CheckKey(index, schema, 2, {RID(4, 4).Get()});
+  for (auto rid : expected[0]) {
+    index->DeleteEntry(Tuple({Value(TypeId::BIGINT, int64_t{0})}, schema), RID(rid), nullptr);
+  }
+  CheckKey(index, schema, 0, {});
+}
+
+TEST(PostingListTest, PageTest) {
+  // RIDs a slot apart take a byte each, and the RIDs that do not fit are left out
+  std::vector<char> data(PAGE_SIZE);
+  auto page = reinterpret_cast<PostingListPage *>(data.data());
+  page->Init();
+  std::vector<RID> rids;
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    rids.emplace_back(i / 100, i % 100);
+  }
+  int stored = page->SetRids(rids.data(), static_cast<int>(rids.size()));
+  EXPECT_GT(stored, PAGE_SIZE - POSTING_LIST_PAGE_HEADER_SIZE - 200);
+  EXPECT_LT(stored, static_cast<int>(rids.size()));
+  EXPECT_EQ(page->GetLastRid().Get(), rids[stored - 1].Get());
+  std::vector<RID> decoded;
+  page->GetRids(&decoded);
+  ASSERT_EQ(decoded.size(), stored);
+  for (int i = 0; i < stored; i++) {
+    EXPECT_EQ(decoded[i].Get(), rids[i].Get());
+  }
+}
+
+TEST(PostingListTest, BPlusTreeIndexTest) {
+  auto schema = ParseCreateStatement("a bigint");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      std::make_unique<IndexMetadata>("foo_idx", "foo", schema.get(), std::vector<uint32_t>{0}, false), bpm);
+  CheckNonUniqueIndex(&index, schema.get());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(PostingListTest, BEpsilonTreeIndexTest) {
+  auto schema = ParseCreateStatement("a bigint");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  BEpsilonTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      std::make_unique<IndexMetadata>("foo_idx", "foo", schema.get(), std::vector<uint32_t>{0}, false), bpm);
+  CheckNonUniqueIndex(&index, schema.get());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(PostingListTest, AdaptiveRadixTreeIndexTest) {
+  auto schema = ParseCreateStatement("a bigint");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+
+  AdaptiveRadixTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      std::make_unique<IndexMetadata>("foo_idx", "foo", schema.get(), std::vector<uint32_t>{0}, false), bpm);
+  CheckNonUniqueIndex(&index, schema.get());
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(PostingListTest, HashTableIndexTest) {
+  auto schema = ParseCreateStatement("a bigint");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      std::make_unique<IndexMetadata>("foo_idx", "foo", schema.get(), std::vector<uint32_t>{0}, false), bpm,
+      HashFunction<GenericKey<8>>());
+  CheckNonUniqueIndex(&index, schema.get());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(PostingListTest, ConcurrentTest) {
+  auto schema = ParseCreateStatement("a bigint");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(
+      std::make_unique<IndexMetadata>("foo_idx", "foo", schema.get(), std::vector<uint32_t>{0}, false), bpm);
+
+  // every thread adds its own RIDs to a few shared keys and takes every other one out again, while readers scan
+  const int num_threads = 4;
+  const int rids_per_thread = 2000;
+  const int64_t num_keys = 3;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      for (int i = 0; i < rids_per_thread; i++) {
+        index.InsertEntry(Tuple({Value(TypeId::BIGINT, i % num_keys)}, schema.get()), RID(thread, i), nullptr);
+        if (i % 2 == 1) {
+          index.DeleteEntry(Tuple({Value(TypeId::BIGINT, (i - 1) % num_keys)}, schema.get()), RID(thread, i - 1),
+                            nullptr);
+        }
+      }
+    });
+    threads.emplace_back([&] {
+      for (int i = 0; i < 200; i++) {
+        std::vector<RID> rids;
+        index.ScanKey(Tuple({Value(TypeId::BIGINT, i % num_keys)}, schema.get()), &rids, nullptr);
+        EXPECT_TRUE(std::is_sorted(rids.begin(), rids.end(), [](const RID &lhs, const RID &rhs) {
+          return lhs.Get() < rhs.Get();
+        }));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::set<int64_t> expected;
+    for (int thread = 0; thread < num_threads; thread++) {
+      for (int i = 1; i < rids_per_thread; i += 2) {
+        if (i % num_keys == key) {
+          expected.insert(RID(thread, i).Get());
+        }
+      }
+    }
+    CheckKey(&index, schema.get(), key, expected);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub